@@ -0,0 +1,420 @@
+// aether_bench.cpp
+// Hot-path microbenchmark suite: frame decode, price parsing, book snapshot/apply,
+// EventQueue hand-off between threads and ring publishing (with and without
+// wrap-around). Every case runs a fixed workload `repeats` times after one warm-up
+// run; the median and the best run are reported per operation.
+//
+// usage: aether_bench [--frames=RECORDING] [--filter=SUBSTR] [--repeats=N] [--quick]
+//                     [--format=table|json|csv] [--label=TEXT] [--seed=N]
+//                     [--baseline=RESULTS.json] [--threshold=PCT]
+//   --frames     recorded WS frames (text recording, capture file or one frame per
+//                line); synthetic Binance-shaped frames if omitted
+//   --baseline   compare medians with an earlier --format=json run; exits 1 if any
+//                case is more than --threshold percent (default 10) slower
+
+#include "bench_common.h"
+#include "aether_frame.h"
+#include "depth_decoder.h"
+#include "event_queue.h"
+#include "feed_source.h"
+#include "orderbook.h"
+#include "replay_feed.h"
+#include "ring_mmap.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+using namespace aether;
+using namespace aether::bench;
+
+namespace {
+
+  struct Data {
+    std::string source = "synthetic";
+    std::vector<std::string> frames;
+    size_t frame_bytes = 0;
+    std::vector<std::string> decimals;   // every price/qty string of the frames
+    std::vector<DepthDelta> deltas;      // decoded frames, renumbered without gaps
+    json snapshot;
+    DecimalScale scale;
+  };
+
+  // one timed run of a case
+  struct Run {
+    uint64_t ops = 0;
+    uint64_t bytes = 0;   // input bytes processed (0 when not meaningful)
+    uint64_t ns = 0;
+  };
+
+  struct Case {
+    std::string name;
+    std::function<Run(const Data &)> fn;
+  };
+
+  struct Result {
+    std::string name;
+    uint64_t ops = 0;
+    double ns_median = 0;   // per op
+    double ns_min = 0;
+    double mb_per_s = 0;    // at the median
+  };
+
+  // all "..." strings inside the b/a arrays of a frame
+  void collect_decimals(const std::string &f, std::vector<std::string> &out) {
+    size_t b = f.find("\"b\":[");
+    if (b == std::string::npos) return;
+    size_t i = b;
+    while ((i = f.find("[\"", i)) != std::string::npos) {
+      for (int k = 0; k < 2; ++k) {
+        size_t s = f.find('"', i) + 1;
+        size_t e = f.find('"', s);
+        if (s == 0 || e == std::string::npos) return;
+        out.push_back(f.substr(s, e - s));
+        i = e + 1;
+      }
+    }
+  }
+
+  // snapshot around the first delta when the recording has none
+  json synthetic_snapshot(const DepthDelta &first, int levels, uint64_t last_id, const DecimalScale &sc) {
+    int64_t mid = !first.bids.empty() ? first.bids[0].price : !first.asks.empty() ? first.asks[0].price : 6500000;
+    int64_t step = 1;
+    for (int i = 0; i < sc.price_decimals - 2; ++i) step *= 10; // cent grid
+    json s;
+    s["lastUpdateId"] = last_id;
+    s["bids"] = json::array();
+    s["asks"] = json::array();
+    for (int i = 1; i <= levels; ++i) {
+      s["bids"].push_back({fmt_fixed(mid - i * step, sc.price_decimals), fmt_fixed(1000 + i, sc.qty_decimals)});
+      s["asks"].push_back({fmt_fixed(mid + i * step, sc.price_decimals), fmt_fixed(1000 + i, sc.qty_decimals)});
+    }
+    return s;
+  }
+
+  bool load_data(const std::string &path, size_t synthetic_count, uint32_t seed, Data &d) {
+    std::string snapshot_body;
+    if (path.empty()) {
+      d.frames = synthetic_frames(synthetic_count, 20, seed);
+      d.scale.price_decimals = 2;
+      d.scale.qty_decimals = 8;
+    } else {
+      std::vector<FeedRecord> recs;
+      if (!load_feed(path, recs)) return false;
+      d.source = path;
+      for (auto &r : recs) {
+        if (r.kind == FeedRecord::WsFrame) d.frames.push_back(std::move(r.body));
+        else if (r.kind == FeedRecord::Snapshot && snapshot_body.empty()) snapshot_body = std::move(r.body);
+        else if (r.kind == FeedRecord::ExchangeInfo) scale_from_exchange_info(r.body, d.scale);
+      }
+    }
+    if (d.frames.empty()) return false;
+
+    DepthDelta tmp;
+    for (const auto &f : d.frames) {
+      d.frame_bytes += f.size();
+      collect_decimals(f, d.decimals);
+      if (decode_depth_update(f.data(), f.size(), tmp, d.scale) == DecodeStatus::Ok) d.deltas.push_back(tmp);
+    }
+    if (d.deltas.empty()) return false;
+    // contiguous ids so applyEvent never sees a gap, whatever the recording had
+    uint64_t base = 1000000;
+    for (size_t i = 0; i < d.deltas.size(); ++i)
+      d.deltas[i].first_update_id = d.deltas[i].final_update_id = base + 1 + i;
+    d.snapshot = snapshot_body.empty() ? synthetic_snapshot(d.deltas[0], 5000, base, d.scale)
+      : json::parse(snapshot_body);
+    d.snapshot["lastUpdateId"] = base;
+    return true;
+  }
+
+  // -- cases ----------------------------------------------------------------
+
+  Run bench_json_dom(const Data &d) {
+    Run r;
+    uint64_t t0 = now_ns();
+    for (const auto &f : d.frames) {
+      json j = json::parse(f, nullptr, false);
+      do_not_optimize(j.size());
+    }
+    r.ns = now_ns() - t0;
+    r.ops = d.frames.size();
+    r.bytes = d.frame_bytes;
+    return r;
+  }
+
+  Run bench_decode(const Data &d) {
+    DepthDelta out;
+    out.bids.reserve(1024);
+    out.asks.reserve(1024);
+    Run r;
+    uint64_t t0 = now_ns();
+    for (const auto &f : d.frames) {
+      decode_depth_update(f.data(), f.size(), out, d.scale);
+      do_not_optimize(out.final_update_id);
+    }
+    r.ns = now_ns() - t0;
+    r.ops = d.frames.size();
+    r.bytes = d.frame_bytes;
+    return r;
+  }
+
+  Run bench_parse_decimal(const Data &d) {
+    Run r;
+    int64_t v = 0, sum = 0;
+    uint64_t t0 = now_ns();
+    for (const auto &s : d.decimals) {
+      parse_decimal(s.data(), s.data() + s.size(), 8, v);
+      sum += v;
+    }
+    r.ns = now_ns() - t0;
+    do_not_optimize(sum);
+    r.ops = d.decimals.size();
+    for (const auto &s : d.decimals) r.bytes += s.size();
+    return r;
+  }
+
+  Run bench_strtod(const Data &d) {
+    Run r;
+    double sum = 0;
+    uint64_t t0 = now_ns();
+    for (const auto &s : d.decimals) sum += std::strtod(s.c_str(), nullptr);
+    r.ns = now_ns() - t0;
+    do_not_optimize(sum);
+    r.ops = d.decimals.size();
+    for (const auto &s : d.decimals) r.bytes += s.size();
+    return r;
+  }
+
+  template <class Book>
+  Run bench_snapshot(const Data &d) {
+    Run r;
+    const int reps = 5;
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < reps; ++i) {
+      Book book(d.scale);
+      book.setFromSnapshot(d.snapshot);
+      do_not_optimize(book.totalLevels());
+    }
+    r.ns = now_ns() - t0;
+    r.ops = reps;
+    return r;
+  }
+
+  template <class Book>
+  Run bench_apply(const Data &d) {
+    Book book(d.scale);
+    book.setFromSnapshot(d.snapshot);
+    Run r;
+    uint64_t t0 = now_ns();
+    for (const auto &delta : d.deltas) book.applyEvent(delta);
+    r.ns = now_ns() - t0;
+    do_not_optimize(book.lastUpdateId());
+    r.ops = d.deltas.size();
+    return r;
+  }
+
+  // producer thread -> consumer (this thread), DepthEvents carrying real deltas
+  Run bench_queue_threads(const Data &d) {
+    const size_t n = std::max<size_t>(200000, d.deltas.size());
+    EventQueue q(4096);
+    Run r;
+    uint64_t t0 = now_ns();
+    std::thread producer([&] {
+        for (size_t i = 0; i < n; ++i) {
+          DepthEvent *ev;
+          while (!(ev = q.try_claim())) std::this_thread::yield();
+          const DepthDelta &src = d.deltas[i % d.deltas.size()];
+          ev->delta.first_update_id = src.first_update_id;
+          ev->delta.final_update_id = src.final_update_id;
+          ev->delta.bids.assign(src.bids.begin(), src.bids.end());
+          ev->delta.asks.assign(src.asks.begin(), src.asks.end());
+          ev->end_of_stream = false;
+          q.publish();
+        }
+    });
+    size_t got = 0;
+    uint64_t sum = 0;
+    while (got < n) {
+      got += q.pop_n_blocking([&](DepthEvent &ev) { sum += ev.delta.bids.size(); return true; }, 256);
+    }
+    producer.join();
+    r.ns = now_ns() - t0;
+    do_not_optimize(sum);
+    r.ops = n;
+    return r;
+  }
+
+  // publish_message of fixed-size payloads; ring_bytes small enough forces wrap-around
+  Run bench_ring(size_t payload, size_t ring_bytes, size_t frames) {
+    std::string path = "/dev/shm/aether_bench." + std::to_string(::getpid()) + ".ring";
+    ring::RingHandle *h = ring::create_ring(path.c_str(), ring_bytes);
+    Run r;
+    if (!h) {
+      std::cerr << "[bench] create_ring " << path << " failed\n";
+      return r;
+    }
+    std::vector<uint8_t> buf(payload, 0xab);
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < frames; ++i) {
+      std::memcpy(buf.data(), &i, sizeof(i));
+      ring::publish_message(h, AETHER_MSG_DEPTH_UPDATE, buf.data(), buf.size());
+    }
+    r.ns = now_ns() - t0;
+    ring::close_ring(h);
+    ::unlink(path.c_str());
+    r.ops = frames;
+    r.bytes = frames * payload;
+    return r;
+  }
+
+  std::vector<Case> make_cases(bool quick) {
+    std::vector<Case> cs;
+    cs.push_back({"decode/json_dom", bench_json_dom});
+    cs.push_back({"decode/depth_update", bench_decode});
+    cs.push_back({"decimal/parse_decimal", bench_parse_decimal});
+    cs.push_back({"decimal/strtod", bench_strtod});
+    cs.push_back({"book/snapshot_map", bench_snapshot<OrderBook>});
+    cs.push_back({"book/snapshot_ladder", bench_snapshot<LadderOrderBook>});
+    cs.push_back({"book/apply_map", bench_apply<OrderBook>});
+    cs.push_back({"book/apply_ladder", bench_apply<LadderOrderBook>});
+    cs.push_back({"queue/spsc_2threads", bench_queue_threads});
+    size_t frames = quick ? 20000 : 200000;
+    for (size_t sz : {64, 256, 1024, 4096}) {
+      // first lap of a fresh ring that holds the whole run: includes first-touch page faults
+      size_t big = (frames * (sz + 64) + (1 << 20)) & ~size_t(4095);
+      cs.push_back({"ring/publish_first_lap_" + std::to_string(sz),
+          [=](const Data &) { return bench_ring(sz, big, frames); }});
+      // steady state: 64KB ring, wrapping and evicting every few dozen frames
+      cs.push_back({"ring/publish_wrap_" + std::to_string(sz),
+          [=](const Data &) { return bench_ring(sz, 64 << 10, frames); }});
+    }
+    return cs;
+  }
+
+  Result measure(const Case &c, const Data &d, int repeats) {
+    c.fn(d); // warm-up: caches, page faults, allocator
+    std::vector<Run> runs;
+    for (int i = 0; i < repeats; ++i) runs.push_back(c.fn(d));
+    std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) { return a.ns < b.ns; });
+    const Run &med = runs[runs.size() / 2];
+    Result res;
+    res.name = c.name;
+    res.ops = med.ops;
+    if (med.ops) {
+      res.ns_median = double(med.ns) / double(med.ops);
+      res.ns_min = double(runs.front().ns) / double(runs.front().ops);
+    }
+    if (med.bytes && med.ns) res.mb_per_s = double(med.bytes) / (double(med.ns) / 1e9) / 1e6;
+    return res;
+  }
+
+  // 0 if no case regressed beyond threshold_pct against the baseline file
+  int compare_baseline(const std::string &path, const std::vector<Result> &results, double threshold_pct) {
+    std::ifstream in(path);
+    json base = json::parse(in, nullptr, false);
+    if (base.is_discarded() || !base.contains("results")) {
+      std::cerr << "[bench] cannot read baseline " << path << "\n";
+      return 2;
+    }
+    int regressions = 0;
+    for (const auto &r : results) {
+      for (const auto &b : base["results"]) {
+        if (b.value("name", "") != r.name) continue;
+        double old_ns = b.value("ns_per_op_median", 0.0);
+        if (old_ns <= 0) break;
+        double pct = (r.ns_median - old_ns) / old_ns * 100.0;
+        bool bad = pct > threshold_pct;
+        regressions += bad;
+        std::fprintf(stderr, "%-28s %10.2f -> %10.2f ns/op  %+7.1f%%%s\n", r.name.c_str(), old_ns,
+            r.ns_median, pct, bad ? "  REGRESSION" : "");
+        break;
+      }
+    }
+    return regressions ? 1 : 0;
+  }
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string frames_path, filter, format = "table", label, baseline;
+  int repeats = 5;
+  bool quick = false;
+  uint32_t seed = 42;
+  double threshold = 10.0;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    auto val = [&](const char *p) { return a.substr(std::strlen(p)); };
+    if (a.rfind("--frames=", 0) == 0) frames_path = val("--frames=");
+    else if (a.rfind("--filter=", 0) == 0) filter = val("--filter=");
+    else if (a.rfind("--repeats=", 0) == 0) repeats = std::max(1, std::atoi(val("--repeats=").c_str()));
+    else if (a.rfind("--format=", 0) == 0) format = val("--format=");
+    else if (a.rfind("--label=", 0) == 0) label = val("--label=");
+    else if (a.rfind("--seed=", 0) == 0) seed = uint32_t(std::stoul(val("--seed=")));
+    else if (a.rfind("--baseline=", 0) == 0) baseline = val("--baseline=");
+    else if (a.rfind("--threshold=", 0) == 0) threshold = std::stod(val("--threshold="));
+    else if (a == "--quick") quick = true;
+    else {
+      std::cerr << "usage: " << argv[0] << " [--frames=RECORDING] [--filter=SUBSTR] [--repeats=N] [--quick]"
+        << " [--format=table|json|csv] [--label=TEXT] [--seed=N] [--baseline=FILE] [--threshold=PCT]\n";
+      return 1;
+    }
+  }
+  if (format != "table" && format != "json" && format != "csv") {
+    std::cerr << "[bench] --format must be table, json or csv\n";
+    return 1;
+  }
+
+  Data data;
+  if (!load_data(frames_path, quick ? 2000 : 20000, seed, data)) {
+    std::cerr << "[bench] no usable frames in " << (frames_path.empty() ? "synthetic set" : frames_path) << "\n";
+    return 1;
+  }
+  std::cerr << "[bench] " << data.source << ": " << data.frames.size() << " frames, " << data.deltas.size()
+    << " decoded, " << data.decimals.size() << " decimals, snapshot levels="
+    << data.snapshot["bids"].size() + data.snapshot["asks"].size() << ", repeats=" << repeats << "\n";
+
+  std::vector<Result> results;
+  for (const Case &c : make_cases(quick)) {
+    if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+    results.push_back(measure(c, data, repeats));
+    const Result &r = results.back();
+    if (format == "table") {
+      std::printf("%-28s %12.2f ns/op (min %10.2f) %12.0f ops/s", r.name.c_str(), r.ns_median, r.ns_min,
+          r.ns_median > 0 ? 1e9 / r.ns_median : 0.0);
+      if (r.mb_per_s > 0) std::printf(" %9.1f MB/s", r.mb_per_s);
+      std::printf("\n");
+      std::fflush(stdout);
+    }
+  }
+
+  if (format == "json") {
+    json out;
+    out["schema"] = 1;
+    out["label"] = label;
+    out["source"] = data.source;
+    out["seed"] = seed;
+    out["repeats"] = repeats;
+    out["quick"] = quick;
+    out["compiler"] = __VERSION__;
+    out["results"] = json::array();
+    for (const auto &r : results) {
+      out["results"].push_back({{"name", r.name}, {"ops", r.ops}, {"ns_per_op_median", r.ns_median},
+          {"ns_per_op_min", r.ns_min}, {"mb_per_s", r.mb_per_s}});
+    }
+    std::cout << out.dump(2) << "\n";
+  } else if (format == "csv") {
+    std::cout << "name,ops,ns_per_op_median,ns_per_op_min,mb_per_s,label\n";
+    for (const auto &r : results)
+      std::cout << r.name << "," << r.ops << "," << r.ns_median << "," << r.ns_min << "," << r.mb_per_s << "," << label << "\n";
+  }
+
+  if (!baseline.empty()) return compare_baseline(baseline, results, threshold);
+  return 0;
+}
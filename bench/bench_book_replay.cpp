@@ -0,0 +1,119 @@
+// bench_book_replay.cpp
+// Replays one snapshot + depth diff stream against the std::map book and the
+// tick-ladder book, checks they agree, and reports time and heap allocations.
+// usage: bench_book_replay [snapshot_levels] [events] [levels_per_event]
+
+#include "bench_common.h"
+#include "orderbook.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using json = nlohmann::json;
+using namespace aether;
+using namespace aether::bench;
+
+// count every heap allocation made while a book is being fed
+static std::atomic<uint64_t> g_allocs{0};
+void* operator new(size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+struct Stream {
+  json snapshot;
+  std::vector<DepthDelta> deltas;
+};
+
+// BTCUSDT-like: tick 0.01, qty step 1e-5, mid random walk, most updates near the touch
+static Stream make_stream(int snapshot_levels, size_t events, int levels_per_event) {
+  std::mt19937_64 rng(7);
+  Stream s;
+  int64_t mid = 6500000; // 65000.00
+  uint64_t id = 5000000;
+  s.snapshot["lastUpdateId"] = id;
+  s.snapshot["bids"] = json::array();
+  s.snapshot["asks"] = json::array();
+  for (int i = 1; i <= snapshot_levels; ++i) {
+    int64_t q = 1 + int64_t(rng() % 200000);
+    s.snapshot["bids"].push_back({fmt_fixed(mid - i, 2), fmt_fixed(q, 5)});
+    s.snapshot["asks"].push_back({fmt_fixed(mid + i, 2), fmt_fixed(q, 5)});
+  }
+  s.deltas.resize(events);
+  for (auto &d : s.deltas) {
+    mid += int64_t(rng() % 9) - 4;
+    d.first_update_id = id + 1;
+    d.final_update_id = id + 1 + rng() % 10;
+    id = d.final_update_id;
+    for (int l = 0; l < levels_per_event; ++l) {
+      // geometric-ish distance from the touch
+      int64_t off = 1 + int64_t(rng() % 16) * int64_t(1 + rng() % (rng() % 8 == 0 ? 400 : 4));
+      int64_t q = rng() % 3 == 0 ? 0 : 1 + int64_t(rng() % 200000);
+      if (l & 1) d.asks.push_back(Level{mid + off, q});
+      else d.bids.push_back(Level{mid - off, q});
+    }
+  }
+  return s;
+}
+
+template <class Book>
+static bool replay(const char *name, const Stream &s, const DecimalScale &sc, std::vector<Level> &top_out) {
+  Book book(sc);
+  uint64_t t0 = now_ns();
+  uint64_t a0 = g_allocs.load();
+  book.setFromSnapshot(s.snapshot);
+  uint64_t t1 = now_ns();
+  uint64_t a1 = g_allocs.load();
+  for (const auto &d : s.deltas) {
+    if (!book.applyEvent(d)) return false;
+  }
+  uint64_t t2 = now_ns();
+  uint64_t a2 = g_allocs.load();
+
+  PriceT bp = 0, ap = 0; SizeT bq = 0, aq = 0;
+  book.bestBid(bp, bq);
+  book.bestAsk(ap, aq);
+  do_not_optimize(bp + ap);
+  std::cout << name << ": snapshot " << (t1 - t0) / 1000 << " us (" << (a1 - a0) << " allocs), "
+    << s.deltas.size() << " diffs " << double(t2 - t1) / double(s.deltas.size()) << " ns/diff ("
+    << (a2 - a1) << " allocs), levels=" << book.totalLevels() << "\n";
+
+  top_out.clear();
+  book.forEachBid([&](PriceT p, SizeT q) { top_out.push_back(Level{p, q}); return true; });
+  book.forEachAsk([&](PriceT p, SizeT q) { top_out.push_back(Level{p, q}); return true; });
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int snapshot_levels = argc >= 2 ? std::atoi(argv[1]) : 5000;
+  size_t events = argc >= 3 ? size_t(std::atoll(argv[2])) : 200000;
+  int per_event = argc >= 4 ? std::atoi(argv[3]) : 40;
+
+  DecimalScale sc;
+  sc.price_decimals = 2;
+  sc.qty_decimals = 5;
+  Stream s = make_stream(snapshot_levels, events, per_event);
+
+  std::vector<Level> map_levels, ladder_levels;
+  map_levels.reserve(4 * size_t(snapshot_levels) + 4096);
+  ladder_levels.reserve(4 * size_t(snapshot_levels) + 4096);
+  if (!replay<OrderBook>("map   ", s, sc, map_levels)) return 2;
+  if (!replay<LadderOrderBook>("ladder", s, sc, ladder_levels)) return 2;
+
+  if (map_levels.size() != ladder_levels.size()) {
+    std::cerr << "[bench] books disagree on level count\n";
+    return 3;
+  }
+  for (size_t i = 0; i < map_levels.size(); ++i) {
+    if (map_levels[i].price != ladder_levels[i].price || map_levels[i].qty != ladder_levels[i].qty) {
+      std::cerr << "[bench] books disagree at level " << i << "\n";
+      return 3;
+    }
+  }
+  std::cout << "books agree on all " << map_levels.size() << " levels\n";
+  return 0;
+}
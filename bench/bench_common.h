@@ -0,0 +1,81 @@
+#pragma once
+// bench_common.h
+// small helpers shared by the microbenchmarks (timing, frame loading, synthetic frames)
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace aether { namespace bench {
+
+  inline uint64_t now_ns() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  // keep the optimizer from discarding a result
+  template <class T>
+  inline void do_not_optimize(T const &v) {
+    asm volatile("" : : "r,m"(v) : "memory");
+  }
+
+  // one raw WS frame per line (as captured from the depth stream)
+  inline std::vector<std::string> load_frames(const std::string &path) {
+    std::vector<std::string> frames;
+    std::ifstream in(path);
+    if (!in) {
+      std::cerr << "[bench] cannot open " << path << "\n";
+      return frames;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) frames.push_back(line);
+    }
+    return frames;
+  }
+
+  inline std::string fmt_fixed(int64_t v, int decimals) {
+    std::string s = std::to_string(v);
+    if (decimals == 0) return s;
+    while ((int)s.size() <= decimals) s.insert(s.begin(), '0');
+    s.insert(s.end() - decimals, '.');
+    return s;
+  }
+
+  // depthUpdate frames shaped like Binance's: random walk mid, 8-decimal strings
+  inline std::vector<std::string> synthetic_frames(size_t count, int levels_per_side, uint32_t seed = 42) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> frames;
+    frames.reserve(count);
+    int64_t mid = 6500000;   // 65000.00 in cents
+    uint64_t U = 1000000;
+    uint64_t E = 1700000000000ULL;
+    for (size_t i = 0; i < count; ++i) {
+      mid += int64_t(rng() % 21) - 10;
+      uint64_t u = U + 1 + rng() % 8;
+      std::string f;
+      f.reserve(64 + levels_per_side * 2 * 40);
+      f += "{\"e\":\"depthUpdate\",\"E\":" + std::to_string(E) + ",\"s\":\"BTCUSDT\",\"U\":" +
+        std::to_string(U) + ",\"u\":" + std::to_string(u) + ",\"b\":[";
+      for (int side = 0; side < 2; ++side) {
+        for (int l = 0; l < levels_per_side; ++l) {
+          int64_t off = 1 + int64_t(rng() % 400);
+          int64_t px = side == 0 ? mid - off : mid + off;
+          int64_t qty = (rng() % 4 == 0) ? 0 : int64_t(rng() % 500000000);
+          if (l) f += ',';
+          f += "[\"" + fmt_fixed(px, 2) + "000000\",\"" + fmt_fixed(qty, 8) + "\"]";
+        }
+        f += side == 0 ? "],\"a\":[" : "]}";
+      }
+      frames.push_back(std::move(f));
+      U = u + 1;
+      E += 100;
+    }
+    return frames;
+  }
+
+}} // namespace aether::bench
@@ -0,0 +1,87 @@
+// bench_depth_decode.cpp
+// Compares the streaming DepthDelta decoder against the old json::parse path.
+// usage: bench_depth_decode [frames.jsonl] [iterations]
+//   frames.jsonl: one recorded depthUpdate frame per line (synthetic frames if omitted)
+
+#include "bench_common.h"
+#include "depth_decoder.h"
+
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+using namespace aether;
+using namespace aether::bench;
+
+static constexpr double OLD_PRICE_SCALE = 1e8; // the old global scale
+
+// what the WS reader + OrderBook used to do per frame: string copy, DOM build,
+// key lookups by string and stod-based scaling of every level
+static bool old_json_path(const std::string &frame, DepthDelta &out) {
+  out.clear();
+  std::string msg(frame.data(), frame.size());
+  json j = json::parse(msg);
+  if (!(j.contains("e") && j["e"] == "depthUpdate")) return false;
+  out.first_update_id = j.at("U").get<uint64_t>();
+  out.final_update_id = j.at("u").get<uint64_t>();
+  out.event_time_ms = j.at("E").get<uint64_t>();
+  for (const auto &lvl : j.at("b")) {
+    out.bids.push_back(Level{
+        (PriceT)llround(std::stod(lvl.at(0).get<std::string>()) * OLD_PRICE_SCALE),
+        (SizeT)llround(std::stod(lvl.at(1).get<std::string>()) * OLD_PRICE_SCALE)});
+  }
+  for (const auto &lvl : j.at("a")) {
+    out.asks.push_back(Level{
+        (PriceT)llround(std::stod(lvl.at(0).get<std::string>()) * OLD_PRICE_SCALE),
+        (SizeT)llround(std::stod(lvl.at(1).get<std::string>()) * OLD_PRICE_SCALE)});
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> frames = argc >= 2 ? load_frames(argv[1]) : synthetic_frames(2000, 20);
+  int iters = argc >= 3 ? std::atoi(argv[2]) : 20;
+  if (frames.empty()) return 1;
+
+  size_t bytes = 0;
+  for (const auto &f : frames) bytes += f.size();
+  std::cerr << "[bench] " << frames.size() << " frames, " << bytes << " bytes, " << iters << " iterations\n";
+
+  DepthDelta d;
+  d.bids.reserve(1024);
+  d.asks.reserve(1024);
+
+  // sanity: both paths must agree on ids and level counts
+  for (const auto &f : frames) {
+    DepthDelta ref;
+    bool ok_old = old_json_path(f, ref);
+    bool ok_new = decode_depth_update(f.data(), f.size(), d) == DecodeStatus::Ok;
+    if (ok_old != ok_new || (ok_new && (ref.final_update_id != d.final_update_id ||
+        ref.bids.size() != d.bids.size() || ref.asks.size() != d.asks.size()))) {
+      std::cerr << "[bench] decoder mismatch on frame: " << f.substr(0, 120) << "\n";
+      return 2;
+    }
+  }
+
+  auto run = [&](const char *name, auto &&fn) {
+    uint64_t t0 = now_ns();
+    size_t ok = 0;
+    for (int it = 0; it < iters; ++it) {
+      for (const auto &f : frames) ok += fn(f) ? 1 : 0;
+    }
+    uint64_t dt = now_ns() - t0;
+    double n = double(frames.size()) * iters;
+    std::cout << name << ": " << (double(dt) / n) << " ns/frame, "
+      << (double(bytes) * iters / (double(dt) / 1e9) / 1e6) << " MB/s (" << ok << " ok)\n";
+    return double(dt) / n;
+  };
+
+  double old_ns = run("json::parse", [&](const std::string &f) { return old_json_path(f, d); });
+  double new_ns = run("decode_depth_update", [&](const std::string &f) {
+      bool ok = decode_depth_update(f.data(), f.size(), d) == DecodeStatus::Ok;
+      do_not_optimize(d.final_update_id);
+      return ok;
+  });
+  std::cout << "speedup: " << old_ns / new_ns << "x\n";
+  return 0;
+}
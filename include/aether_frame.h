@@ -0,0 +1,149 @@
+/* aether_frame.h
+ * Binary payload layout for DEPTH_UPDATE / SNAPSHOT ring frames, plus a header-only
+ * decoder usable from plain C (cadenza's OCaml stubs) and C++.
+ *
+ * Ring frame (layout v3, 8-byte aligned): [FrameHeader {uint32 len, uint8 type,
+ * uint8 flags, uint16 rsv, uint64 seq} (16 bytes)][payload][pad to 8], type is one of
+ * AETHER_MSG_* (see ring_mmap.h / ring_c.h).
+ * Binary payload (all fields little-endian, fixed layout):
+ *   aether_frame_header                       56 bytes
+ *   aether_level bids[bid_count]              16 bytes each, best first
+ *   aether_level asks[ask_count]              16 bytes each, best first
+ * Prices/quantities are integer ticks: value = ticks / 10^price_decimals (qty likewise).
+ * For DEPTH_UPDATE a qty of 0 removes the level. For SNAPSHOT U == u == lastUpdateId.
+ * RESYNC (no levels) is published when the producer hits a sequence gap: U is the last
+ * update id it applied, u the first update id of the event that did not fit. Consumers
+ * drop their book and rebuild from the SNAPSHOT that follows.
+ * A SNAPSHOT with AETHER_FRAME_FLAG_CHECKPOINT is a periodic copy of a book that did
+ * not change discontinuously: consumers already in sync may skip it, late joiners
+ * start from the latest one (ring_reader_seek_snapshot) and apply the deltas after it.
+ * A DEPTH_UPDATE with AETHER_FRAME_FLAG_CONFLATED merges consecutive deltas (last qty
+ * per level wins); it applies like any delta whose U..u covers the consumer's u+1.
+ * AETHER_FRAME_FLAG_ANALYTICS (DEPTH_UPDATE, SNAPSHOT): an aether_analytics trailer
+ * follows the asks, holding mid, microprice, spread, top-N imbalance and cumulative
+ * depth of the book after this frame. Decoders that ignore bytes past the levels are
+ * unaffected; aether_frame_read_analytics() copies it out.
+ * Payloads inside the ring start 8-byte aligned. Copies elsewhere (WAL records, network
+ * buffers) need not be, so the helpers below memcpy rather than cast.
+ */
+#ifndef AETHER_FRAME_H
+#define AETHER_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "aether_frame.h assumes a little-endian host"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AETHER_FRAME_VERSION 1
+
+/* ring message types */
+#define AETHER_MSG_DEPTH_UPDATE_JSON 1 /* legacy: raw depthUpdate JSON text */
+#define AETHER_MSG_SNAPSHOT_JSON     2 /* legacy: REST snapshot JSON text */
+#define AETHER_MSG_DEPTH_UPDATE      3 /* binary, this header */
+#define AETHER_MSG_SNAPSHOT          4 /* binary, this header */
+#define AETHER_MSG_RESYNC            5 /* binary, header only: book invalid until the next SNAPSHOT */
+
+/* aether_frame_header.flags */
+#define AETHER_FRAME_FLAG_CHECKPOINT 0x1 /* SNAPSHOT: periodic checkpoint, not a rebuild */
+#define AETHER_FRAME_FLAG_CONFLATED  0x2 /* DEPTH_UPDATE: several deltas merged, U..u spans them */
+#define AETHER_FRAME_FLAG_ANALYTICS  0x4 /* aether_analytics trailer after the levels */
+
+typedef struct aether_frame_header {
+  uint16_t version;         /* AETHER_FRAME_VERSION */
+  uint16_t flags;           /* AETHER_FRAME_FLAG_* */
+  uint32_t symbol_id;       /* aether_symbol_id(upper-case symbol) */
+  uint64_t first_update_id; /* U */
+  uint64_t final_update_id; /* u */
+  uint64_t exch_ts_ms;      /* exchange event time E (0 for snapshots) */
+  uint64_t local_ts_us;     /* local monotonic receive time */
+  uint32_t bid_count;
+  uint32_t ask_count;
+  int8_t   price_decimals;
+  int8_t   qty_decimals;
+  uint16_t reserved0;
+  uint32_t reserved1;
+} aether_frame_header;
+
+typedef struct aether_level {
+  int64_t price_ticks;
+  int64_t qty_ticks;
+} aether_level;
+
+/* book figures after the frame; prices in price ticks, quantities in qty ticks */
+typedef struct aether_analytics {
+  int64_t  bid_price;       /* best bid (0, 0 when the side is empty) */
+  int64_t  bid_qty;
+  int64_t  ask_price;
+  int64_t  ask_qty;
+  int64_t  spread;          /* ask - bid, 0 unless both sides are present */
+  int64_t  bid_depth_qty;   /* cumulative qty of the best `depth` levels */
+  int64_t  ask_depth_qty;
+  double   bid_depth_notional; /* sum of price * qty over those levels, ticks * ticks */
+  double   ask_depth_notional;
+  double   mid;             /* fractional ticks */
+  double   microprice;      /* (bid * ask_qty + ask * bid_qty) / (bid_qty + ask_qty) */
+  double   imbalance;       /* (bid_depth_qty - ask_depth_qty) / their sum, in [-1, 1] */
+  uint16_t depth;           /* N levels per side in the depth sums */
+  uint16_t bid_levels;      /* levels actually summed (< depth for a short side) */
+  uint16_t ask_levels;
+  uint16_t reserved0;
+} aether_analytics;
+
+#ifdef __cplusplus
+static_assert(sizeof(aether_frame_header) == 56, "aether_frame_header layout");
+static_assert(sizeof(aether_level) == 16, "aether_level layout");
+static_assert(sizeof(aether_analytics) == 104, "aether_analytics layout");
+#endif
+
+/* stable 32-bit id for a symbol name (FNV-1a over the bytes) */
+static inline uint32_t aether_symbol_id(const char *symbol) {
+  uint32_t h = 2166136261u;
+  for (; *symbol; ++symbol) {
+    h ^= (uint8_t)*symbol;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static inline size_t aether_frame_size(uint32_t bid_count, uint32_t ask_count) {
+  return sizeof(aether_frame_header) + ((size_t)bid_count + ask_count) * sizeof(aether_level);
+}
+
+/* Copy the header out of a payload. Returns 1 if the payload is a complete frame of a
+ * known version, 0 otherwise. */
+static inline int aether_frame_read_header(const void *payload, size_t len, aether_frame_header *out) {
+  if (!payload || len < sizeof(aether_frame_header)) return 0;
+  memcpy(out, payload, sizeof(aether_frame_header));
+  if (out->version != AETHER_FRAME_VERSION) return 0;
+  if (len < aether_frame_size(out->bid_count, out->ask_count)) return 0;
+  return 1;
+}
+
+/* i-th level of the frame: bids are [0, bid_count), asks follow */
+static inline void aether_frame_read_level(const void *payload, uint32_t i, aether_level *out) {
+  const uint8_t *p = (const uint8_t *)payload + sizeof(aether_frame_header) + (size_t)i * sizeof(aether_level);
+  memcpy(out, p, sizeof(aether_level));
+}
+
+/* Copy the analytics trailer out of a frame whose header was read with
+ * aether_frame_read_header. Returns 1 if the frame carries one, 0 otherwise. */
+static inline int aether_frame_read_analytics(const void *payload, size_t len, const aether_frame_header *h,
+    aether_analytics *out) {
+  size_t off = aether_frame_size(h->bid_count, h->ask_count);
+  if (!(h->flags & AETHER_FRAME_FLAG_ANALYTICS) || len < off + sizeof(aether_analytics)) return 0;
+  memcpy(out, (const uint8_t *)payload + off, sizeof(aether_analytics));
+  return 1;
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* AETHER_FRAME_H */
@@ -0,0 +1,23 @@
+#pragma once
+// alloc_count.h
+// Heap allocation counting for the zero-allocation check of the hot path. In a build
+// with -DAETHER_COUNT_ALLOCS=ON the global operator new is replaced by malloc plus a
+// thread-local increment, and the stages read thread_allocs() around their work (the
+// pipeline per applied event, the feed reader per decoded frame). In a normal build
+// nothing is replaced and thread_allocs() is a constant 0.
+
+#include <cstdint>
+
+namespace aether { namespace mem {
+
+#ifdef AETHER_COUNT_ALLOCS
+  inline constexpr bool counting = true;
+  extern thread_local uint64_t t_allocs;
+  // operator new calls made by the calling thread so far
+  inline uint64_t thread_allocs() noexcept { return t_allocs; }
+#else
+  inline constexpr bool counting = false;
+  inline uint64_t thread_allocs() noexcept { return 0; }
+#endif
+
+}} // namespace aether::mem
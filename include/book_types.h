@@ -0,0 +1,38 @@
+#pragma once
+// book_types.h
+// Scalar types shared by the decoder, the order book and the ring encoders
+
+#include <cstdint>
+
+namespace aether {
+
+  using PriceT = int64_t;
+  using SizeT  = int64_t;
+
+  // one price level as scaled integers
+  struct Level {
+    PriceT price;
+    SizeT  qty;
+  };
+
+  // Book-derived figures, kept up to date level by level by BasicOrderBook (see
+  // setAnalyticsDepth). Prices in ticks; mid and microprice are fractional ticks.
+  struct BookAnalytics {
+    bool has_bid = false;
+    bool has_ask = false;
+    Level bid{0, 0};            // best levels ({0, 0} when the side is empty)
+    Level ask{0, 0};
+    PriceT spread = 0;          // ask - bid, 0 unless both sides are present
+    double mid = 0;
+    double microprice = 0;      // (bid * ask_qty + ask * bid_qty) / (bid_qty + ask_qty)
+    uint32_t depth = 0;         // N of the sums below, 0 when not tracked
+    uint32_t bid_levels = 0;    // levels in the sums (< depth for a short side)
+    uint32_t ask_levels = 0;
+    SizeT bid_qty = 0;          // cumulative quantity of the best N levels
+    SizeT ask_qty = 0;
+    double bid_notional = 0;    // sum of price * qty over those levels, in ticks * ticks
+    double ask_notional = 0;
+    double imbalance = 0;       // (bid_qty - ask_qty) / (bid_qty + ask_qty), in [-1, 1]
+  };
+
+} // namespace aether
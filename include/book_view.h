@@ -0,0 +1,158 @@
+#pragma once
+// book_view.h
+// Per-symbol "book view": a small mmap'd segment next to the ring holding the book's
+// current best bid/ask, top N levels per side and last update id. The book thread
+// rewrites it under a seqlock after every applied event, so a reader in any process
+// gets a consistent top of book from a couple of cache lines, without replaying the
+// ring's delta stream.
+//
+// Layout: [BookViewHeader (one page)][BookViewTop (one cache line)][bids x depth][asks x depth]
+//
+// Seqlock: the writer makes top.seq odd, stores the data, then makes it even again.
+// A reader loads seq (acquire), copies what it needs, fences and reloads seq; the copy
+// is consistent iff both loads return the same even value. All data words are accessed
+// through relaxed atomics, so neither side is a data race. A reader never writes to the
+// segment and the writer never waits for readers.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "book_types.h"
+#include "decimal.h"
+
+namespace aether { namespace view {
+
+  static constexpr uint32_t VIEW_MAGIC = 0x56424541; // "AEBV"
+  static constexpr uint16_t VIEW_VERSION = 1;
+  static constexpr uint32_t DEFAULT_DEPTH = 20;
+  static constexpr uint32_t MAX_DEPTH = 1000;
+
+  // BookViewTop::flags
+  static constexpr uint32_t VIEW_SYNCED = 1;  // book built from a snapshot and not resyncing
+
+  struct BookViewHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t depth;             // levels per side
+    uint32_t symbol_id;         // aether_symbol_id(symbol), as in ring frames
+    char symbol[16];
+    int32_t price_decimals;     // scale of the integer prices and quantities
+    int32_t qty_decimals;
+    uint32_t pid;               // writer process
+    uint32_t reserved1;
+    uint64_t start_unix_ns;
+  };
+
+  // first cache line of the data: enough for a BBO read
+  struct alignas(64) BookViewTop {
+    uint64_t seq;               // odd while the writer is updating
+    uint64_t last_update_id;
+    uint16_t bid_levels;        // valid entries in bids / asks (<= depth)
+    uint16_t ask_levels;
+    uint32_t flags;             // VIEW_*
+    Level best_bid;             // {0, 0} when the side is empty
+    Level best_ask;
+    uint64_t event_time_ms;     // E of the last applied event
+  };
+  static_assert(sizeof(BookViewTop) == 64, "BookViewTop is one cache line");
+
+  // consistent BBO copy
+  struct TopOfBook {
+    uint64_t seq = 0;
+    uint64_t last_update_id = 0;
+    uint64_t event_time_ms = 0;
+    uint32_t flags = 0;
+    bool has_bid = false;
+    bool has_ask = false;
+    Level bid{0, 0};
+    Level ask{0, 0};
+  };
+
+  // consistent copy of up to depth levels per side
+  struct DepthSnapshot {
+    TopOfBook top;
+    size_t bid_levels = 0;
+    size_t ask_levels = 0;
+    Level bids[MAX_DEPTH];
+    Level asks[MAX_DEPTH];
+  };
+
+  // DIR/aether.SYMBOL.view
+  std::string view_path(const std::string &dir, const std::string &symbol);
+
+  // Single writer (the symbol's book thread).
+  class BookViewWriter {
+    public:
+      BookViewWriter() = default;
+      ~BookViewWriter();
+      BookViewWriter(const BookViewWriter &) = delete;
+      BookViewWriter &operator=(const BookViewWriter &) = delete;
+
+      // creates (or replaces) the segment; false on error (logged)
+      bool create(const std::string &path, const std::string &symbol, const DecimalScale &scale,
+          uint32_t depth = DEFAULT_DEPTH);
+      void close();
+      bool is_open() const noexcept { return top_ != nullptr; }
+      uint32_t depth() const noexcept { return depth_; }
+
+      // rewrites the view from the book's best levels (BasicOrderBook or anything
+      // with forEachBid/forEachAsk and lastUpdateId)
+      template <class Book>
+      void update(const Book &book, uint64_t event_time_ms, uint32_t flags) {
+        begin();
+        uint32_t nb = 0, na = 0;
+        book.forEachBid([&](PriceT p, SizeT q) { put(bids_[nb++], p, q); return nb < depth_; });
+        book.forEachAsk([&](PriceT p, SizeT q) { put(asks_[na++], p, q); return na < depth_; });
+        end(book.lastUpdateId(), event_time_ms, flags, nb, na);
+      }
+
+    private:
+      void begin();
+      void end(uint64_t last_update_id, uint64_t event_time_ms, uint32_t flags, uint32_t nb, uint32_t na);
+      static void put(Level &l, PriceT p, SizeT q) {
+        std::atomic_ref<int64_t>(l.price).store(p, std::memory_order_relaxed);
+        std::atomic_ref<int64_t>(l.qty).store(q, std::memory_order_relaxed);
+      }
+
+      void *map_ = nullptr;
+      size_t map_size_ = 0;
+      BookViewTop *top_ = nullptr;
+      Level *bids_ = nullptr;
+      Level *asks_ = nullptr;
+      uint32_t depth_ = 0;
+      uint64_t seq_ = 0;
+  };
+
+  // Any number of readers, in any process. Reads spin while the writer is mid-update
+  // and give up (false) if it never settles, e.g. when the writer died mid-update.
+  class BookViewReader {
+    public:
+      BookViewReader() = default;
+      ~BookViewReader();
+      BookViewReader(const BookViewReader &) = delete;
+      BookViewReader &operator=(const BookViewReader &) = delete;
+
+      // maps an existing view read-only; false on error (logged)
+      bool open(const std::string &path);
+      void close();
+
+      const BookViewHeader *header() const noexcept { return hdr_; }
+      // bumped on every update; cheap change detection before a full read
+      uint64_t sequence() const noexcept;
+
+      bool read_top(TopOfBook &out) const;
+      // up to max_levels per side (capped at the view's depth)
+      bool read(DepthSnapshot &out, size_t max_levels = MAX_DEPTH) const;
+
+    private:
+      void *map_ = nullptr;
+      size_t map_size_ = 0;
+      const BookViewHeader *hdr_ = nullptr;
+      const BookViewTop *top_ = nullptr;
+      const Level *bids_ = nullptr;
+      const Level *asks_ = nullptr;
+  };
+
+}} // namespace aether::view
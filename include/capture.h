@@ -0,0 +1,138 @@
+#pragma once
+// capture.h
+// Raw feed capture: every WS frame and REST body exactly as received, with monotonic
+// and wall-clock receive times, in a block-compressed file that aether_replay reads.
+//
+// Producers never block: each producer thread owns a CaptureChannel (an SPSC hand-off
+// of preallocated slots with a byte budget) and record() drops, counting the drop,
+// when the writer is behind. A writer thread packs records into blocks and deflates
+// each block (zlib) before writing.
+//
+// File: [CaptureFileHeader][block]...
+//   block = [CaptureBlockHeader][deflate(raw)]
+//   raw   = [CaptureRecordHeader][payload]...
+// A torn last block (crash) is ignored by the reader.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "feed_source.h"
+#include "runtime.h"
+#include "spsc_queue.h"
+
+namespace aether {
+
+  struct CaptureFileHeader {
+    uint32_t magic;       // "ACAP"
+    uint16_t version;
+    uint16_t reserved0;
+    uint64_t reserved1;
+  };
+
+  struct CaptureBlockHeader {
+    uint32_t raw_len;
+    uint32_t comp_len;
+    uint32_t records;
+    uint32_t crc;         // crc32 of the raw bytes
+  };
+
+  struct CaptureRecordHeader {
+    uint32_t len;         // payload bytes
+    uint8_t  kind;        // FeedRecord::Kind
+    uint8_t  reserved[3];
+    uint64_t mono_us;
+    uint64_t wall_us;
+  };
+
+  static_assert(sizeof(CaptureFileHeader) == 16, "CaptureFileHeader layout");
+  static_assert(sizeof(CaptureBlockHeader) == 16, "CaptureBlockHeader layout");
+  static_assert(sizeof(CaptureRecordHeader) == 24, "CaptureRecordHeader layout");
+
+  struct CaptureConfig {
+    std::string path;                        // empty = capture disabled
+    size_t block_bytes = 256 << 10;          // raw bytes per compressed block
+    int level = 1;                           // zlib level (1 = fastest)
+    uint32_t flush_interval_ms = 1000;       // partial blocks are written after this
+    size_t channel_records = 8192;           // slots per producer channel
+    size_t channel_max_bytes = 64 << 20;     // payload bytes queued per channel
+    rt::ThreadPolicy thread;                 // writer thread placement
+  };
+
+  // Single-producer hand-off into the capture writer.
+  class CaptureChannel {
+    public:
+      CaptureChannel(size_t records, size_t max_bytes);
+
+      // Copies the payload; wall-clock time is taken here. Never blocks: returns false
+      // and counts a drop if the channel is full or over its byte budget.
+      bool record(uint8_t kind, uint64_t mono_us, const void *payload, size_t len);
+
+      uint64_t recorded() const noexcept { return recorded_.load(std::memory_order_relaxed); }
+      uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+      friend class CaptureWriter;
+      struct Slot {
+        uint8_t kind = 0;
+        uint64_t mono_us = 0;
+        uint64_t wall_us = 0;
+        std::vector<uint8_t> data;
+      };
+
+      SpscQueue<Slot, BusySpinWait> q_;
+      size_t max_bytes_;
+      std::atomic<size_t> queued_bytes_{0};
+      std::atomic<uint64_t> recorded_{0};
+      std::atomic<uint64_t> dropped_{0};
+  };
+
+  class CaptureWriter {
+    public:
+      explicit CaptureWriter(const CaptureConfig &cfg);
+      ~CaptureWriter();
+
+      // one per producer thread; call before start()
+      CaptureChannel *add_channel();
+
+      // opens (truncates) the file and starts the writer thread
+      bool start();
+      // drains every channel, writes the last block and joins
+      void stop();
+
+      uint64_t dropped() const noexcept;
+      uint64_t records_written() const noexcept { return records_.load(std::memory_order_relaxed); }
+      uint64_t bytes_raw() const noexcept { return bytes_raw_.load(std::memory_order_relaxed); }
+      uint64_t bytes_compressed() const noexcept { return bytes_comp_.load(std::memory_order_relaxed); }
+
+    private:
+      void run();
+      size_t drain(CaptureChannel &ch);
+      void write_block();
+
+      CaptureConfig cfg_;
+      std::vector<std::unique_ptr<CaptureChannel>> channels_;
+      std::thread thread_;
+      std::atomic<bool> stop_{false};
+      bool started_ = false;
+
+      // writer-thread state
+      int fd_ = -1;
+      std::vector<uint8_t> raw_;
+      std::vector<uint8_t> comp_;
+      uint32_t block_records_ = 0;
+
+      std::atomic<uint64_t> records_{0};
+      std::atomic<uint64_t> bytes_raw_{0};
+      std::atomic<uint64_t> bytes_comp_{0};
+  };
+
+  // true if path starts with the capture file magic
+  bool is_capture_file(const std::string &path);
+  // appends every record of a capture file; false if it cannot be read
+  bool read_capture(const std::string &path, std::vector<FeedRecord> &out);
+
+} // namespace aether
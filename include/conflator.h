@@ -0,0 +1,59 @@
+#pragma once
+// conflator.h
+// Merges consecutive depth deltas of one symbol into a single delta: the last quantity
+// per price level wins (0 still removes), U is the first delta's and u the last one's.
+// Applying the merged delta to a book at U-1 gives the same book as applying each of
+// them, so a consumer sees a thinner but correct stream. Used by the pipeline to
+// conflate ring frames (PipelineConfig::conflate).
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "book_types.h"
+#include "depth_decoder.h"
+
+namespace aether {
+
+  enum class ConflateMode {
+    Off,
+    Always,   // every delta goes through a conflation window
+    OnLag     // only while the slowest ring reader lags by more than a threshold
+  };
+
+  // "off", "always", "lag" (false for anything else)
+  bool parse_conflate_mode(const std::string &s, ConflateMode &out);
+
+  class Conflator {
+    public:
+      // start a window at the first delta; now_ns is when it was taken in
+      void add(const DepthDelta &d, uint64_t local_recv_us, uint64_t now_ns);
+
+      bool empty() const noexcept { return deltas_ == 0; }
+      size_t deltas() const noexcept { return deltas_; }
+      size_t levels() const noexcept { return bids_.size() + asks_.size(); }
+      uint64_t started_ns() const noexcept { return started_ns_; }
+      uint64_t last_recv_us() const noexcept { return last_recv_us_; }
+
+      // the merged delta (bids best first, asks best first); valid until the next add()
+      const DepthDelta &merge();
+      // start over (entry storage is kept)
+      void clear() noexcept;
+
+      // one buffered level update
+      struct Entry {
+        PriceT price;
+        uint32_t order;     // arrival order, the latest entry of a price wins
+        SizeT qty;
+      };
+
+    private:
+      std::vector<Entry> bids_, asks_;
+      DepthDelta merged_;
+      size_t deltas_ = 0;
+      uint32_t order_ = 0;
+      uint64_t started_ns_ = 0;
+      uint64_t last_recv_us_ = 0;
+  };
+
+} // namespace aether
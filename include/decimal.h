@@ -0,0 +1,165 @@
+#pragma once
+// decimal.h
+// Exact ASCII decimal -> int64 fixed-point ticks, scaled per symbol.
+// No strtod, no locale, no heap: callers hand in char ranges straight out of the
+// WS frame or the snapshot body. SSE2 validates the charset and finds the '.' in one
+// pass for the common <= 16 byte case; digits are folded 8 at a time (SWAR).
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace aether {
+
+  // value_ticks = value * 10^decimals
+  struct DecimalScale {
+    int price_decimals = 8;
+    int qty_decimals   = 8;
+
+    // Derive decimals from exchange filters, e.g. tickSize "0.01000000" -> 2,
+    // stepSize "0.00001000" -> 5. Returns false if either string is not a decimal.
+    static bool from_filters(std::string_view tickSize, std::string_view stepSize, DecimalScale &out);
+  };
+
+  // number of significant fractional digits in a step like "0.00100000" (3); -1 on bad input
+  inline int decimals_of_step(std::string_view s) {
+    if (s.empty()) return -1;
+    size_t dot = s.find('.');
+    for (size_t i = 0; i < s.size(); ++i) {
+      if (i != dot && (s[i] < '0' || s[i] > '9')) return -1;
+    }
+    if (dot == std::string_view::npos) return 0;
+    int last = 0;
+    for (size_t i = dot + 1; i < s.size(); ++i) {
+      if (s[i] != '0') last = int(i - dot);
+    }
+    return last;
+  }
+
+  inline bool DecimalScale::from_filters(std::string_view tickSize, std::string_view stepSize, DecimalScale &out) {
+    int pd = decimals_of_step(tickSize);
+    int qd = decimals_of_step(stepSize);
+    if (pd < 0 || qd < 0 || pd > 18 || qd > 18) return false;
+    out.price_decimals = pd;
+    out.qty_decimals = qd;
+    return true;
+  }
+
+  namespace detail {
+
+    static constexpr uint64_t POW10[20] = {
+      1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+      100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+      10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+      100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL };
+
+    // 8 ASCII digits -> value (little-endian SWAR, digits already validated)
+    inline uint32_t parse_eight_digits(const char *p) {
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+      v -= 0x3030303030303030ULL;
+      v = (v * 10) + (v >> 8);
+      v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+           (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+      return uint32_t(v);
+    }
+
+    // Find the single '.' in [p, p+n) and check everything else is a digit.
+    // dot = n when there is no '.'. Returns false on any other character.
+    inline bool scan_decimal(const char *p, size_t n, size_t &dot) {
+#if defined(__SSE2__)
+      if (n <= 16) {
+        char tmp[16];
+        std::memset(tmp, '0', sizeof(tmp));
+        std::memcpy(tmp, p, n);
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tmp));
+        // digits: (c - '0') as unsigned < 10  <=>  signed (c - '0' - 128) < (10 - 128)
+        __m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8(char('0' + 128)));
+        __m128i nondigit = _mm_cmpgt_epi8(shifted, _mm_set1_epi8(char(9 - 128)));
+        __m128i isdot = _mm_cmpeq_epi8(v, _mm_set1_epi8('.'));
+        uint32_t nd = uint32_t(_mm_movemask_epi8(nondigit));
+        uint32_t dm = uint32_t(_mm_movemask_epi8(isdot));
+        if (nd != dm) return false;              // something other than digits and '.'
+        if (dm & (dm - 1)) return false;         // more than one '.'
+        dot = dm ? size_t(__builtin_ctz(dm)) : n;
+        return true;
+      }
+#endif
+      dot = n;
+      for (size_t i = 0; i < n; ++i) {
+        unsigned d = unsigned(p[i]) - unsigned('0');
+        if (d < 10) continue;
+        if (p[i] != '.' || dot != n) return false;
+        dot = i;
+      }
+      return true;
+    }
+
+  } // namespace detail
+
+  // Parse [b, e) into ticks at 10^decimals. Returns false on syntax error, int64 overflow,
+  // or non-zero digits below the scale (the value is not on the symbol's grid).
+  inline bool parse_decimal(const char *b, const char *e, int decimals, int64_t &out) noexcept {
+    if (b >= e || decimals < 0 || decimals > 18) return false;
+    bool neg = (*b == '-');
+    b += neg;
+    size_t n = size_t(e - b);
+    size_t dot;
+    if (n == 0 || !detail::scan_decimal(b, n, dot)) return false;
+
+    size_t int_len = dot;
+    size_t frac_len = dot < n ? n - dot - 1 : 0;
+    if (int_len == 0 && frac_len == 0) return false;
+    const char *frac = b + dot + 1;
+
+    // digits past the scale may only be padding zeros
+    if (frac_len > size_t(decimals)) {
+      for (size_t i = size_t(decimals); i < frac_len; ++i)
+        if (frac[i] != '0') return false;
+      frac_len = size_t(decimals);
+    }
+    while (int_len > 0 && *b == '0') { ++b; --int_len; }
+
+    size_t total = int_len + size_t(decimals);
+    if (total > 19) return false;
+
+    // int digits ++ frac digits ++ zero padding, then fold 8 at a time
+    char digits[24];
+    std::memcpy(digits, b, int_len);
+    std::memcpy(digits + int_len, frac, frac_len);
+    std::memset(digits + int_len + frac_len, '0', size_t(decimals) - frac_len);
+
+    uint64_t v = 0;
+    size_t i = 0;
+    for (size_t head = total % 8; i < head; ++i) v = v * 10 + uint64_t(digits[i] - '0');
+    for (; i < total; i += 8) {
+      uint64_t hi;
+      if (__builtin_mul_overflow(v, uint64_t(100000000), &hi)) return false;
+      if (__builtin_add_overflow(hi, uint64_t(detail::parse_eight_digits(digits + i)), &v)) return false;
+    }
+    if (v > uint64_t(INT64_MAX)) return false;
+    out = neg ? -int64_t(v) : int64_t(v);
+    return true;
+  }
+
+  inline bool parse_decimal(std::string_view s, int decimals, int64_t &out) noexcept {
+    return parse_decimal(s.data(), s.data() + s.size(), decimals, out);
+  }
+
+  inline bool parse_price(std::string_view s, const DecimalScale &sc, int64_t &out) noexcept {
+    return parse_decimal(s, sc.price_decimals, out);
+  }
+  inline bool parse_qty(std::string_view s, const DecimalScale &sc, int64_t &out) noexcept {
+    return parse_decimal(s, sc.qty_decimals, out);
+  }
+
+  // ticks -> double for display only
+  inline double ticks_to_double(int64_t v, int decimals) {
+    return double(v) / double(detail::POW10[decimals]);
+  }
+
+} // namespace aether
@@ -0,0 +1,47 @@
+#pragma once
+// depth_decoder.h
+// Streaming decoder for Binance depthUpdate frames.
+// Reads the raw WS payload in place (no std::string copy, no json DOM) and fills a
+// DepthDelta whose level vectors keep their capacity between frames.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "book_types.h"
+#include "decimal.h"
+
+namespace aether {
+
+  struct DepthDelta {
+    uint64_t first_update_id = 0; // U
+    uint64_t final_update_id = 0; // u
+    uint64_t event_time_ms   = 0; // E
+    std::vector<Level> bids;      // qty == 0 means remove level
+    std::vector<Level> asks;
+
+    // reset fields but keep level storage allocated
+    void clear() noexcept {
+      first_update_id = final_update_id = event_time_ms = 0;
+      bids.clear();
+      asks.clear();
+    }
+  };
+
+  enum class DecodeStatus {
+    Ok,             // depthUpdate decoded into out
+    NotDepthUpdate, // well-formed but some other event type
+    Malformed       // truncated / unexpected syntax / bad number
+  };
+
+  // Decode one depthUpdate frame from [data, data+len) with prices/sizes scaled per
+  // the symbol's DecimalScale. out is cleared first. Combined-stream frames
+  // ({"stream":...,"data":{...}}) are unwrapped.
+  DecodeStatus decode_depth_update(const char *data, size_t len, DepthDelta &out,
+      const DecimalScale &scale = DecimalScale{});
+
+  // Symbol ("s") of a depthUpdate frame without decoding it, for routing before the
+  // per-symbol scale is known. Empty if there is none.
+  std::string_view depth_frame_symbol(const char *data, size_t len);
+
+} // namespace aether
@@ -1,43 +1,75 @@
 #pragma once
 // event_queue.h
-// Thread-safe queue for JsonEvent
+// Single-producer/single-consumer queue of DepthEvent between the WS reader and
+// the book thread. Slots are preallocated and reused, so steady-state pushes and
+// pops do not allocate. The consumer wait policy is picked at build time
+// (AETHER_QUEUE_WAIT = futex | yield | spin).
 
-#include <nlohmann/json.hpp>
-#include <deque>
-#include <mutex>
-#include <condition_variable>
 #include <vector>
 #include <cstdint>
+#include "depth_decoder.h"
+#include "spsc_queue.h"
 
-using json = nlohmann::json;
-
-struct JsonEvent {
-  json j;
-  uint64_t local_recv_ts_us;
+struct DepthEvent {
+  aether::DepthDelta delta;   // decoded in place from the WS frame
+  uint64_t local_recv_ts_us = 0;
+  uint64_t recv_tsc = 0;      // tsc_now() when the frame arrived / when it was decoded
+  uint64_t decoded_tsc = 0;
+  uint32_t symbol = 0;        // index of the symbol within its shard (multi-symbol feeds)
+  bool end_of_stream = false; // last event from a source that stopped (delta unused)
 };
 
+#if defined(AETHER_QUEUE_WAIT_SPIN)
+using EventWait = aether::BusySpinWait;
+#elif defined(AETHER_QUEUE_WAIT_YIELD)
+using EventWait = aether::SpinYieldWait;
+#else
+using EventWait = aether::SpinFutexWait;
+#endif
+
 class EventQueue {
   public:
-    EventQueue();
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    explicit EventQueue(size_t capacity = DEFAULT_CAPACITY);
     ~EventQueue();
 
-    // push a new event (moves in)
-    void push(JsonEvent &&e);
+    // reserve level storage in every slot up front (before the producer starts), so the
+    // reader does not allocate the first time it decodes into each slot; deltas with more
+    // levels than this still grow their slot once
+    void prewarm(size_t levels_per_side);
+
+    // -- producer (WS reader thread) --
+
+    // slot to decode the next event into, nullptr if full
+    DepthEvent* try_claim() { return q_.try_claim(); }
+    // hand the claimed slot to the consumer
+    void publish() { q_.publish(); }
 
-    // blocking pop
-    JsonEvent pop_blocking();
+    // push a new event (moves in); spins/yields while the queue is full
+    void push(DepthEvent &&e);
+
+    // -- consumer (book thread) --
+
+    // blocking pop; e's previous buffers are recycled into the queue
+    void pop_blocking(DepthEvent &e);
+
+    // process up to max queued events in place with f(DepthEvent&) -> bool
+    // (false stops the batch); waits for at least one. Returns events consumed.
+    template <class F>
+    size_t pop_n_blocking(F &&f, size_t max) { return q_.pop_n(std::forward<F>(f), max); }
+
+    // non-blocking variant of pop_n_blocking
+    template <class F>
+    size_t try_pop_n(F &&f, size_t max) { return q_.try_pop_n(std::forward<F>(f), max); }
 
     // non-blocking size
     size_t size();
+    size_t capacity() const noexcept { return q_.capacity(); }
 
-    // peek first's U (returns false if none or parse error)
+    // peek first's U (returns false if none)
     bool peek_first_U(uint64_t &outU);
 
-    // drain all events into a vector (moves them)
-    std::vector<JsonEvent> drain_all();
-
   private:
-    std::deque<JsonEvent> dq_;
-    std::mutex m_;
-    std::condition_variable cv_;
+    aether::SpscQueue<DepthEvent, EventWait> q_;
 };
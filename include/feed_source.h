@@ -0,0 +1,95 @@
+#pragma once
+// feed_source.h
+// Where depth data comes from. The pipeline only talks to this interface, so the
+// same bootstrap/apply/publish code runs against the live exchange (LiveFeed) or a
+// recorded file (ReplayFeed).
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "decimal.h"
+#include "event_queue.h"
+
+namespace aether {
+
+  // one raw input as received (recordings and captures)
+  struct FeedRecord {
+    enum Kind : uint8_t { WsFrame = 'W', Snapshot = 'S', ExchangeInfo = 'I' };
+    uint8_t kind = WsFrame;
+    uint64_t recv_us = 0;   // local monotonic receive time
+    uint64_t wall_us = 0;   // wall-clock receive time (0 if not recorded)
+    std::string body;
+  };
+
+  // One asynchronous snapshot fetch, shared by the pipeline that asked and the source
+  // doing it. The source writes snapshot, then publishes Ready (or Failed) with a
+  // release store; the pipeline reads snapshot only after seeing Ready. A pipeline that
+  // loses interest sets cancelled and drops its reference.
+  struct SnapshotRequest {
+    enum State : int {
+      Queued,     // waiting for the source's turn (rate budget, concurrency cap)
+      Fetching,   // request on its way: the snapshot will be newer than what is buffered
+      Ready,
+      Failed      // the source has no snapshot to offer
+    };
+    std::string symbol;                 // upper-case
+    std::atomic<int> state{Queued};
+    std::atomic<bool> cancelled{false};
+    nlohmann::json snapshot;            // parsed body, lastUpdateId checked
+  };
+
+  // REST depth snapshots, as needed by bootstrap and resync
+  class SnapshotSource {
+    public:
+      virtual ~SnapshotSource() = default;
+
+      // Blocking fetch of the depth snapshot body for symbol (upper-case), for the
+      // single-symbol bootstrap. Throws on transient errors (retried after
+      // retry_delay_ms); returns false if the source has no snapshot left to offer.
+      virtual bool fetch_snapshot(const std::string &symbol, std::string &body) = 0;
+      virtual int retry_delay_ms() const { return 1000; }
+
+      // Start fetching req->symbol, not before delay_ms, and retry transient errors
+      // until req is Ready, Failed or cancelled. Called from book threads that serve
+      // many symbols, so it must not block. The default runs fetch_snapshot inline and
+      // ignores the delay, which suits sources that answer at once (recordings); a
+      // body that does not parse is skipped for the next one.
+      virtual void request_snapshot(std::shared_ptr<SnapshotRequest> req, int delay_ms);
+  };
+
+  // A single-symbol feed: the depth stream plus its snapshots.
+  class FeedSource : public SnapshotSource {
+    public:
+
+      // exchangeInfo JSON for the symbol, "" if unavailable
+      virtual std::string exchange_info() = 0;
+      // starts delivering decoded depth events into queue on the source's own thread;
+      // an end_of_stream event is pushed when the source stops or runs dry
+      virtual void start(const DecimalScale &scale, EventQueue &queue, std::atomic<bool> &stop) = 0;
+      // joins the delivery thread (after stop was set or the source ran dry)
+      virtual void join() = 0;
+  };
+
+  // Per-symbol fixed-point scale from exchangeInfo PRICE_FILTER.tickSize and
+  // LOT_SIZE.stepSize. Returns false (scale left at 8/8) if the body is unusable.
+  bool scale_from_exchange_info(const std::string &body, DecimalScale &scale);
+  // same for a multi-symbol exchangeInfo body; returns the number of symbols found
+  size_t scales_from_exchange_info(const std::string &body,
+      std::unordered_map<std::string, DecimalScale> &scales);
+
+  // Binance GET /api/v3/depth weight for a limit
+  inline uint32_t depth_request_weight(uint32_t limit) {
+    if (limit <= 100) return 5;
+    if (limit <= 500) return 25;
+    if (limit <= 1000) return 50;
+    return 250;
+  }
+
+  // Queue an end_of_stream marker so a consumer blocked in pop_n_blocking wakes up.
+  // Gives up if stop is set while the queue is full.
+  void push_end_of_stream(EventQueue &queue, const std::atomic<bool> &stop);
+
+} // namespace aether
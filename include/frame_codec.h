@@ -0,0 +1,86 @@
+#pragma once
+// frame_codec.h
+// Encoders for the binary ring payloads described in aether_frame.h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "aether_frame.h"
+#include "decimal.h"
+#include "depth_decoder.h"
+
+namespace aether {
+
+  // per-symbol constants stamped into every frame header
+  struct FrameMeta {
+    uint32_t symbol_id = 0;
+    DecimalScale scale;
+  };
+
+  inline size_t depth_frame_size(const DepthDelta &d) {
+    return aether_frame_size(uint32_t(d.bids.size()), uint32_t(d.asks.size()));
+  }
+
+  // Encode a depth update into [buf, buf+cap). flags: AETHER_FRAME_FLAG_*. Returns bytes
+  // written, 0 if cap is too small.
+  size_t encode_depth_frame(void *buf, size_t cap, const FrameMeta &meta,
+      const DepthDelta &d, uint64_t local_ts_us, uint16_t flags = 0);
+
+  // Append an analytics trailer (aether_analytics) to the frame of n bytes at buf and
+  // set AETHER_FRAME_FLAG_ANALYTICS in its header. Returns the new size, 0 if cap is
+  // too small.
+  size_t append_analytics(void *buf, size_t cap, size_t n, const BookAnalytics &a);
+
+  // Encode a RESYNC marker (header only, see aether_frame.h). Returns bytes written.
+  size_t encode_resync_frame(void *buf, size_t cap, const FrameMeta &meta,
+      uint64_t last_applied_u, uint64_t gap_U, uint64_t local_ts_us);
+
+  template <class Book>
+  size_t book_snapshot_size(const Book &book) {
+    return aether_frame_size(uint32_t(book.bids().size()), uint32_t(book.asks().size()));
+  }
+
+  // Encode a book's full state as a SNAPSHOT payload into [buf, buf+cap). flags is
+  // stamped into the header (AETHER_FRAME_FLAG_*). Returns bytes written, 0 if cap is
+  // too small.
+  template <class Book>
+  size_t encode_book_snapshot(void *buf, size_t cap, const FrameMeta &meta,
+      const Book &book, uint64_t local_ts_us, uint16_t flags = 0) {
+    size_t nb = book.bids().size(), na = book.asks().size();
+    size_t n = aether_frame_size(uint32_t(nb), uint32_t(na));
+    if (n > cap) return 0;
+
+    aether_frame_header h{};
+    h.version = AETHER_FRAME_VERSION;
+    h.flags = flags;
+    h.symbol_id = meta.symbol_id;
+    h.first_update_id = h.final_update_id = book.lastUpdateId();
+    h.local_ts_us = local_ts_us;
+    h.bid_count = uint32_t(nb);
+    h.ask_count = uint32_t(na);
+    h.price_decimals = int8_t(meta.scale.price_decimals);
+    h.qty_decimals = int8_t(meta.scale.qty_decimals);
+    std::memcpy(buf, &h, sizeof(h));
+
+    uint8_t *p = static_cast<uint8_t*>(buf) + sizeof(h);
+    auto put = [&p](PriceT price, SizeT qty) {
+      aether_level l{price, qty};
+      std::memcpy(p, &l, sizeof(l));
+      p += sizeof(l);
+      return true;
+    };
+    book.forEachBid(put);
+    book.forEachAsk(put);
+    return n;
+  }
+
+  // same, into out (resized, capacity kept)
+  template <class Book>
+  size_t encode_book_snapshot(std::vector<uint8_t> &out, const FrameMeta &meta,
+      const Book &book, uint64_t local_ts_us, uint16_t flags = 0) {
+    out.resize(book_snapshot_size(book));
+    return encode_book_snapshot(out.data(), out.size(), meta, book, local_ts_us, flags);
+  }
+
+} // namespace aether
@@ -0,0 +1,91 @@
+#pragma once
+// latency_stats.h
+// Fixed-size log-linear latency histogram. record() is a clz, two shifts and an
+// increment, so it can sit on the hot path; percentiles are bucket lower bounds
+// (within ~6% of the true value). Values are unitless (callers use ns or us).
+
+#include <cstdint>
+#include <cstring>
+
+namespace aether {
+
+  class LatencyHistogram {
+    public:
+      static constexpr int SUB_BITS = 4;                 // 16 sub-buckets per power of two
+      static constexpr int SUB = 1 << SUB_BITS;
+      static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+      LatencyHistogram() { reset(); }
+
+      void reset() {
+        std::memset(counts_, 0, sizeof(counts_));
+        count_ = sum_ = max_ = 0;
+        min_ = UINT64_MAX;
+      }
+
+      void record(uint64_t v) {
+        ++counts_[index_of(v)];
+        ++count_;
+        sum_ += v;
+        if (v > max_) max_ = v;
+        if (v < min_) min_ = v;
+      }
+
+      void merge(const LatencyHistogram &o) {
+        for (int i = 0; i < BUCKETS; ++i) counts_[i] += o.counts_[i];
+        count_ += o.count_;
+        sum_ += o.sum_;
+        if (o.max_ > max_) max_ = o.max_;
+        if (o.min_ < min_) min_ = o.min_;
+      }
+
+      uint64_t count() const noexcept { return count_; }
+      uint64_t max() const noexcept { return max_; }
+      uint64_t min() const noexcept { return count_ ? min_ : 0; }
+      double mean() const noexcept { return count_ ? double(sum_) / double(count_) : 0.0; }
+
+      // rebuild from raw bucket counts, e.g. a copy of a stats::SharedHistogram
+      void assign(const uint64_t *buckets, uint64_t sum, uint64_t min, uint64_t max) {
+        count_ = 0;
+        for (int i = 0; i < BUCKETS; ++i) count_ += counts_[i] = buckets[i];
+        sum_ = sum;
+        min_ = count_ ? min : UINT64_MAX;
+        max_ = max;
+      }
+
+      // p in [0, 100]
+      uint64_t percentile(double p) const {
+        if (!count_) return 0;
+        uint64_t rank = uint64_t(p / 100.0 * double(count_));
+        if (rank >= count_) rank = count_ - 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+          seen += counts_[i];
+          if (seen > rank) {
+            uint64_t v = value_of(i);
+            return v > max_ ? max_ : v;
+          }
+        }
+        return max_;
+      }
+
+      // bucket layout, shared with stats::SharedHistogram
+      static int index_of(uint64_t v) {
+        if (v < uint64_t(SUB)) return int(v);
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - SUB_BITS;
+        return ((shift + 1) << SUB_BITS) + int((v >> shift) & (SUB - 1));
+      }
+      static uint64_t value_of(int i) {
+        if (i < SUB) return uint64_t(i);
+        int shift = (i >> SUB_BITS) - 1;
+        return (uint64_t(SUB) + uint64_t(i & (SUB - 1))) << shift;
+      }
+
+    private:
+
+      uint64_t counts_[BUCKETS];
+      uint64_t count_, sum_, max_, min_;
+  };
+
+} // namespace aether
@@ -0,0 +1,75 @@
+#pragma once
+// live_feed.h
+// FeedSource backed by the Binance WS depth stream and REST snapshots. All network
+// I/O runs on a NetLoop shared with the rest of the process. Snapshot requests are
+// coroutines on that loop, paced by one SnapshotScheduler (snapshot_scheduler.h).
+
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "capture.h"
+#include "feed_source.h"
+#include "net_loop.h"
+#include "rest_client.h"
+#include "snapshot_scheduler.h"
+#include "stats_shm.h"
+#include "symbol_router.h"
+
+struct LiveFeedConfig {
+  std::vector<std::string> symbols;        // as given on the command line
+  std::string update_speed;                // "" or "100ms"
+  aether::Endpoint ws{"stream.binance.com", "9443", true};
+  aether::Endpoint rest{"api.binance.com", "443", true};
+  uint32_t snapshot_limit = 5000;          // levels per side (request weight 250)
+  aether::SnapshotSchedulerConfig snapshots;
+};
+
+class LiveFeed : public aether::FeedSource {
+  public:
+    LiveFeed(aether::NetLoop &loop, const LiveFeedConfig &cfg);
+    ~LiveFeed() override;
+
+    // exchangeInfo for all symbols (one request)
+    std::string exchange_info() override;
+    // single-symbol stream (the first symbol)
+    void start(const aether::DecimalScale &scale, EventQueue &queue, std::atomic<bool> &stop) override;
+    // combined stream of all symbols, routed to the shard queues by router
+    void start_combined(const aether::SymbolRouter &router, std::atomic<bool> &stop);
+    // blocking, for threads other than the loop's; paced like request_snapshot
+    bool fetch_snapshot(const std::string &symbol, std::string &body) override;
+    // spawns the fetch on the loop and returns
+    void request_snapshot(std::shared_ptr<aether::SnapshotRequest> req, int delay_ms) override;
+    // waits for the stream to end (cancel the loop to end it)
+    void join() override;
+
+    aether::RestClientStats rest_stats() { return rest_.stats(); }
+    aether::SnapshotSchedulerStats snapshot_stats();
+
+    // raw capture of WS frames and REST bodies; set before start()
+    void set_capture(aether::CaptureChannel *ws, aether::CaptureChannel *rest) {
+      ws_capture_ = ws;
+      rest_capture_ = rest;
+    }
+
+    // frame counters of the reader (written on the loop thread); set before start()
+    void set_stats(aether::stats::StatsBlock *stats) { stats_ = stats; }
+
+  private:
+    std::string get(const std::string &target, uint8_t kind);
+    void record(uint8_t kind, const std::string &body);
+    std::string depth_target(const std::string &symbol) const;
+    boost::asio::awaitable<void> fetch(std::shared_ptr<aether::SnapshotRequest> req, int delay_ms);
+
+    aether::NetLoop &loop_;
+    LiveFeedConfig cfg_;
+    aether::RestClient rest_;                // keep-alive pool for exchangeInfo and snapshots
+    aether::SnapshotScheduler snapshots_;    // loop thread
+    std::vector<std::string> symbols_;       // lower-case, for stream names
+    std::vector<std::string> symbols_upper_;
+    std::future<void> reader_;
+    aether::CaptureChannel *ws_capture_ = nullptr;
+    aether::CaptureChannel *rest_capture_ = nullptr;
+    aether::stats::StatsBlock *stats_ = nullptr;
+    std::mutex rest_capture_mu_;             // exchangeInfo is fetched off the loop
+};
@@ -0,0 +1,166 @@
+#pragma once
+// log.h
+// Asynchronous binary logger for the hot threads. A log statement checks the runtime
+// level (one relaxed load), then copies a small record into its thread's lock-free
+// buffer: level, TSC stamp, the address of the format string and the raw argument
+// bytes. Formatting and I/O happen on the logger thread, which drains every thread's
+// buffer, renders "{}" placeholders and writes to stderr or a file in large writes.
+//
+//   AETHER_LOG_INFO("[pipeline] {} synced in {}us", symbol, took);
+//   AETHER_LOG_EVERY(log::Warn, 10, "[ws_reader] slow consumer, queue={}", depth);
+//
+// Arguments may be integers, bools, enums, floating point and strings (copied).
+// A full buffer drops the record and counts it; the hot thread never waits. Before
+// start() and after stop() records are formatted inline to stderr, so tools that never
+// start the logger still see messages.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "runtime.h"
+
+namespace aether { namespace log {
+
+  enum Level : int { Debug, Info, Warn, Error, Off };
+
+  struct Config {
+    std::string path;                    // empty = stderr
+    Level level = Info;
+    size_t thread_buffer_bytes = 1 << 20; // per producing thread
+    uint32_t poll_interval_us = 1000;    // logger thread sleep when every buffer is empty
+    rt::ThreadPolicy thread;             // logger thread placement
+  };
+
+  // starts the logger thread; false if the output file cannot be opened (logged)
+  bool start(const Config &cfg);
+  // drains every buffer, writes a drop summary if records were lost, joins the thread
+  void stop();
+
+  extern std::atomic<int> g_level;
+  inline bool enabled(Level l) noexcept { return int(l) >= g_level.load(std::memory_order_relaxed); }
+  inline void set_level(Level l) noexcept { g_level.store(int(l), std::memory_order_relaxed); }
+  // "debug", "info", "warn", "error", "off"
+  bool parse_level(const std::string &s, Level &out);
+
+  uint64_t dropped();      // records lost to full thread buffers
+  uint64_t suppressed();   // records skipped by AETHER_LOG_EVERY limits
+
+  // -- record encoding (used by the macros) --
+
+  using FormatFn = void (*)(std::string &out, const char *fmt, const uint8_t *args);
+
+  // payload space for a record, nullptr if the thread's buffer is full (counted)
+  uint8_t *reserve(size_t args_bytes, Level level, FormatFn fn, const char *fmt);
+  void commit();
+
+  namespace detail {
+
+    template <class T>
+    using arg_t = std::remove_cv_t<std::remove_reference_t<T>>;
+
+    template <class T>
+    constexpr bool is_text = std::is_convertible_v<const T&, std::string_view>;
+
+    template <class T>
+    size_t arg_size(const T &v) {
+      if constexpr (is_text<T>) return sizeof(uint32_t) + std::string_view(v).size();
+      else return 8;
+    }
+
+    template <class T>
+    uint8_t *arg_put(uint8_t *p, const T &v) {
+      if constexpr (is_text<T>) {
+        std::string_view s(v);
+        uint32_t n = uint32_t(s.size());
+        std::memcpy(p, &n, sizeof(n));
+        std::memcpy(p + sizeof(n), s.data(), n);
+        return p + sizeof(n) + n;
+      } else if constexpr (std::is_floating_point_v<T>) {
+        double d = double(v);
+        std::memcpy(p, &d, 8);
+        return p + 8;
+      } else if constexpr (std::is_enum_v<T>) {
+        int64_t i = int64_t(v);
+        std::memcpy(p, &i, 8);
+        return p + 8;
+      } else {
+        static_assert(std::is_integral_v<T>, "log arguments: integers, floats, enums, bools or strings");
+        if constexpr (std::is_signed_v<T>) {
+          int64_t i = int64_t(v);
+          std::memcpy(p, &i, 8);
+        } else {
+          uint64_t u = uint64_t(v);
+          std::memcpy(p, &u, 8);
+        }
+        return p + 8;
+      }
+    }
+
+    // append fmt up to the next "{}", then the argument; advances fmt and p
+    void put_text(std::string &out, const char *&fmt, const uint8_t *&p);
+    void put_signed(std::string &out, const char *&fmt, const uint8_t *&p);
+    void put_unsigned(std::string &out, const char *&fmt, const uint8_t *&p);
+    void put_bool(std::string &out, const char *&fmt, const uint8_t *&p);
+    void put_double(std::string &out, const char *&fmt, const uint8_t *&p);
+
+    template <class T>
+    void arg_format(std::string &out, const char *&fmt, const uint8_t *&p) {
+      if constexpr (is_text<T>) put_text(out, fmt, p);
+      else if constexpr (std::is_same_v<T, bool>) put_bool(out, fmt, p);
+      else if constexpr (std::is_floating_point_v<T>) put_double(out, fmt, p);
+      else if constexpr (std::is_enum_v<T> || std::is_signed_v<T>) put_signed(out, fmt, p);
+      else put_unsigned(out, fmt, p);
+    }
+
+    template <class... A>
+    void format_record(std::string &out, const char *fmt, [[maybe_unused]] const uint8_t *p) {
+      (arg_format<A>(out, fmt, p), ...);
+      out += fmt;
+    }
+
+    template <class... A>
+    void write(Level level, const char *fmt, const A &...args) {
+      size_t n = (size_t(0) + ... + arg_size(args));
+      uint8_t *p = reserve(n, level, &format_record<arg_t<A>...>, fmt);
+      if (!p) return;
+      ((p = arg_put(p, args)), ...);
+      commit();
+    }
+
+    // at most per_sec records per second from one call site
+    class RateLimit {
+      public:
+        explicit RateLimit(uint32_t per_sec) : per_sec_(per_sec) {}
+        bool allow();
+      private:
+        uint32_t per_sec_;
+        std::atomic<int64_t> window_{0};   // steady_clock seconds
+        std::atomic<uint32_t> count_{0};
+    };
+
+  } // namespace detail
+
+}} // namespace aether::log
+
+#define AETHER_LOG(lvl, fmt, ...) \
+  do { \
+    if (::aether::log::enabled(lvl)) ::aether::log::detail::write(lvl, fmt __VA_OPT__(,) __VA_ARGS__); \
+  } while (0)
+
+#define AETHER_LOG_DEBUG(fmt, ...) AETHER_LOG(::aether::log::Debug, fmt __VA_OPT__(,) __VA_ARGS__)
+#define AETHER_LOG_INFO(fmt, ...) AETHER_LOG(::aether::log::Info, fmt __VA_OPT__(,) __VA_ARGS__)
+#define AETHER_LOG_WARN(fmt, ...) AETHER_LOG(::aether::log::Warn, fmt __VA_OPT__(,) __VA_ARGS__)
+#define AETHER_LOG_ERROR(fmt, ...) AETHER_LOG(::aether::log::Error, fmt __VA_OPT__(,) __VA_ARGS__)
+
+// rate-limited per call site; skipped records are counted in log::suppressed()
+#define AETHER_LOG_EVERY(lvl, per_sec, fmt, ...) \
+  do { \
+    if (::aether::log::enabled(lvl)) { \
+      static ::aether::log::detail::RateLimit aether_log_rl_(per_sec); \
+      if (aether_log_rl_.allow()) ::aether::log::detail::write(lvl, fmt __VA_OPT__(,) __VA_ARGS__); \
+    } \
+  } while (0)
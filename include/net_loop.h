@@ -0,0 +1,79 @@
+#pragma once
+// net_loop.h
+// One io_context on one thread drives every WS stream and REST request. Connections
+// are C++20 coroutines (boost::asio::awaitable); stop is a cancellation that closes
+// every open connection, so no reader polls a flag between reads.
+
+// Boost 1.74's awaitable.hpp uses std::exchange without including <utility>
+#include <utility>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include "runtime.h"
+
+namespace aether {
+
+  // where a feed connects; parsed from ws://, wss://, http:// or https:// URLs
+  struct Endpoint {
+    std::string host;
+    std::string port;
+    bool tls = true;
+  };
+
+  // "wss://host[:port]" etc. Default ports: 443 for wss/https, 80 for ws/http.
+  bool parse_endpoint(const std::string &url, Endpoint &out);
+
+  class NetLoop {
+    public:
+      NetLoop();
+      ~NetLoop();
+
+      // runs the io_context on its own thread, placed per policy
+      void start(const rt::ThreadPolicy &policy = {});
+      // closes every open connection; their coroutines finish with operation_aborted.
+      // Thread-safe and idempotent.
+      void cancel();
+      // cancel() and join the loop thread
+      void stop();
+
+      bool cancelled() const noexcept { return cancelled_.load(std::memory_order_acquire); }
+      // false once the loop thread has returned (work spawned now would never run)
+      bool running() const noexcept { return running_.load(std::memory_order_acquire); }
+      boost::asio::io_context &context() noexcept { return ioc_; }
+      boost::asio::ssl::context &tls() noexcept { return tls_; }
+
+      // Loop thread only: a connection registers how to close itself while it is open.
+      // Throws operation_aborted if the loop is already cancelled.
+      class CancelScope {
+        public:
+          CancelScope(NetLoop &loop, std::function<void()> close);
+          ~CancelScope();
+          CancelScope(const CancelScope &) = delete;
+          CancelScope &operator=(const CancelScope &) = delete;
+        private:
+          NetLoop &loop_;
+          uint64_t id_;
+      };
+
+    private:
+      boost::asio::io_context ioc_;
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_;
+      boost::asio::ssl::context tls_;
+      std::thread thread_;
+      std::atomic<bool> cancelled_{false};
+      std::atomic<bool> running_{false};
+      // loop-thread state
+      uint64_t next_id_ = 0;
+      std::unordered_map<uint64_t, std::function<void()>> open_;
+  };
+
+} // namespace aether
@@ -1,55 +1,102 @@
 #pragma once
 // orderbook.h
-// Simple L2 order book with apply logic per Binance diff rules
+// Simple L2 order book with apply logic per Binance diff rules.
+// Level storage is a compile-time policy (see price_ladder.h):
+//   OrderBook       = BasicOrderBook<MapLevels>    (std::map per side)
+//   LadderOrderBook = BasicOrderBook<LadderLevels> (tick-indexed ladder + bitmap)
 
-#include <map>
 #include <cstdint>
+#include <string_view>
 #include <nlohmann/json.hpp>
+#include "book_types.h"
+#include "decimal.h"
+#include "depth_decoder.h"
+#include "price_ladder.h"
 
 namespace aether {
 
-  using PriceT = int64_t;
-  using SizeT  = int64_t;
-
-  // comparator: bids descending, asks ascending
-  using BidsMap = std::map<PriceT, SizeT, std::greater<PriceT>>;
-  using AsksMap = std::map<PriceT, SizeT, std::less<PriceT>>;
-
-  class OrderBook {
+  template <class Levels>
+  class BasicOrderBook {
     public:
-      OrderBook();
-      ~OrderBook();
+      using BidSide = typename Levels::template Side<true>;
+      using AskSide = typename Levels::template Side<false>;
+      using SideConfig = typename BidSide::Config;
+
+      explicit BasicOrderBook(const DecimalScale &scale = DecimalScale{},
+          const SideConfig &side_cfg = SideConfig{});
+      ~BasicOrderBook();
 
       // Build from REST snapshot JSON (throws on bad format)
       void setFromSnapshot(const nlohmann::json &snapshot);
 
-      // Apply a single depthUpdate event. Returns:
+      // Apply a single decoded depthUpdate. Returns:
       //  - true  => event applied (or ignored if older than current)
       //  - false => gap detected (caller should resync)
-      bool applyEvent(const nlohmann::json &depthUpdate);
+      bool applyEvent(const DepthDelta &delta);
+
+      // Track cumulative quantity and notional of the best n levels per side (0 = off,
+      // the default). The sums follow each level change in applyEvent from the touched
+      // level alone, plus one neighbour lookup when the n-th level changes.
+      void setAnalyticsDepth(size_t n);
+      size_t analyticsDepth() const noexcept { return depth_n_; }
+      // BBO-derived figures and the top-n sums, O(1)
+      BookAnalytics analytics() const;
+
+      // Preallocate storage for n levels per side on an empty book, so a book that
+      // stays within n levels never allocates while applying events.
+      void reserveLevels(size_t n);
 
       // Accessors
       uint64_t lastUpdateId() const noexcept;
       size_t totalLevels() const noexcept;
+      const DecimalScale &scale() const noexcept { return scale_; }
 
       // Convenience
       bool bestBid(PriceT &price_out, SizeT &size_out) const;
       bool bestAsk(PriceT &price_out, SizeT &size_out) const;
 
+      // best-first walk of one side; f(price, qty) returns false to stop
+      template <class F> void forEachBid(F &&f) const { bids_.visit(std::forward<F>(f)); }
+      template <class F> void forEachAsk(F &&f) const { asks_.visit(std::forward<F>(f)); }
+
+      const BidSide &bids() const noexcept { return bids_; }
+      const AskSide &asks() const noexcept { return asks_; }
+
       // debug
       void printTop(int n = 10) const;
 
     private:
-      BidsMap bids_;
-      AsksMap asks_;
+      // running sum over the best depth_n_ levels of one side
+      struct DepthSum {
+        size_t levels = 0;      // levels in the sum (<= depth_n_)
+        PriceT edge = 0;        // worst price in the sum
+        SizeT qty = 0;
+        __int128 notional = 0;  // exact: price * qty overflows 64 bits
+      };
+
+      BidSide bids_;
+      AskSide asks_;
       uint64_t last_update_id_;
+      DecimalScale scale_;
+      size_t depth_n_ = 0;
+      DepthSum bid_sum_, ask_sum_;
+
+      template <class Side> void resetSum(const Side &side, DepthSum &s) const;
+      template <class Side> void trackLevel(const Side &side, DepthSum &s, PriceT p, SizeT old_q, SizeT q) const;
 
-      static PriceT parsePriceScaled(const std::string &ps);
-      static SizeT  parseSizeScaled(const std::string &qs);
+      PriceT parsePriceScaled(std::string_view ps) const;
+      SizeT  parseSizeScaled(std::string_view qs) const;
 
       // non-copyable
-      OrderBook(const OrderBook&) = delete;
-      OrderBook& operator=(const OrderBook&) = delete;
+      BasicOrderBook(const BasicOrderBook&) = delete;
+      BasicOrderBook& operator=(const BasicOrderBook&) = delete;
   };
 
+  // instantiated in orderbook.cpp
+  extern template class BasicOrderBook<MapLevels>;
+  extern template class BasicOrderBook<LadderLevels>;
+
+  using OrderBook = BasicOrderBook<MapLevels>;
+  using LadderOrderBook = BasicOrderBook<LadderLevels>;
+
 } // namespace aether
@@ -0,0 +1,204 @@
+#pragma once
+// pipeline.h
+// Book-thread side of aether: snapshot bootstrap, diff application and frame
+// publishing (ring + WAL). Shared by the live binary and aether_replay so both run
+// exactly the same code; only the FeedSource differs.
+//
+// On a sequence gap the pipeline resyncs in place instead of giving up: it publishes
+// a RESYNC frame, keeps draining the feed into a buffer while the source fetches a
+// fresh snapshot (SnapshotSource::request_snapshot), then rebuilds the book, publishes a SNAPSHOT frame and
+// replays the buffered deltas. The feed connection and the ring stay open throughout.
+//
+// While live, the pipeline also publishes CHECKPOINT snapshots (SNAPSHOT frames with
+// AETHER_FRAME_FLAG_CHECKPOINT) every checkpoint_ms / checkpoint_events, so a consumer
+// that attaches after startup finds a recent book in the ring. A checkpoint is encoded
+// straight into a ring reservation at a batch boundary, preferably one with nothing
+// queued behind it: no copy, no allocation, and readers keep the previous one until
+// the commit.
+//
+// With conflation on (always, or while the slowest ring reader lags), ring deltas are
+// merged per price level over a short window and published as one CONFLATED frame
+// covering U..u; the WAL still receives every delta.
+//
+// With analytics_depth set, the book keeps top-N sums as it applies levels and every
+// DEPTH_UPDATE / SNAPSHOT frame carries an analytics trailer (AETHER_FRAME_FLAG_ANALYTICS)
+// with the book's mid, microprice, spread, imbalance and cumulative depth after it.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "alloc_count.h"
+#include "book_view.h"
+#include "conflator.h"
+#include "event_queue.h"
+#include "feed_source.h"
+#include "frame_codec.h"
+#include "latency_stats.h"
+#include "orderbook.h"
+#include "ring_mmap.h"
+#include "stats_shm.h"
+#include "wal.h"
+
+namespace aether {
+
+  struct PipelineConfig {
+    std::string symbol;                // upper-case; stamped into frames as symbol_id
+    ring::RingHandle *ring = nullptr;  // optional sinks
+    wal::WalWriter *wal = nullptr;
+    view::BookViewWriter *view = nullptr; // top-N seqlock view, rewritten after every applied event
+    bool verbose = true;               // per-event log lines and top-of-book prints
+    bool measure = false;              // per-stage latency histograms
+    stats::StatsBlock *stats = nullptr; // live counters and TSC stage latencies (book thread's block)
+    bool resync = true;                // recover from gaps in place (else run() returns Gap)
+    size_t resync_max_buffered = 1 << 20; // deltas held while waiting for a snapshot
+    uint32_t checkpoint_ms = 0;        // CHECKPOINT frame at most this often (0 = no timer)
+    uint64_t checkpoint_events = 0;    // ... or after this many applied events (0 = no count)
+    // a deep book is checkpointed less often: a checkpoint of B bytes waits at least
+    // B / checkpoint_bytes_per_s after the last one (0 = no floor)
+    uint64_t checkpoint_bytes_per_s = 0;
+    ConflateMode conflate = ConflateMode::Off; // merge ring deltas (needs a ring)
+    uint32_t conflate_ms = 10;         // a window closes after this long ...
+    uint32_t conflate_events = 0;      // ... or after this many deltas (0 = time only)
+    uint32_t conflate_lag_pct = 50;    // OnLag: on above this reader lag (% of ring), off below half
+    uint32_t analytics_depth = 0;      // levels per side summed in the frames' analytics trailer (0 = no trailer)
+    size_t book_reserve_levels = 0;    // BasicOrderBook::reserveLevels at construction
+    // level storage of the resync buffer's events, as EventQueue::prewarm gives the queue
+    // slots: buffering swaps an event with its slot, which must come back just as warm
+    size_t prewarm_levels = 0;
+    size_t resync_prewarm_events = 256; // resync buffer events reserved at construction (with prewarm_levels)
+  };
+
+  enum class BootstrapStatus {
+    Ok,
+    NoCoverage,   // buffered events do not cover snapshot+1
+    Gap,          // gap while applying the buffered events
+    EndOfStream   // the source ended before the book could be built
+  };
+
+  enum class RunStatus {
+    Stopped,
+    Gap,          // gap and resync disabled, or no snapshot could be had
+    EndOfStream
+  };
+
+  struct PipelineStats {
+    uint64_t applied = 0;           // events applied to the book (bootstrap + live)
+    uint64_t stale = 0;             // live events already covered by the book
+    uint64_t published = 0;         // frames handed to the ring/WAL
+    uint64_t publish_failures = 0;
+    LatencyHistogram queue_us;      // receive -> dequeue (us)
+    LatencyHistogram apply_ns;      // applyEvent
+    LatencyHistogram publish_ns;    // encode + commit
+    uint64_t resyncs = 0;           // gaps recovered in place
+    uint64_t resync_retries = 0;    // snapshots that did not fit the buffered deltas
+    LatencyHistogram resync_us;     // gap detected -> book live again
+    uint64_t checkpoints = 0;       // CHECKPOINT frames published
+    LatencyHistogram checkpoint_ns; // encode + commit of one checkpoint
+    uint64_t conflated_frames = 0;  // CONFLATED frames published
+    uint64_t conflated_deltas = 0;  // deltas merged into them
+    // AETHER_COUNT_ALLOCS builds: operator new calls on the book thread for live events
+    // and batch ends, the events that allocated, and the `applied` count at the last one
+    uint64_t allocs = 0;
+    uint64_t alloc_events = 0;
+    uint64_t last_alloc_event = 0;
+    uint64_t stopped = 0;           // engine totals: pipelines parked because they could not continue
+  };
+
+  template <class Book>
+  class BasicPipeline {
+    public:
+      BasicPipeline(const PipelineConfig &cfg, const DecimalScale &scale);
+      ~BasicPipeline();
+
+      // Binance bootstrap: wait for buffered events, fetch a snapshot that covers
+      // them, build the book, publish its SNAPSHOT frame, then apply and publish
+      // the buffered events.
+      BootstrapStatus bootstrap(FeedSource &feed, EventQueue &queue);
+
+      // live loop; returns at the end of the stream, when stop is seen between
+      // batches, or on a gap it cannot recover from
+      RunStatus run(FeedSource &feed, EventQueue &queue, const std::atomic<bool> &stop);
+
+      // Event-level API for callers that multiplex several symbols on one queue
+      // (shard_engine.h). start_sync() begins like a resync without a previous book:
+      // events are buffered until a background snapshot covers them.
+      void start_sync(SnapshotSource &snaps);
+      // false when the pipeline cannot continue (end of stream, or a gap with resync off)
+      bool on_event(SnapshotSource &snaps, DepthEvent &ev);
+      // drives a pending (re)sync; false if no snapshot can be had
+      bool poll(SnapshotSource &snaps);
+      bool syncing() const noexcept { return resyncing_; }
+      // a conflation window is open: end_batch() must run again even without events
+      bool holding() const noexcept { return !conflator_.empty(); }
+      // makes the batch's frames visible (ring flush, WAL batch boundary). backlog is
+      // the number of events still queued: a due checkpoint waits for an idle boundary,
+      // but no longer than twice its interval.
+      void end_batch(size_t backlog = 0);
+      // publishes whatever is held back (an open conflation window); run() does this
+      // when it returns, multiplexing callers before they stop
+      void drain();
+
+      Book &book() noexcept { return book_; }
+      const std::string &symbol() const noexcept { return cfg_.symbol; }
+      const PipelineStats &stats() const noexcept { return stats_; }
+
+    private:
+      bool on_live_event(DepthEvent &ev);
+      bool buffer_event(DepthEvent &ev);
+      // discard buffered events covered by the snapshot, check coverage, rebuild the
+      // book, publish SNAPSHOT and apply the rest. for_each(f) hands every buffered
+      // event in order to f(DepthEvent&).
+      template <class ForEach>
+      BootstrapStatus rebuild(const nlohmann::json &snapshot, ForEach &&for_each);
+      void begin_resync(SnapshotSource &snaps, uint64_t gap_U);
+      void start_fetch(SnapshotSource &snaps, int delay_ms);
+      void cancel_fetch();
+      bool apply(const DepthEvent &ev, bool live = false);
+      bool publish_delta(const DepthEvent &ev);
+      bool publish_snapshot();
+      void publish_resync(uint64_t gap_U);
+      void publish_view();
+      void maybe_checkpoint(size_t backlog);
+      bool publish_checkpoint();
+      void update_conflation();
+      void flush_conflated();
+      // extra bytes per frame for the analytics trailer, and appending it
+      size_t trailer_size() const noexcept { return cfg_.analytics_depth ? sizeof(aether_analytics) : 0; }
+      size_t add_trailer(void *buf, size_t cap, size_t n, const BookAnalytics &a);
+      void log_top(int levels);
+      // allocations since `before` (mem::thread_allocs) into stats_
+      void note_allocs(uint64_t before, bool event);
+
+      PipelineConfig cfg_;
+      Book book_;
+      FrameMeta meta_;
+      std::vector<uint8_t> frame_buf_;
+      PipelineStats stats_;
+      RunStatus status_ = RunStatus::Stopped;
+      uint64_t live_ = 0;
+      bool synced_ = false;                  // built from a snapshot and not resyncing
+      uint64_t view_event_ms_ = 0;           // E of the last applied event
+      uint64_t checkpoint_at_ns_ = 0;        // last SNAPSHOT/CHECKPOINT published
+      uint64_t checkpoint_at_events_ = 0;    // stats_.applied at that point
+      Conflator conflator_;
+      bool conflating_ = false;
+      uint64_t lag_checked_ns_ = 0;
+      BookAnalytics window_analytics_;       // book after the open window's last delta
+
+      // resync state (book thread)
+      bool resyncing_ = false;
+      bool initial_sync_ = false;            // first sync via start_sync(), not a resync
+      uint64_t resync_start_us_ = 0;
+      std::vector<DepthEvent> resync_buf_;   // elements kept (with capacity) across resyncs
+      size_t resync_n_ = 0;
+      std::shared_ptr<SnapshotRequest> fetch_; // snapshot being fetched by the source
+  };
+
+  // instantiated in pipeline.cpp
+  extern template class BasicPipeline<OrderBook>;
+  extern template class BasicPipeline<LadderOrderBook>;
+
+} // namespace aether
@@ -0,0 +1,371 @@
+#pragma once
+// price_ladder.h
+// Book side storage policies for aether::BasicOrderBook.
+//  - MapSide:    std::map keyed by price (node per level, nodes from a per-side pool)
+//  - LadderSide: contiguous tick-indexed array around the touch, two-level occupancy
+//                bitmap for best-price tracking, std::map overflow for far levels.
+// Both expose: set(p, q) (q == 0 removes, returns the old qty), best(), size(), clear(),
+// visit(f), and the neighbour lookups qty_at(p), next_better(p) / next_worse(p) used to
+// keep the book's top-N sums (analytics) without walking the side.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <map>
+#include <memory_resource>
+#include <vector>
+#include "book_types.h"
+
+namespace aether {
+
+  // comparator: bids descending, asks ascending. Nodes come from a pool owned by the
+  // side: a removed level's node is reused by the next insert instead of going back to
+  // malloc, so a warm book does not allocate as levels come and go.
+  using BidsMap = std::pmr::map<PriceT, SizeT, std::greater<PriceT>>;
+  using AsksMap = std::pmr::map<PriceT, SizeT, std::less<PriceT>>;
+
+  struct MapConfig {};
+
+  struct LadderConfig {
+    size_t window_ticks = size_t(1) << 15; // per side, rounded up to a multiple of 4096
+  };
+
+  // insert and erase n placeholder levels on an empty pmr map: its pool keeps the
+  // freed nodes, so the first n real levels are served without touching the heap
+  template <class Map>
+  inline void reserve_nodes(Map &m, size_t n) {
+    if (!m.empty()) return;
+    for (size_t i = 0; i < n; ++i) m.emplace(PriceT(i), SizeT(0));
+    m.clear();
+  }
+
+  template <bool IsBid>
+  class MapSide {
+    public:
+      using Map = typename std::conditional<IsBid, BidsMap, AsksMap>::type;
+      using Config = MapConfig;
+
+      static constexpr bool is_bid = IsBid;
+
+      explicit MapSide(const Config & = Config{}) : levels_(&pool_) {}
+
+      void clear() { levels_.clear(); }
+
+      // grow the node pool to n levels (the nodes go back to the pool, not the heap)
+      void reserve(size_t n) { reserve_nodes(levels_, n); }
+
+      SizeT set(PriceT p, SizeT q) {
+        if (q == 0) {
+          auto it = levels_.find(p);
+          if (it == levels_.end()) return 0;
+          SizeT old = it->second;
+          levels_.erase(it);
+          return old;
+        }
+        auto [it, inserted] = levels_.try_emplace(p, q);
+        if (inserted) return 0;
+        SizeT old = it->second;
+        it->second = q;
+        return old;
+      }
+
+      SizeT qty_at(PriceT p) const {
+        auto it = levels_.find(p);
+        return it == levels_.end() ? 0 : it->second;
+      }
+
+      // nearest level strictly better / worse than p (p need not be a level)
+      bool next_better(PriceT p, PriceT &price_out, SizeT &size_out) const {
+        auto it = levels_.lower_bound(p);
+        if (it == levels_.begin()) return false;
+        --it;
+        price_out = it->first; size_out = it->second; return true;
+      }
+      bool next_worse(PriceT p, PriceT &price_out, SizeT &size_out) const {
+        auto it = levels_.upper_bound(p);
+        if (it == levels_.end()) return false;
+        price_out = it->first; size_out = it->second; return true;
+      }
+
+      bool best(PriceT &price_out, SizeT &size_out) const {
+        if (levels_.empty()) return false;
+        auto it = levels_.begin();
+        price_out = it->first; size_out = it->second; return true;
+      }
+
+      size_t size() const noexcept { return levels_.size(); }
+
+      // best-first; f(price, qty) returns false to stop
+      template <class F>
+      void visit(F &&f) const {
+        for (const auto &kv : levels_) {
+          if (!f(kv.first, kv.second)) return;
+        }
+      }
+
+    private:
+      std::pmr::unsynchronized_pool_resource pool_;   // before levels_: outlives its nodes
+      Map levels_;
+  };
+
+  template <bool IsBid>
+  class LadderSide {
+    public:
+      using Config = LadderConfig;
+      static constexpr bool is_bid = IsBid;
+
+      explicit LadderSide(const Config &cfg = Config{}) : overflow_(&pool_) {
+        size_t w = (cfg.window_ticks + 4095) & ~size_t(4095);
+        if (w == 0) w = 4096;
+        window_ = w;
+        qty_.assign(window_, 0);
+        words_.assign(window_ / 64, 0);
+        summary_.assign(window_ / 4096, 0);
+      }
+
+      void clear() {
+        if (count_) {
+          std::fill(qty_.begin(), qty_.end(), 0);
+          std::fill(words_.begin(), words_.end(), 0);
+          std::fill(summary_.begin(), summary_.end(), 0);
+        }
+        overflow_.clear();
+        count_ = 0;
+        best_ = NONE;
+      }
+
+      // the window is preallocated; only the overflow map has a pool to grow
+      void reserve(size_t n) { reserve_nodes(overflow_, n); }
+
+      SizeT set(PriceT p, SizeT q) {
+        if (count_ == 0 && q != 0 && !in_window(p)) recenter(p);
+        if (!in_window(p)) {
+          if (q != 0 && beyond_window(p)) {
+            recenter(p);
+          } else {
+            auto it = overflow_.find(p);
+            SizeT old = it == overflow_.end() ? 0 : it->second;
+            if (q != 0) overflow_[p] = q;
+            else if (old) overflow_.erase(it);
+            return old;
+          }
+        }
+        size_t i = size_t(p - base_);
+        SizeT old = qty_[i];
+        if (q != 0) {
+          if (old == 0) {
+            mark(i);
+            ++count_;
+            if (best_ == NONE || (IsBid ? i > best_ : i < best_)) best_ = i;
+          }
+          qty_[i] = q;
+          return old;
+        }
+        if (old == 0) return 0;
+        qty_[i] = 0;
+        unmark(i);
+        --count_;
+        if (i == best_) {
+          best_ = count_ == 0 ? NONE : (IsBid ? prev_set(i) : next_set(i));
+          if (count_ == 0 && !overflow_.empty()) recenter(overflow_.begin()->first);
+        }
+        return old;
+      }
+
+      SizeT qty_at(PriceT p) const {
+        if (in_window(p)) return qty_[size_t(p - base_)];
+        auto it = overflow_.find(p);
+        return it == overflow_.end() ? 0 : it->second;
+      }
+
+      // nearest level strictly better / worse than p (p need not be a level). Overflow
+      // only holds levels past the far edge, so it is worse than anything in the window.
+      bool next_better(PriceT p, PriceT &price_out, SizeT &size_out) const {
+        if (beyond_window(p)) return false;
+        size_t j;
+        if (in_window(p)) {
+          size_t i = size_t(p - base_);
+          j = IsBid ? next_set(i) : prev_set(i);
+        } else {
+          auto it = overflow_.lower_bound(p);
+          if (it != overflow_.begin()) {
+            --it;
+            price_out = it->first; size_out = it->second; return true;
+          }
+          // worst occupied index of the window (next_set(NONE) starts at 0)
+          j = IsBid ? next_set(NONE) : prev_set(window_);
+        }
+        if (j == NONE) return false;
+        price_out = base_ + PriceT(j); size_out = qty_[j]; return true;
+      }
+      bool next_worse(PriceT p, PriceT &price_out, SizeT &size_out) const {
+        if (beyond_window(p)) return best(price_out, size_out);
+        auto it = overflow_.begin();
+        if (in_window(p)) {
+          size_t i = size_t(p - base_);
+          size_t j = IsBid ? prev_set(i) : next_set(i);
+          if (j != NONE) {
+            price_out = base_ + PriceT(j); size_out = qty_[j]; return true;
+          }
+        } else {
+          it = overflow_.upper_bound(p);
+        }
+        if (it == overflow_.end()) return false;
+        price_out = it->first; size_out = it->second; return true;
+      }
+
+      bool best(PriceT &price_out, SizeT &size_out) const {
+        if (best_ != NONE) {
+          price_out = base_ + PriceT(best_); size_out = qty_[best_]; return true;
+        }
+        if (overflow_.empty()) return false;
+        auto it = overflow_.begin();
+        price_out = it->first; size_out = it->second; return true;
+      }
+
+      size_t size() const noexcept { return count_ + overflow_.size(); }
+
+      template <class F>
+      void visit(F &&f) const {
+        for (size_t i = best_; i != NONE; i = IsBid ? prev_set(i) : next_set(i)) {
+          if (!f(base_ + PriceT(i), qty_[i])) return;
+        }
+        for (const auto &kv : overflow_) {
+          if (!f(kv.first, kv.second)) return;
+        }
+      }
+
+      // diagnostics for benchmarks
+      size_t overflowLevels() const noexcept { return overflow_.size(); }
+      size_t recenters() const noexcept { return recenters_; }
+
+    private:
+      static constexpr size_t NONE = ~size_t(0);
+      using Overflow = typename std::conditional<IsBid, BidsMap, AsksMap>::type;
+
+      size_t window_ = 0;
+      PriceT base_ = 0;            // price of index 0
+      size_t count_ = 0;           // occupied levels inside the window
+      size_t best_ = NONE;         // index of best occupied level
+      size_t recenters_ = 0;
+      std::vector<SizeT> qty_;
+      std::vector<uint64_t> words_;   // bit per tick
+      std::vector<uint64_t> summary_; // bit per non-empty word
+      std::pmr::unsynchronized_pool_resource pool_;
+      Overflow overflow_;             // levels outside the window, always on the far side
+
+      bool in_window(PriceT p) const { return p >= base_ && p < base_ + PriceT(window_); }
+      static bool better(PriceT a, PriceT b) { return IsBid ? a > b : a < b; }
+      // past the window's better edge
+      bool beyond_window(PriceT p) const { return better(p, base_ + (IsBid ? PriceT(window_) - 1 : 0)); }
+
+      void mark(size_t i) {
+        words_[i >> 6] |= uint64_t(1) << (i & 63);
+        summary_[i >> 12] |= uint64_t(1) << ((i >> 6) & 63);
+      }
+      void unmark(size_t i) {
+        uint64_t &w = words_[i >> 6];
+        w &= ~(uint64_t(1) << (i & 63));
+        if (w == 0) summary_[i >> 12] &= ~(uint64_t(1) << ((i >> 6) & 63));
+      }
+
+      // highest occupied index < i, or NONE
+      size_t prev_set(size_t i) const {
+        if (i == 0) return NONE;
+        --i;
+        size_t wi = i >> 6;
+        uint64_t w = words_[wi] & (~uint64_t(0) >> (63 - (i & 63)));
+        if (w) return (wi << 6) + 63 - size_t(__builtin_clzll(w));
+        if (wi == 0) return NONE;
+        --wi;
+        for (size_t si = wi >> 6;; --si) {
+          uint64_t s = summary_[si];
+          if (si == (wi >> 6)) s &= ~uint64_t(0) >> (63 - (wi & 63));
+          if (s) {
+            size_t w2 = (si << 6) + 63 - size_t(__builtin_clzll(s));
+            return (w2 << 6) + 63 - size_t(__builtin_clzll(words_[w2]));
+          }
+          if (si == 0) return NONE;
+        }
+      }
+
+      // lowest occupied index > i, or NONE
+      size_t next_set(size_t i) const {
+        ++i;
+        if (i >= window_) return NONE;
+        size_t wi = i >> 6;
+        uint64_t w = words_[wi] & (~uint64_t(0) << (i & 63));
+        if (w) return (wi << 6) + size_t(__builtin_ctzll(w));
+        ++wi;
+        if (wi >= words_.size()) return NONE;
+        for (size_t si = wi >> 6; si < summary_.size(); ++si) {
+          uint64_t s = summary_[si];
+          if (si == (wi >> 6)) s &= ~uint64_t(0) << (wi & 63);
+          if (s) {
+            size_t w2 = (si << 6) + size_t(__builtin_ctzll(s));
+            return (w2 << 6) + size_t(__builtin_ctzll(words_[w2]));
+          }
+        }
+        return NONE;
+      }
+
+      // Move the window so p lands a quarter-window in from the better edge. Levels that
+      // fall off the far edge go to overflow; overflow levels now inside come back in.
+      void recenter(PriceT p) {
+        ++recenters_;
+        PriceT quarter = PriceT(window_ / 4);
+        PriceT new_base = IsBid ? p - (PriceT(window_) - quarter) : p - quarter;
+        if (count_) {
+          PriceT shift = new_base - base_;
+          if (shift > -PriceT(window_) && shift < PriceT(window_)) {
+            for (size_t i = best_; i != NONE; i = IsBid ? prev_set(i) : next_set(i)) {
+              PriceT price = base_ + PriceT(i);
+              if (price < new_base || price >= new_base + PriceT(window_)) overflow_[price] = qty_[i];
+            }
+            size_t n = window_ - size_t(shift < 0 ? -shift : shift);
+            if (shift > 0) std::copy(qty_.begin() + shift, qty_.begin() + shift + n, qty_.begin());
+            else if (shift < 0) std::copy_backward(qty_.begin(), qty_.begin() + n, qty_.end());
+            if (shift > 0) std::fill(qty_.begin() + n, qty_.end(), 0);
+            else if (shift < 0) std::fill(qty_.begin(), qty_.begin() + (window_ - n), 0);
+          } else {
+            for (size_t i = best_; i != NONE; i = IsBid ? prev_set(i) : next_set(i))
+              overflow_[base_ + PriceT(i)] = qty_[i];
+            std::fill(qty_.begin(), qty_.end(), 0);
+          }
+        }
+        base_ = new_base;
+        // overflow is ordered best-first and lies past the far edge, so the levels
+        // that are now inside the window form a prefix
+        while (!overflow_.empty() && in_window(overflow_.begin()->first)) {
+          auto it = overflow_.begin();
+          qty_[size_t(it->first - base_)] = it->second;
+          overflow_.erase(it);
+        }
+        rebuild_bits();
+      }
+
+      void rebuild_bits() {
+        std::fill(words_.begin(), words_.end(), 0);
+        std::fill(summary_.begin(), summary_.end(), 0);
+        count_ = 0;
+        best_ = NONE;
+        for (size_t i = 0; i < window_; ++i) {
+          if (qty_[i] == 0) continue;
+          mark(i);
+          ++count_;
+          if (IsBid || best_ == NONE) best_ = i;
+        }
+      }
+  };
+
+  struct MapLevels {
+    template <bool IsBid> using Side = MapSide<IsBid>;
+  };
+
+  struct LadderLevels {
+    template <bool IsBid> using Side = LadderSide<IsBid>;
+  };
+
+} // namespace aether
@@ -0,0 +1,70 @@
+#pragma once
+// replay_feed.h
+// FeedSource over a recorded feed, for offline benchmarks and regression runs.
+// Input is a block-compressed capture file (capture.h) or a text recording.
+//
+// Text recording (one record per line):
+//   W <recv_us> <raw WS frame JSON>
+//   S <recv_us> <REST depth snapshot body>
+//   I <recv_us> <exchangeInfo body>            (optional, gives the decimal scale)
+// recv_us is the local monotonic receive time. Bare lines starting with '{' are WS
+// frames without a timestamp (the bench frame files), paced by their E field.
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "feed_source.h"
+#include "latency_stats.h"
+
+namespace aether {
+
+  // appends the records of a text recording; false if the file cannot be read
+  bool load_feed_text(const std::string &path, std::vector<FeedRecord> &out);
+  // capture file (capture.h) or text recording, by file magic
+  bool load_feed(const std::string &path, std::vector<FeedRecord> &out);
+
+  enum class ReplayPace {
+    Fast,     // as fast as the pipeline drains the queue
+    Recorded  // original inter-arrival times, divided by speed
+  };
+
+  class ReplayFeed : public FeedSource {
+    public:
+      ReplayFeed(std::vector<FeedRecord> records, ReplayPace pace, double speed = 1.0);
+      ~ReplayFeed() override;
+
+      std::string exchange_info() override;
+      void start(const DecimalScale &scale, EventQueue &queue, std::atomic<bool> &stop) override;
+      // successive calls return successive recorded snapshots (recordings hold one symbol)
+      bool fetch_snapshot(const std::string &symbol, std::string &body) override;
+      int retry_delay_ms() const override { return 0; }
+      void join() override;
+
+      // valid after join()
+      uint64_t frames() const noexcept { return frames_; }
+      uint64_t malformed() const noexcept { return malformed_; }
+      const LatencyHistogram &decode_ns() const noexcept { return decode_ns_; }
+      // AETHER_COUNT_ALLOCS builds: operator new calls while decoding, and the frame
+      // number of the last decode that allocated
+      uint64_t decode_allocs() const noexcept { return decode_allocs_; }
+      uint64_t last_decode_alloc() const noexcept { return last_decode_alloc_; }
+
+    private:
+      void run(DecimalScale scale, EventQueue &queue, std::atomic<bool> &stop);
+
+      std::vector<FeedRecord> records_;
+      ReplayPace pace_;
+      double speed_;
+      size_t next_snapshot_ = 0;
+      std::thread thread_;
+
+      uint64_t frames_ = 0;
+      uint64_t malformed_ = 0;
+      LatencyHistogram decode_ns_;
+      uint64_t decode_allocs_ = 0;
+      uint64_t last_decode_alloc_ = 0;
+  };
+
+} // namespace aether
@@ -1,13 +1,88 @@
 #pragma once
 // rest_client.h
-// simple synchronous HTTPS GET using Boost.Beast + OpenSSL
+// HTTP(S) GET client for one host on the shared NetLoop (Boost.Beast + OpenSSL).
+// Keeps a small pool of persistent HTTP/1.1 keep-alive connections, caches the DNS
+// result and resumes TLS sessions, so a snapshot request after the first one costs a
+// round trip rather than DNS + TCP + full TLS handshake. Concurrent requests each take a
+// pooled connection; past max_connections they queue.
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
-#include <boost/asio/io_context.hpp>
-#include <boost/asio/ssl/context.hpp>
-
-std::string https_get_sync(boost::asio::io_context &ioc,
-    boost::asio::ssl::context &ctx,
-    const std::string &host,
-    const std::string &port,
-    const std::string &target);
+#include <vector>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include "net_loop.h"
+
+typedef struct ssl_session_st SSL_SESSION;
+
+namespace aether {
+
+  struct HttpResponse {
+    unsigned status = 0;
+    std::string body;
+    uint32_t retry_after_s = 0;     // Retry-After (429, 418, 503), 0 if absent
+    uint32_t used_weight = 0;       // Binance X-MBX-USED-WEIGHT-1M, 0 if absent
+  };
+
+  struct RestClientConfig {
+    size_t max_connections = 4;                            // per client (= per host)
+    std::chrono::milliseconds timeout{10000};              // connect + TLS + one exchange
+    std::chrono::seconds idle_timeout{50};                 // drop pooled connections idle longer
+    std::chrono::seconds dns_ttl{300};
+  };
+
+  struct RestClientStats {
+    uint64_t requests = 0;
+    uint64_t connects = 0;          // new TCP connections
+    uint64_t reused = 0;            // requests served on a pooled connection
+    uint64_t tls_resumed = 0;       // handshakes that resumed a cached session
+    uint64_t dns_lookups = 0;
+  };
+
+  class RestClient {
+    public:
+      RestClient(NetLoop &loop, const Endpoint &ep, const RestClientConfig &cfg = RestClientConfig());
+      ~RestClient();
+      RestClient(const RestClient &) = delete;
+      RestClient &operator=(const RestClient &) = delete;
+
+      // Loop thread (coroutine). Throws boost::system::system_error on network errors,
+      // timeouts and cancellation. A request that fails on a reused connection (the
+      // server closed it while idle) is retried once on a fresh one.
+      boost::asio::awaitable<HttpResponse> get(const std::string &target);
+
+      // Blocking wrapper for threads other than the loop's. Returns the body of a 200
+      // response; throws on errors and on any other status.
+      std::string get_blocking(const std::string &target);
+
+      // snapshot of the counters (taken on the loop thread)
+      RestClientStats stats();
+
+    private:
+      struct Conn;
+
+      boost::asio::awaitable<std::unique_ptr<Conn>> acquire(bool fresh);
+      boost::asio::awaitable<std::unique_ptr<Conn>> connect();
+      boost::asio::awaitable<boost::asio::ip::tcp::resolver::results_type> resolve();
+      void release(std::unique_ptr<Conn> c, bool reusable);
+
+      NetLoop &loop_;
+      Endpoint ep_;
+      RestClientConfig cfg_;
+
+      // loop-thread state
+      std::vector<std::unique_ptr<Conn>> idle_;
+      size_t open_ = 0;
+      std::deque<boost::asio::steady_timer*> waiters_;   // requests waiting for a connection
+      boost::asio::ip::tcp::resolver::results_type dns_;
+      std::chrono::steady_clock::time_point dns_expiry_{};
+      bool resolving_ = false;
+      std::vector<boost::asio::steady_timer*> dns_waiters_;
+      SSL_SESSION *session_ = nullptr;                     // last resumable TLS session
+      RestClientStats stats_;
+  };
+
+} // namespace aether
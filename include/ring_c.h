@@ -0,0 +1,75 @@
+/* ring_c.h
+ * Plain C view of the ring_mmap consumer API (for cadenza's C/OCaml stubs).
+ * C++ code gets the same declarations from ring_mmap.h; only the shared types are
+ * defined here when compiled as C++.
+ *
+ * Typical reader loop:
+ *   int slot = ring_reader_register(ch);
+ *   ring_reader_seek_snapshot(ch, slot, NULL, 0);   (optional: start at the latest book)
+ *   ring_frame_view v;
+ *   for (;;) {
+ *     int rc = ring_read_next(ch, slot, &v);
+ *     if (rc == RING_READ_EMPTY) { wait a bit; continue; }
+ *     if (rc == RING_READ_LAPPED) { resync from the next SNAPSHOT; continue; }
+ *     ... use v.data[0 .. v.len) in place ...
+ *     if (!ring_frame_valid(ch, &v)) { the producer overwrote it meanwhile: discard, resync }
+ *   }
+ */
+#ifndef AETHER_RING_C_H
+#define AETHER_RING_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ring_read_next / ring_read_batch results */
+#define RING_READ_OK      1
+#define RING_READ_EMPTY   0
+#define RING_READ_LAPPED (-1)
+
+/* zero-copy view of one frame inside the mapping */
+typedef struct ring_frame_view {
+  uint64_t offset;     /* absolute offset of the frame (its generation stamp) */
+  uint64_t next;       /* absolute offset of the following frame */
+  const uint8_t *data; /* payload, 8-byte aligned, points into the shared mapping */
+  uint32_t len;        /* payload bytes */
+  uint8_t type;        /* AETHER_MSG_* */
+  uint8_t flags;
+  uint16_t reserved;
+} ring_frame_view;
+
+#ifndef __cplusplus
+struct RingHandleC;
+
+struct RingHandleC* ring_open(const char *path);
+void ring_close(struct RingHandleC* ch);
+uint64_t ring_get_head(struct RingHandleC* ch);
+uint64_t ring_get_tail(struct RingHandleC* ch);
+uint64_t ring_get_buf_size(struct RingHandleC* ch);
+
+int ring_reader_register(struct RingHandleC* ch);
+void ring_reader_deregister(struct RingHandleC* ch, int slot);
+uint64_t ring_reader_get_cursor(struct RingHandleC* ch, int slot);
+void ring_reader_set_cursor(struct RingHandleC* ch, int slot, uint64_t cursor);
+int ring_reader_check_lapped(struct RingHandleC* ch, int slot);
+
+/* next frame for this reader slot, advancing its cursor */
+int ring_read_next(struct RingHandleC* ch, int slot, ring_frame_view* out);
+/* up to max frames; returns count (0 = empty) or RING_READ_LAPPED (a lap after some
+ * frames is returned by the next call) */
+int ring_read_batch(struct RingHandleC* ch, int slot, ring_frame_view* out, int max);
+/* 1 if the frame was not overwritten up to now; call after consuming the view */
+int ring_frame_valid(struct RingHandleC* ch, const ring_frame_view* v);
+/* late joiners: cursor to the newest SNAPSHOT (of each listed symbol; n = 0 for any).
+ * 1 if found, 0 if the ring holds none (cursor untouched) */
+int ring_reader_seek_snapshot(struct RingHandleC* ch, int slot, const uint32_t* symbol_ids, size_t n);
+#endif
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* AETHER_RING_C_H */
@@ -1,13 +1,32 @@
 #pragma once
 // ring_mmap.h
-// Byte-framed mmap ring (producer API + C bindings).
-// Producer writes frames: [uint32_t len][uint8_t type][payload...]
-// len = (1 + payload_len). type: 1 = DEPTH_UPDATE, 2 = SNAPSHOT
+// Byte-framed mmap ring (producer + reader API, C bindings).
+// Frames are 8-byte aligned: [FrameHeader (16 bytes)][payload][pad to 8]
+//   FrameHeader = { uint32 len (payload bytes), uint8 type, uint8 flags, uint16 rsv,
+//                   uint64 seq (absolute offset of this frame = generation stamp) }
+// type: see AETHER_MSG_* in aether_frame.h
+//   (1/2 = legacy JSON depthUpdate/snapshot, 3/4 = binary DEPTH_UPDATE/SNAPSHOT)
+// A frame never straddles the end of the buffer: the producer writes WRAP_MARKER as
+// len and starts the frame at the next lap. Offsets (head, tail, reader cursors) are
+// absolute byte counts; position in the buffer is offset % buf_size.
+//
+// Layout v2 (one writer, many readers):
+//   [RingHeader][pad to 64][ProducerState: head, tail  (own cache line)]
+//   [ReaderSlot x max_readers (one cache line each)][pad to page][circular buffer]
+// tail is the producer's oldest intact frame. The producer advances it frame by frame
+// before overwriting and never looks at reader slots; a reader whose cursor is
+// behind tail has been lapped and resumes from tail.
+//
+// Readers get zero-copy views (read_next / read_batch). Because tail moves before any
+// byte is overwritten, frame_valid(view) after consuming a view proves the bytes the
+// reader looked at were not torn (seqlock-style validation).
 // NOTE: the extern helps us expose the "interface" in the C ABI way which is understood by ocaml.
 //       the "internals" though can be implemented in c++ way. AN ABI basically means the way a 
 //       languages uses the CPU, like the calling convention, register usage, naming etc.
 #include <cstdint>
 #include <cstddef>
+#include "aether_frame.h"
+#include "ring_c.h"
 
 extern "C" {
   struct RingHandleC;
@@ -15,27 +34,77 @@ extern "C" {
 
 namespace aether { namespace ring {
 
+  static constexpr uint32_t DEFAULT_MAX_READERS = 16;
+
   // header in mmap
   struct RingHeader {
-    uint32_t magic;      // 0xAETHER02
-    uint16_t version;    // layout version
+    uint32_t magic;        // "AETH"
+    uint16_t version;      // layout version
     uint16_t reserved0;
-    uint64_t buf_size;   // size of circular buffer region in bytes
-    uint64_t reserved[4];
+    uint64_t buf_size;     // size of circular buffer region in bytes
+    uint32_t max_readers;  // number of ReaderSlot entries
+    uint32_t reserved1;
+    uint64_t data_offset;  // byte offset of the circular buffer from the mapping base
+    uint64_t reserved[2];
   } __attribute__((packed));
 
+  // one per attached reader, each on its own cache line; written only by that reader
+  struct alignas(64) ReaderSlot {
+    uint32_t state;        // 0 = free, 1 = active (CAS by readers)
+    uint32_t pid;          // owner, used to reclaim slots of dead readers
+    uint64_t cursor;       // absolute offset of the reader's next frame
+    uint64_t lapped;       // times this reader fell behind tail
+    uint64_t reserved[5];
+  };
+
+  // per-frame header in the circular buffer
+  struct FrameHeader {
+    uint32_t len;       // payload bytes (WRAP_MARKER = skip to next lap)
+    uint8_t  type;
+    uint8_t  flags;
+    uint16_t reserved;
+    uint64_t seq;       // absolute offset of this frame
+  };
+  static_assert(sizeof(FrameHeader) == 16, "FrameHeader layout");
+
+  using FrameView = ring_frame_view;
+
   // opaque C++ handle
   struct RingHandle;
 
+  // backing pages of a new ring (create_ring). The producer zero-fills the whole ring
+  // when it creates it, so every page is faulted in before the first frame either way.
+  enum class RingPages {
+    Default,      // whatever the filesystem gives (4K pages on tmpfs)
+    Transparent,  // madvise(MADV_HUGEPAGE): THP on tmpfs when shmem_enabled allows it
+    Huge          // path on a hugetlbfs mount: file sized in huge pages; elsewhere THP
+  };
+  // "4k", "thp", "huge"
+  bool parse_ring_pages(const char *s, RingPages &out);
+
   // create or open
-  RingHandle* create_ring(const char *path, size_t buf_size);
+  RingHandle* create_ring(const char *path, size_t buf_size, uint32_t max_readers = DEFAULT_MAX_READERS,
+      RingPages pages = RingPages::Default);
   RingHandle* open_ring(const char *path);
   void close_ring(RingHandle *h);
 
   // publish a framed message (type + payload). returns true on success.
-  // msg_type: 1 = DEPTH_UPDATE, 2 = SNAPSHOT, user-defined types ok
+  // msg_type: AETHER_MSG_* from aether_frame.h, user-defined types ok
   bool publish_message(RingHandle *h, uint8_t msg_type, const void *payload, size_t payload_len);
 
+  // Two-phase publishing straight into ring memory (single producer):
+  //   void *p = reserve(h, max_len);   // writable payload area, wrap/eviction done here
+  //   ... encode up to max_len bytes at p ...
+  //   commit(h, type, n);              // n <= max_len; publishes (one release store)
+  // or abort(h) to drop the reservation. commit_deferred() finalizes the frame without
+  // publishing it; flush() then makes every deferred frame visible with a single store
+  // of head, so a burst pays one fence. Only one reservation may be open at a time.
+  void* reserve(RingHandle *h, size_t max_len);
+  bool commit(RingHandle *h, uint8_t msg_type, size_t len);
+  bool commit_deferred(RingHandle *h, uint8_t msg_type, size_t len);
+  void flush(RingHandle *h);
+  void abort(RingHandle *h);
+
   // convenience: publish a null-terminated JSON string as snapshot
   bool publish_snapshot_json(RingHandle *h, const char *json_cstr);
 
@@ -43,6 +112,37 @@ namespace aether { namespace ring {
   uint64_t ring_head(const RingHandle *h);
   uint64_t ring_tail(const RingHandle *h);
   uint64_t ring_buf_size(const RingHandle *h);
+  // frames this producer handle has overwritten (evicted from the tail) so far
+  uint64_t ring_evicted(const RingHandle *h);
+  // bytes the slowest registered reader is behind head, 0 without readers. Readers
+  // already lapped (cursor behind tail, e.g. dead ones) are not counted. Reads every
+  // active slot's cache line: meant for occasional polling by the producer.
+  uint64_t ring_max_reader_lag(const RingHandle *h);
+
+  // reader registration. register_reader claims a free slot (or one whose owner pid is
+  // gone) with its cursor at the current head and returns the slot index, -1 if full.
+  int register_reader(RingHandle *h);
+  void deregister_reader(RingHandle *h, int slot);
+  uint64_t reader_cursor(const RingHandle *h, int slot);
+  void set_reader_cursor(RingHandle *h, int slot, uint64_t cursor);
+  // true if the producer has overwritten the reader's cursor position; the cursor is
+  // then moved to the oldest intact frame (tail) and the slot's lap count bumped
+  bool reader_check_lapped(RingHandle *h, int slot);
+
+  // Zero-copy reads for a registered slot. read_next returns RING_READ_OK (out filled,
+  // cursor advanced), RING_READ_EMPTY, or RING_READ_LAPPED (cursor moved to tail).
+  // read_batch returns the number of views filled, or RING_READ_LAPPED if none; a lap
+  // hit after some frames is reported by the next call.
+  int read_next(RingHandle *h, int slot, FrameView &out);
+  int read_batch(RingHandle *h, int slot, FrameView *out, int max);
+  // call after consuming a view: true if the producer has not overwritten it
+  bool frame_valid(const RingHandle *h, const FrameView &v);
+  // Late joiners: move the slot's cursor to the newest binary SNAPSHOT still in the
+  // ring (checkpoint or rebuild). With symbol ids, to the oldest of the newest
+  // snapshots of those symbols, so reading forward meets one for each; deltas of a
+  // symbol seen before its snapshot are to be skipped. false (cursor untouched) if the
+  // ring holds none for some symbol.
+  bool seek_snapshot(RingHandle *h, int slot, const uint32_t *symbol_ids = nullptr, size_t n = 0);
 
   // C bindings
   extern "C" {
@@ -51,15 +151,40 @@ namespace aether { namespace ring {
     };
 
     struct RingHandleC* ring_create(const char *path, size_t buf_size);
+    struct RingHandleC* ring_create_ex(const char *path, size_t buf_size, uint32_t max_readers);
     struct RingHandleC* ring_open(const char *path);
     void ring_close(struct RingHandleC* ch);
     int ring_publish(struct RingHandleC* ch, unsigned int msg_type, const void* payload, size_t payload_len);
     int ring_publish_snapshot_json(struct RingHandleC* ch, const char* json_cstr);
+    void* ring_reserve(struct RingHandleC* ch, size_t max_len);
+    int ring_commit(struct RingHandleC* ch, unsigned int msg_type, size_t len);
+    int ring_commit_deferred(struct RingHandleC* ch, unsigned int msg_type, size_t len);
+    void ring_flush(struct RingHandleC* ch);
+    void ring_abort(struct RingHandleC* ch);
     uint64_t ring_get_head(struct RingHandleC* ch);
     uint64_t ring_get_tail(struct RingHandleC* ch);
     uint64_t ring_get_buf_size(struct RingHandleC* ch);
     void* ring_get_buffer_ptr(struct RingHandleC* ch);
+    // legacy single-consumer call: stores new_tail as this handle's reader cursor
+    // (registering a slot on first use). The producer no longer reads it.
     void ring_set_tail(struct RingHandleC* ch, uint64_t new_tail);
+
+    // per-reader cursors
+    int ring_reader_register(struct RingHandleC* ch);
+    void ring_reader_deregister(struct RingHandleC* ch, int slot);
+    uint64_t ring_reader_get_cursor(struct RingHandleC* ch, int slot);
+    void ring_reader_set_cursor(struct RingHandleC* ch, int slot, uint64_t cursor);
+    int ring_reader_check_lapped(struct RingHandleC* ch, int slot);
+
+    // zero-copy reads (see ring_c.h)
+    int ring_read_next(struct RingHandleC* ch, int slot, ring_frame_view* out);
+    int ring_read_batch(struct RingHandleC* ch, int slot, ring_frame_view* out, int max);
+    int ring_frame_valid(struct RingHandleC* ch, const ring_frame_view* v);
+    int ring_reader_seek_snapshot(struct RingHandleC* ch, int slot, const uint32_t* symbol_ids, size_t n);
+
+    // binary frame decoding (exported wrappers over aether_frame.h for FFI callers)
+    int ring_frame_read_header(const void* payload, size_t len, aether_frame_header* out);
+    void ring_frame_read_level(const void* payload, uint32_t idx, aether_level* out);
   } // extern "C"
 
 }} // namespace
@@ -0,0 +1,41 @@
+#pragma once
+// runtime.h
+// Low-latency runtime knobs: CPU pinning and real-time scheduling per thread, locking
+// the process in memory and prefaulting the memory the hot threads will touch. All of
+// it is opt-in; a knob that cannot be applied (no permission, CPU missing) is logged
+// and the thread keeps running with the default behaviour.
+//
+// Each long-lived thread applies its own ThreadPolicy as the first thing it does, so
+// its stack and first allocations are faulted in on the CPU it stays on.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace aether { namespace rt {
+
+  struct ThreadPolicy {
+    int cpu = -1;           // pin to this CPU (-1 = let the scheduler place it)
+    int rt_priority = 0;    // SCHED_FIFO priority 1..99 (0 = normal scheduling)
+  };
+
+  // "3", "2,4", "4-7,9" -> CPU numbers in order; false on a malformed list
+  bool parse_cpu_list(const std::string &s, std::vector<int> &out);
+
+  // Names the calling thread (truncated to 15 chars) and applies p to it. Returns false
+  // if pinning or scheduling was refused (logged).
+  bool apply_thread_policy(const ThreadPolicy &p, const char *name);
+
+  // mlockall(MCL_CURRENT | MCL_FUTURE): every current and future mapping stays resident,
+  // and is faulted in when it is mapped. Needs CAP_IPC_LOCK or a large RLIMIT_MEMLOCK.
+  bool lock_memory();
+
+  // Keep freed heap memory mapped (no trimming, no per-allocation mmap), so pages that
+  // were faulted in once are reused instead of being returned to the kernel.
+  void retain_heap();
+
+  // Touch stack_bytes of the calling thread's stack and grow its malloc arena by
+  // heap_bytes (allocated, written and freed), ahead of the hot loop.
+  void prefault_thread(size_t stack_bytes, size_t heap_bytes);
+
+}} // namespace aether::rt
@@ -0,0 +1,118 @@
+#pragma once
+// shard_engine.h
+// Many symbols in one process. Symbols are sharded over a fixed set of book threads
+// (by hash of the symbol or explicit assignment); each shard owns one SPSC queue fed by
+// the combined-stream reader, the books of its symbols, and its own ring and WAL.
+// Threads, queues and rings therefore scale with the shard count, not the symbol count.
+//
+// Rings stay single-producer: with one shard the ring is ring_path, with several it
+// is ring_path.N per shard. Frames carry symbol ids, so consumers can merge rings.
+// Book views (book_view.h) are per symbol: view_dir/aether.SYMBOL.view.
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "book_view.h"
+#include "event_queue.h"
+#include "feed_source.h"
+#include "pipeline.h"
+#include "ring_mmap.h"
+#include "runtime.h"
+#include "stats_shm.h"
+#include "symbol_router.h"
+#include "wal.h"
+
+namespace aether {
+
+  struct SymbolSpec {
+    std::string symbol;        // upper-case
+    DecimalScale scale;
+    int shard = -1;            // explicit shard, -1 = by symbol hash
+  };
+
+  struct ShardConfig {
+    size_t shards = 1;
+    std::string ring_path;     // empty = no ring
+    size_t ring_bytes = 8 * 1024 * 1024;
+    wal::WalConfig wal;        // dir empty = no WAL; several shards use dir/shard-N
+    std::string view_dir;      // empty = no book views
+    uint32_t view_depth = view::DEFAULT_DEPTH;
+    uint32_t checkpoint_ms = 0;        // per symbol, see PipelineConfig
+    uint64_t checkpoint_events = 0;
+    // share of a shard's ring its symbols' checkpoints may rewrite per second, split
+    // evenly between them (PipelineConfig::checkpoint_bytes_per_s; 0 = no floor)
+    uint32_t checkpoint_ring_pct = 12;
+    ConflateMode conflate = ConflateMode::Off; // per symbol, see PipelineConfig
+    uint32_t conflate_ms = 10;
+    uint32_t conflate_events = 0;
+    uint32_t conflate_lag_pct = 50;
+    uint32_t analytics_depth = 0;      // per symbol, see PipelineConfig
+    size_t queue_capacity = EventQueue::DEFAULT_CAPACITY;
+    size_t queue_prewarm_levels = 0;   // EventQueue::prewarm (0 = grow on first use)
+    size_t book_reserve_levels = 0;    // per symbol, see PipelineConfig
+    bool verbose = false;
+    bool measure = false;
+    stats::StatsSegment *stats = nullptr; // each shard adds a "shard-N" block
+    ring::RingPages ring_pages = ring::RingPages::Default;
+    // book threads: shard i runs on book_cpus[i % size] (empty = unpinned), SCHED_FIFO
+    // at book_rt_priority (0 = normal), with stack and heap prefaulted before it starts
+    std::vector<int> book_cpus;
+    int book_rt_priority = 0;
+    size_t prefault_heap_bytes = 0;
+  };
+
+  template <class Book>
+  class BasicShardEngine {
+    public:
+      using Pipeline = BasicPipeline<Book>;
+
+      // creates queues, rings and WALs, and assigns symbols to shards
+      BasicShardEngine(const ShardConfig &cfg, const std::vector<SymbolSpec> &symbols);
+      ~BasicShardEngine();
+
+      // routing table for the feed reader; valid for the engine's lifetime
+      const SymbolRouter &router() const noexcept { return router_; }
+
+      // one thread per shard; every symbol starts syncing from snaps. on_all_stopped runs
+      // on a book thread once every symbol's pipeline has stopped for good.
+      void start(SnapshotSource &snaps, std::atomic<bool> &stop, std::function<void()> on_all_stopped = {});
+      // joins shard threads (they return at end of stream or stop), then closes
+      // rings, WALs and book views
+      void join();
+
+      size_t shardCount() const noexcept { return shards_.size(); }
+      // sums over all symbols; call after join()
+      PipelineStats totals() const;
+
+    private:
+      struct Shard {
+        explicit Shard(size_t queue_capacity) : queue(queue_capacity) {}
+        EventQueue queue;
+        ring::RingHandle *ring = nullptr;
+        std::unique_ptr<wal::WalWriter> wal;
+        stats::StatsBlock *stats = nullptr;
+        std::vector<std::unique_ptr<view::BookViewWriter>> views;   // per symbol, may be closed
+        std::vector<std::unique_ptr<Pipeline>> pipelines;
+        std::vector<uint8_t> dead;  // per pipeline: parked after it could not continue
+        std::thread thread;
+      };
+
+      void run_shard(Shard &sh, SnapshotSource &snaps, std::atomic<bool> &stop);
+      void park(Shard &sh, size_t i);
+
+      ShardConfig cfg_;
+      std::vector<std::unique_ptr<Shard>> shards_;
+      SymbolRouter router_;
+      std::atomic<size_t> running_{0};   // pipelines not parked
+      std::function<void()> on_all_stopped_;
+  };
+
+  // instantiated in shard_engine.cpp
+  extern template class BasicShardEngine<OrderBook>;
+  extern template class BasicShardEngine<LadderOrderBook>;
+
+} // namespace aether
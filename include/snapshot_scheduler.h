@@ -0,0 +1,86 @@
+#pragma once
+// snapshot_scheduler.h
+// Paces the process's REST depth snapshots against Binance's request-weight limits. One
+// scheduler per process, on the NetLoop: every snapshot request is a coroutine that
+// waits here for three things before it goes out:
+//   - weight: a token bucket refilled at weight_per_minute, charged the request's
+//     weight (250 for limit=5000). The server's X-MBX-USED-WEIGHT-1M header also counts,
+//     so other clients on the same IP are respected: near ip_weight_limit, requests
+//     wait for the next minute.
+//   - a slot: at most max_in_flight requests at once. Only symbols whose request is in
+//     flight need to buffer their deltas (see SnapshotRequest::Queued).
+//   - no pause: a 429 or 418 pauses every request for Retry-After (or a doubling
+//     backoff without one), since the next one would only extend a ban.
+
+// Boost 1.74's awaitable.hpp uses std::exchange without including <utility>
+#include <utility>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include "net_loop.h"
+#include "feed_source.h"
+#include "rest_client.h"
+
+namespace aether {
+
+  struct SnapshotSchedulerConfig {
+    uint32_t weight_per_minute = 3000;  // this process's budget (half of Binance's IP limit)
+    uint32_t ip_weight_limit = 6000;    // REQUEST_WEIGHT per minute per IP
+    size_t max_in_flight = 4;
+    std::chrono::seconds max_backoff{300};
+  };
+
+  struct SnapshotSchedulerStats {
+    uint64_t requests = 0;
+    uint64_t weight = 0;            // charged to the budget
+    uint64_t rate_limited = 0;      // 429 responses
+    uint64_t banned = 0;            // 418 responses
+    uint64_t waited_ms = 0;         // sum of request waits for budget, slot or pause
+  };
+
+  class SnapshotScheduler {
+    public:
+      SnapshotScheduler(NetLoop &loop, RestClient &rest, const SnapshotSchedulerConfig &cfg = {});
+      SnapshotScheduler(const SnapshotScheduler &) = delete;
+      SnapshotScheduler &operator=(const SnapshotScheduler &) = delete;
+
+      // Loop thread (coroutine). GET target once budget, slot and pause allow; started()
+      // runs just before the request goes out. Returns any response (429 and 418 have
+      // already paused the scheduler); throws as RestClient::get does.
+      template <class F>
+      boost::asio::awaitable<HttpResponse> get(std::string target, uint32_t weight, F started) {
+        co_await acquire(weight);
+        started();
+        co_return co_await send(target, weight);
+      }
+
+      // loop thread
+      const SnapshotSchedulerStats &stats() const noexcept { return stats_; }
+
+    private:
+      using clock_type = std::chrono::steady_clock;
+
+      boost::asio::awaitable<void> acquire(uint32_t weight);
+      boost::asio::awaitable<HttpResponse> send(const std::string &target, uint32_t weight);
+      void refill(clock_type::time_point now);
+      void wake_all();
+
+      NetLoop &loop_;
+      RestClient &rest_;
+      SnapshotSchedulerConfig cfg_;
+
+      // loop-thread state
+      double tokens_;
+      clock_type::time_point refilled_at_;
+      clock_type::time_point paused_until_{};
+      std::chrono::seconds backoff_{0};
+      size_t in_flight_ = 0;
+      std::deque<boost::asio::steady_timer*> waiters_;
+      SnapshotSchedulerStats stats_;
+  };
+
+} // namespace aether
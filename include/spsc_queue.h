@@ -0,0 +1,221 @@
+#pragma once
+// spsc_queue.h
+// Bounded single-producer/single-consumer ring with cache-line padded indices.
+// Slots are preallocated and recycled: the producer fills a slot in place
+// (try_claim + publish) and the consumer either works on it in place (front,
+// try_pop_n) or swaps it out (try_pop), so element buffers survive between laps.
+//
+// The consumer blocks through a Wait policy:
+//   BusySpinWait   - pause loop, lowest latency, burns a core
+//   SpinYieldWait  - spin, then sched_yield
+//   SpinFutexWait  - spin, then sleep on a futex; the producer only issues the
+//                    wake syscall when the consumer is actually asleep
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace aether {
+
+  static constexpr size_t CACHE_LINE = 64;
+
+  inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+  }
+
+  struct BusySpinWait {
+    template <class Ready>
+    void wait(Ready &&ready) noexcept {
+      while (!ready()) cpu_relax();
+    }
+    void notify() noexcept {}
+  };
+
+  struct SpinYieldWait {
+    static constexpr int SPINS = 1024;
+    template <class Ready>
+    void wait(Ready &&ready) noexcept {
+      for (int i = 0; i < SPINS; ++i) {
+        if (ready()) return;
+        cpu_relax();
+      }
+      while (!ready()) std::this_thread::yield();
+    }
+    void notify() noexcept {}
+  };
+
+  struct SpinFutexWait {
+    static constexpr int SPINS = 4096;
+
+    template <class Ready>
+    void wait(Ready &&ready) noexcept {
+      for (int i = 0; i < SPINS; ++i) {
+        if (ready()) return;
+        cpu_relax();
+      }
+      while (!ready()) {
+        uint32_t seq = seq_.load(std::memory_order_acquire);
+        sleeping_.store(1, std::memory_order_relaxed);
+        // pairs with the fence in notify(): either we see the new item or the
+        // producer sees sleeping_ and bumps seq_
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ready()) break;
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAIT_PRIVATE, seq, nullptr, nullptr, 0);
+      }
+      sleeping_.store(0, std::memory_order_relaxed);
+    }
+
+    void notify() noexcept {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (sleeping_.load(std::memory_order_relaxed)) {
+        seq_.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+      }
+    }
+
+    private:
+      alignas(CACHE_LINE) std::atomic<uint32_t> seq_{0};
+      std::atomic<uint32_t> sleeping_{0};
+  };
+
+  template <class T, class Wait = SpinFutexWait>
+  class SpscQueue {
+    public:
+      // capacity is rounded up to a power of two
+      explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_.resize(cap);
+      }
+
+      SpscQueue(const SpscQueue&) = delete;
+      SpscQueue& operator=(const SpscQueue&) = delete;
+
+      // f(T&) on every slot; before either side starts (e.g. to reserve element buffers)
+      template <class F>
+      void for_each_slot(F &&f) {
+        for (Slot &s : slots_) f(s.v);
+      }
+
+      // -- producer ---------------------------------------------------------
+
+      // next free slot to fill in place, or nullptr if the ring is full
+      T* try_claim() noexcept {
+        uint64_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ > mask_) {
+          head_cache_ = head_.load(std::memory_order_acquire);
+          if (t - head_cache_ > mask_) return nullptr;
+        }
+        return &slots_[t & mask_].v;
+      }
+
+      // make the slot returned by try_claim visible to the consumer
+      void publish() noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        wait_.notify();
+      }
+
+      bool try_push(T &&v) {
+        T *s = try_claim();
+        if (!s) return false;
+        *s = std::move(v);
+        publish();
+        return true;
+      }
+
+      // -- consumer ---------------------------------------------------------
+
+      // oldest element, or nullptr if empty
+      T* front() noexcept {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_) {
+          tail_cache_ = tail_.load(std::memory_order_acquire);
+          if (h == tail_cache_) return nullptr;
+        }
+        return &slots_[h & mask_].v;
+      }
+
+      // release the element returned by front()
+      void pop_front() noexcept {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      }
+
+      // swap the oldest element into out; out's old contents go back to the ring
+      bool try_pop(T &out) {
+        T *s = front();
+        if (!s) return false;
+        using std::swap;
+        swap(out, *s);
+        pop_front();
+        return true;
+      }
+
+      void pop(T &out) {
+        wait_.wait([this] { return front() != nullptr; });
+        try_pop(out);
+      }
+
+      // Hand up to max elements to f(T&) in place, then release them with a single
+      // store. f returns false to stop early (that element still counts as consumed).
+      template <class F>
+      size_t try_pop_n(F &&f, size_t max) {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ - h < max) tail_cache_ = tail_.load(std::memory_order_acquire);
+        size_t n = std::min<size_t>(size_t(tail_cache_ - h), max);
+        size_t i = 0;
+        while (i < n) {
+          bool more = f(slots_[(h + i) & mask_].v);
+          ++i;
+          if (!more) break;
+        }
+        if (i) head_.store(h + i, std::memory_order_release);
+        return i;
+      }
+
+      // as try_pop_n, but waits for at least one element first
+      template <class F>
+      size_t pop_n(F &&f, size_t max) {
+        wait_.wait([this] { return front() != nullptr; });
+        return try_pop_n(std::forward<F>(f), max);
+      }
+
+      // -- either side --------------------------------------------------------
+
+      size_t size() const noexcept {
+        uint64_t h = head_.load(std::memory_order_acquire);
+        uint64_t t = tail_.load(std::memory_order_acquire);
+        return size_t(t - h);
+      }
+      size_t capacity() const noexcept { return mask_ + 1; }
+
+    private:
+      struct alignas(CACHE_LINE) Slot { T v; };
+
+      // producer line
+      alignas(CACHE_LINE) std::atomic<uint64_t> tail_{0};
+      uint64_t head_cache_ = 0;
+      // consumer line
+      alignas(CACHE_LINE) std::atomic<uint64_t> head_{0};
+      uint64_t tail_cache_ = 0;
+
+      alignas(CACHE_LINE) size_t mask_ = 0;
+      std::vector<Slot> slots_;
+      Wait wait_;
+  };
+
+} // namespace aether
@@ -0,0 +1,142 @@
+#pragma once
+// stats_shm.h
+// Live counters and stage-latency histograms in a small mmap'd segment (default
+// /dev/shm/aether.stats) that aether_stat reads from outside the process.
+//
+// The segment holds one StatsBlock per writer thread (the feed reader, each shard),
+// and every block has exactly one writer. Updates are relaxed load+store pairs on
+// plain words (no locked instructions, no fences); a reader copies the words it wants
+// and may see a histogram mid-update, which only skews that snapshot by an event.
+// Stage latencies are recorded in TSC ticks; header.ticks_per_ns converts them.
+//
+// Layout: [StatsHeader (one page)][StatsBlock x max_blocks]
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "latency_stats.h"
+
+namespace aether { namespace stats {
+
+  // stage latencies of one depth event, all measured on the live path
+  enum Stage : uint32_t {
+    StageDecode,     // WS frame received -> decoded into its queue slot
+    StageQueue,      // decoded -> dequeued by the book thread
+    StageApply,      // applyEvent
+    StagePublish,    // frame encode + ring commit (and WAL hand-off, book view)
+    StageTotal,      // WS frame received -> ring commit
+    STAGE_COUNT
+  };
+
+  enum Counter : uint32_t {
+    Frames,          // WS frames received (feed block)
+    Malformed,       // frames that failed to decode (feed block)
+    Events,          // deltas applied to books
+    Stale,           // deltas already covered by the book
+    Gaps,            // sequence gaps detected
+    Resyncs,         // gaps recovered in place
+    Drops,           // frames that could not be published, deltas dropped while resyncing
+    Overwrites,      // ring frames overwritten by the producer
+    QueueDepth,      // events left in the shard queue after the last batch (gauge)
+    QueueDepthMax,
+    Checkpoints,     // periodic CHECKPOINT snapshot frames published
+    Conflated,       // deltas merged into CONFLATED ring frames
+    Allocs,          // operator new calls on the live path (AETHER_COUNT_ALLOCS builds)
+    QueueWaits,      // frames held back while their shard queue was full (feed block)
+    COUNTER_COUNT
+  };
+
+  const char *stage_name(Stage s);
+  const char *counter_name(Counter c);
+
+  static constexpr uint32_t STATS_MAGIC = 0x54534541; // "AEST"
+  static constexpr uint16_t STATS_VERSION = 1;
+  static constexpr size_t MAX_COUNTERS = 16;          // room to add counters without a new layout
+  static constexpr size_t DEFAULT_MAX_BLOCKS = 64;
+
+  // one writer; words are read concurrently by aether_stat
+  struct SharedHistogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[LatencyHistogram::BUCKETS];    // LatencyHistogram bucket layout
+  };
+
+  struct alignas(64) StatsBlock {
+    char name[32];                                   // "feed", "shard-0", ...
+    uint64_t counters[MAX_COUNTERS];
+    SharedHistogram stages[STAGE_COUNT];
+
+    // writer side: plain load + store, never a read-modify-write instruction
+    void add(Counter c, uint64_t n = 1) { bump(counters[c], n); }
+    void set(Counter c, uint64_t v) { put(counters[c], v); }
+    void set_max(Counter c, uint64_t v) { if (v > get(counters[c])) put(counters[c], v); }
+    void record(Stage s, uint64_t ticks) {
+      SharedHistogram &h = stages[s];
+      bump(h.buckets[LatencyHistogram::index_of(ticks)], 1);
+      bump(h.sum, ticks);
+      if (ticks > get(h.max)) put(h.max, ticks);
+      if (ticks < get(h.min) || !get(h.count)) put(h.min, ticks);
+      bump(h.count, 1);
+    }
+
+    // reader side
+    uint64_t counter(Counter c) const { return get(counters[c]); }
+    // copy of one stage histogram (in ticks)
+    void snapshot(Stage s, LatencyHistogram &out) const;
+
+    static uint64_t get(const uint64_t &w) {
+      return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(w)).load(std::memory_order_relaxed);
+    }
+    static void put(uint64_t &w, uint64_t v) {
+      std::atomic_ref<uint64_t>(w).store(v, std::memory_order_relaxed);
+    }
+    static void bump(uint64_t &w, uint64_t n) { put(w, get(w) + n); }
+  };
+
+  struct StatsHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t pid;               // writer process
+    uint32_t max_blocks;
+    uint32_t blocks;            // blocks in use; a block is filled in before this is bumped
+    uint32_t block_size;        // sizeof(StatsBlock), checked by readers
+    double ticks_per_ns;        // TSC rate of the writer's clock
+    uint64_t start_unix_ns;
+  };
+
+  // Writer: create() and add_block() once per thread at startup. Reader: open().
+  class StatsSegment {
+    public:
+      StatsSegment() = default;
+      ~StatsSegment();
+      StatsSegment(const StatsSegment &) = delete;
+      StatsSegment &operator=(const StatsSegment &) = delete;
+
+      // creates (or replaces) the segment file; false on error (logged)
+      bool create(const std::string &path, size_t max_blocks = DEFAULT_MAX_BLOCKS);
+      // maps an existing segment read-only
+      bool open(const std::string &path);
+      void close();
+
+      // next free zeroed block, nullptr if none are left (or not created)
+      StatsBlock *add_block(const std::string &name);
+
+      const StatsHeader *header() const noexcept { return hdr_; }
+      size_t blocks() const noexcept;
+      const StatsBlock &block(size_t i) const { return blocks_[i]; }
+      // TSC ticks -> ns at the writer's rate
+      double to_ns(uint64_t ticks) const noexcept { return hdr_ ? double(ticks) / hdr_->ticks_per_ns : 0.0; }
+
+    private:
+      void *map_ = nullptr;
+      size_t map_size_ = 0;
+      StatsHeader *hdr_ = nullptr;
+      StatsBlock *blocks_ = nullptr;
+      bool writer_ = false;
+  };
+
+}} // namespace aether::stats
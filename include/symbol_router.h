@@ -0,0 +1,64 @@
+#pragma once
+// symbol_router.h
+// Maps the "s" field of a combined-stream frame to the shard queue, per-shard symbol
+// index and decimal scale it is decoded with. Built once before the feed starts and
+// read-only afterwards, so the WS thread looks symbols up without locking.
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "aether_frame.h"
+#include "decimal.h"
+#include "event_queue.h"
+
+namespace aether {
+
+  struct SymbolRoute {
+    std::string symbol;        // upper-case
+    EventQueue *queue = nullptr;
+    uint32_t index = 0;        // DepthEvent::symbol within the shard
+    DecimalScale scale;
+  };
+
+  class SymbolRouter {
+    public:
+      // false (and not added) if the symbol is already routed
+      bool add(SymbolRoute r) {
+        if (find(r.symbol)) return false;
+        uint32_t id = aether_symbol_id(r.symbol.c_str());
+        by_id_.emplace(id, routes_.size());
+        routes_.push_back(std::move(r));
+        return true;
+      }
+
+      // nullptr if the symbol is not routed
+      const SymbolRoute *find(std::string_view symbol) const {
+        uint32_t h = 2166136261u; // aether_symbol_id over the view
+        for (char ch : symbol) { h ^= uint8_t(ch); h *= 16777619u; }
+        auto range = by_id_.equal_range(h);
+        for (auto it = range.first; it != range.second; ++it) {
+          const SymbolRoute &r = routes_[it->second];
+          if (r.symbol == symbol) return &r;
+        }
+        return nullptr;
+      }
+
+      const std::vector<SymbolRoute> &routes() const noexcept { return routes_; }
+
+      // distinct queues, for end-of-stream broadcast
+      std::vector<EventQueue*> queues() const {
+        std::vector<EventQueue*> qs;
+        for (const auto &r : routes_)
+          if (std::find(qs.begin(), qs.end(), r.queue) == qs.end()) qs.push_back(r.queue);
+        return qs;
+      }
+
+    private:
+      std::vector<SymbolRoute> routes_;
+      std::unordered_multimap<uint32_t, size_t> by_id_;
+  };
+
+} // namespace aether
@@ -0,0 +1,46 @@
+#pragma once
+// tsc_clock.h
+// Cycle-counter timestamps for per-stage latency. tsc_now() is one rdtsc (~20 cycles,
+// no syscall or vDSO call); ticks are converted to ns only when read, with a rate
+// calibrated once against steady_clock. Assumes an invariant, core-synchronised TSC
+// (every x86 server CPU of the last decade), so stamps taken on different threads
+// can be subtracted. Other architectures fall back to steady_clock ns.
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace aether {
+
+  inline uint64_t tsc_now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  // ticks per nanosecond; the first call sleeps ~20ms to measure it
+  inline double tsc_ticks_per_ns() {
+    static const double rate = [] {
+#if defined(__x86_64__) || defined(__i386__)
+      using clock = std::chrono::steady_clock;
+      auto w0 = clock::now();
+      uint64_t t0 = tsc_now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      uint64_t t1 = tsc_now();
+      auto w1 = clock::now();
+      double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(w1 - w0).count());
+      return ns > 0 ? double(t1 - t0) / ns : 1.0;
+#else
+      return 1.0;
+#endif
+    }();
+    return rate;
+  }
+
+} // namespace aether
@@ -1,10 +1,10 @@
 #pragma once
 // utils.h - small inline helpers
 
-#include <iostream>
 #include <chrono>
 #include <thread>
 #include "event_queue.h"
+#include "log.h"
 
 // Waits until EventQueue has some buffered depthUpdate events and returns the first U
 inline uint64_t wait_for_initial_buffer(EventQueue &queue,
@@ -14,7 +14,7 @@ inline uint64_t wait_for_initial_buffer(EventQueue &queue,
   uint64_t firstU = 0;
   int waited_ms = 0;
 
-  std::cerr << "[wait_for_initial_buffer] waiting for initial depthUpdate events...\n";
+  AETHER_LOG_INFO("[wait_for_initial_buffer] waiting for initial depthUpdate events...");
 
   while (true) {
     size_t sz = queue.size();
@@ -38,8 +38,7 @@ inline uint64_t wait_for_initial_buffer(EventQueue &queue,
     }
   }
 
-  std::cerr << "[wait_for_initial_buffer] got first buffered event U = "
-    << firstU << " (buffered_events=" << queue.size() << ")\n";
+  AETHER_LOG_INFO("[wait_for_initial_buffer] got first buffered event U = {} (buffered_events={})", firstU, queue.size());
 
   return firstU;
 }
@@ -0,0 +1,175 @@
+#pragma once
+// wal.h
+// Segmented on-disk write-ahead log of published frames.
+//
+// The book thread hands records to WalWriter::append(), which only copies into a
+// preallocated SPSC ring; a dedicated writer thread batches them into append-only
+// segment files and syncs them per the configured durability. One log holds every
+// symbol of a shard; records carry the symbol id, and a sparse per-symbol index maps
+// (symbol, update id u) -> file offset so readers can seek without scanning whole
+// segments.
+//
+// On disk, per segment N (zero-padded):
+//   wal-N.seg : [SegmentHeader][Record][Record]...
+//   wal-N.idx : [IndexEntry]...   (per symbol: its first record in the segment, then one
+//                                  every index_every_bytes of log)
+// Record = [RecordHeader (24 bytes)][payload (len bytes)]
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "runtime.h"
+#include "spsc_queue.h"
+
+namespace aether { namespace wal {
+
+  enum class Durability {
+    None,      // leave it to the page cache
+    Periodic,  // fdatasync every sync_interval_ms while there are unsynced writes
+    PerBatch   // fdatasync at every end_batch() boundary
+  };
+
+  bool parse_durability(const std::string &s, Durability &out); // none | periodic | batch
+
+  struct WalConfig {
+    std::string dir;                               // empty = WAL disabled
+    uint64_t segment_bytes = 256ull << 20;         // roll size
+    uint64_t index_every_bytes = 64ull << 10;      // sparse index spacing
+    Durability durability = Durability::Periodic;
+    uint32_t sync_interval_ms = 200;
+    size_t queue_records = 16384;                  // hand-off capacity
+    rt::ThreadPolicy thread;                       // writer thread placement
+  };
+
+  struct SegmentHeader {
+    uint32_t magic;     // "AWAL"
+    uint16_t version;
+    uint16_t reserved0;
+    uint64_t segment_no;
+  };
+
+  // update ids are only ordered within one symbol
+  static constexpr uint32_t ANY_SYMBOL = 0;
+
+  struct RecordHeader {
+    uint32_t len;       // payload bytes
+    uint32_t checksum;  // FNV-1a over the payload
+    uint64_t update_id; // u of the frame (lastUpdateId for snapshots)
+    uint32_t symbol_id; // aether_symbol_id of the frame's symbol
+    uint8_t  type;      // AETHER_MSG_*
+    uint8_t  reserved[3];
+  };
+
+  struct IndexEntry {
+    uint64_t update_id;
+    uint64_t offset;    // byte offset of the record in the segment file
+    uint32_t symbol_id;
+    uint32_t reserved;
+  };
+
+  static_assert(sizeof(SegmentHeader) == 16, "SegmentHeader layout");
+  static_assert(sizeof(RecordHeader) == 24, "RecordHeader layout");
+  static_assert(sizeof(IndexEntry) == 24, "IndexEntry layout");
+
+  class WalWriter {
+    public:
+      explicit WalWriter(const WalConfig &cfg);
+      ~WalWriter();
+
+      // creates the directory (and parents) if needed and starts the writer thread; continues
+      // after the highest existing segment number
+      bool start();
+      // drains everything queued, syncs and joins the writer thread
+      void stop();
+
+      // Book thread only. Copies the record into the hand-off queue; never blocks.
+      // Returns false (and counts a drop) if the writer has fallen behind.
+      bool append(uint8_t type, uint32_t symbol_id, uint64_t update_id, const void *payload, size_t len);
+      // marks a batch boundary (the sync point for Durability::PerBatch)
+      void end_batch();
+
+      uint64_t appended() const noexcept { return appended_.load(std::memory_order_relaxed); }
+      uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+      uint64_t bytes_written() const noexcept { return bytes_written_.load(std::memory_order_relaxed); }
+
+    private:
+      struct Slot {
+        uint8_t type = 0;
+        bool batch_end = false;
+        uint32_t symbol_id = 0;
+        uint64_t update_id = 0;
+        std::vector<uint8_t> data;
+      };
+
+      void run();
+      bool open_segment(uint64_t segment_no);
+      void close_segment();
+      void write_record(const Slot &s);
+      void flush_buffer();
+      void sync_now();
+
+      WalConfig cfg_;
+      SpscQueue<Slot, BusySpinWait> q_;
+      std::thread thread_;
+      std::atomic<bool> stop_{false};
+      bool started_ = false;
+
+      // writer-thread state
+      int seg_fd_ = -1;
+      int idx_fd_ = -1;
+      uint64_t segment_no_ = 0;
+      uint64_t seg_size_ = 0;
+      bool roll_ = false;          // a write failed: next record starts a new segment
+      std::vector<std::pair<uint32_t, uint64_t>> last_index_at_; // per symbol, this segment
+      bool dirty_ = false;
+      std::vector<uint8_t> wbuf_;
+      std::vector<IndexEntry> ibuf_;
+
+      std::atomic<uint64_t> appended_{0};
+      std::atomic<uint64_t> dropped_{0};
+      std::atomic<uint64_t> bytes_written_{0};
+  };
+
+  struct WalRecord {
+    uint8_t type = 0;
+    uint32_t symbol_id = 0;
+    uint64_t update_id = 0;
+    std::vector<uint8_t> payload;
+  };
+
+  // Sequential reader over all segments in a directory, optionally of one symbol only.
+  class WalReader {
+    public:
+      explicit WalReader(const std::string &dir, uint32_t symbol_id = ANY_SYMBOL);
+      ~WalReader();
+
+      // position at the first record of the symbol with update_id >= u (uses the sparse
+      // index). Without a symbol this only works on a single-symbol log (false otherwise).
+      bool seek(uint64_t u);
+      // next record (of the symbol) in log order; false at end of log or on a corrupt record
+      // mid-segment (a torn record at the end of a segment is skipped)
+      bool next(WalRecord &out);
+
+      size_t segmentCount() const noexcept { return segments_.size(); }
+
+    private:
+      bool open_segment(size_t i, uint64_t offset);
+      uint64_t segment_size() const;
+
+      std::string dir_;
+      uint32_t symbol_id_;
+      std::vector<uint64_t> segments_;
+      size_t cur_ = 0;
+      uint64_t seg_bytes_ = 0;   // size of the open segment file
+      std::FILE *fp_ = nullptr;
+      bool eof_ = false;
+      WalRecord pending_;      // first record found by seek()
+      bool has_pending_ = false;
+  };
+
+}} // namespace aether::wal
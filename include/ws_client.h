@@ -1,14 +1,45 @@
 #pragma once
 // ws_client.h
-// websocket reader that pushes depthUpdate events into EventQueue
+// websocket readers that push depthUpdate events into EventQueue. They run as
+// coroutines on a NetLoop; cancelling the loop closes the connection.
 
 #include <string>
 #include <atomic>
-#include <thread>
+#include <future>
+#include <vector>
 #include "event_queue.h"
+#include "decimal.h"
+#include "capture.h"
+#include "net_loop.h"
+#include "stats_shm.h"
+#include "symbol_router.h"
 
-// starts a thread that runs the WS reader; returns std::thread (moveable)
-std::thread start_ws_reader(const std::string &symbol,
-    const std::string &updateSpeed,
-    EventQueue &queue,
-    std::atomic<bool> &stopFlag);
+namespace aether {
+
+  // Reads <symbol>@depth[@100ms] until the connection ends or the loop is cancelled,
+  // then queues an end_of_stream event; the returned future is ready after that.
+  // While the queue is full the session waits on a timer (the loop keeps running);
+  // stopFlag ends that wait. If capture is set, every raw frame is handed to it before
+  // decoding; stats (loop thread only) counts frames and queue waits.
+  std::future<void> spawn_ws_reader(NetLoop &loop, const Endpoint &ep,
+      const std::string &symbol,
+      const std::string &updateSpeed,
+      const DecimalScale &scale,
+      EventQueue &queue,
+      std::atomic<bool> &stopFlag,
+      CaptureChannel *capture = nullptr,
+      stats::StatsBlock *stats = nullptr);
+
+  // Combined stream of several symbols on one connection. Each frame is routed by its
+  // "s" field to the route's queue, decoded with the route's scale and tagged with the
+  // route's index; every routed queue gets the end_of_stream event. symbols are
+  // lower-case; router must outlive the reader.
+  std::future<void> spawn_combined_ws_reader(NetLoop &loop, const Endpoint &ep,
+      const std::vector<std::string> &symbols,
+      const std::string &updateSpeed,
+      const SymbolRouter &router,
+      std::atomic<bool> &stopFlag,
+      CaptureChannel *capture = nullptr,
+      stats::StatsBlock *stats = nullptr);
+
+} // namespace aether
@@ -0,0 +1,44 @@
+// alloc_count.cpp
+// Counting replacements of the global allocation functions (AETHER_COUNT_ALLOCS only).
+// The object is pulled into every binary that reads thread_allocs().
+#include "alloc_count.h"
+
+#ifdef AETHER_COUNT_ALLOCS
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace aether { namespace mem {
+  thread_local uint64_t t_allocs = 0;
+}}
+
+static void *counted_alloc(std::size_t n, std::size_t align) {
+  ++aether::mem::t_allocs;
+  if (n == 0) n = 1;
+  void *p = align > alignof(std::max_align_t) ? std::aligned_alloc(align, (n + align - 1) / align * align)
+                                              : std::malloc(n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(std::size_t n) { return counted_alloc(n, 0); }
+void *operator new[](std::size_t n) { return counted_alloc(n, 0); }
+void *operator new(std::size_t n, std::align_val_t a) { return counted_alloc(n, std::size_t(a)); }
+void *operator new[](std::size_t n, std::align_val_t a) { return counted_alloc(n, std::size_t(a)); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  try { return counted_alloc(n, 0); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  try { return counted_alloc(n, 0); } catch (...) { return nullptr; }
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,231 @@
+// book_view.cpp
+#include "book_view.h"
+#include "aether_frame.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace aether { namespace view {
+
+  static constexpr size_t HEADER_BYTES = 4096;
+  static constexpr int READ_SPINS = 1 << 16;   // before a reader gives up on a stuck writer
+
+  static size_t segment_size(uint32_t depth) {
+    return HEADER_BYTES + sizeof(BookViewTop) + 2 * size_t(depth) * sizeof(Level);
+  }
+
+  template <class T>
+  static T ld(const T &w) {
+    return std::atomic_ref<T>(const_cast<T&>(w)).load(std::memory_order_relaxed);
+  }
+
+  template <class T>
+  static void st(T &w, T v) { std::atomic_ref<T>(w).store(v, std::memory_order_relaxed); }
+
+  static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  std::string view_path(const std::string &dir, const std::string &symbol) {
+    return dir + "/aether." + symbol + ".view";
+  }
+
+  // -- writer --
+
+  BookViewWriter::~BookViewWriter() { close(); }
+
+  bool BookViewWriter::create(const std::string &path, const std::string &symbol, const DecimalScale &scale,
+      uint32_t depth) {
+    close();
+    static_assert(sizeof(BookViewHeader) <= HEADER_BYTES, "BookViewHeader must fit its page");
+    if (depth == 0 || depth > MAX_DEPTH) {
+      std::cerr << "[view] depth must be 1.." << MAX_DEPTH << "\n";
+      return false;
+    }
+    size_t size = segment_size(depth);
+    // replace rather than reuse: a reader still mapping the old file keeps its copy
+    ::unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+      std::cerr << "[view] create " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+      std::cerr << "[view] ftruncate " << path << ": " << strerror(errno) << "\n";
+      ::close(fd);
+      return false;
+    }
+    void *m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+      std::cerr << "[view] mmap " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    map_ = m;
+    map_size_ = size;
+    depth_ = depth;
+    seq_ = 0;
+    auto *hdr = static_cast<BookViewHeader*>(m);
+    top_ = reinterpret_cast<BookViewTop*>(static_cast<uint8_t*>(m) + HEADER_BYTES);
+    bids_ = reinterpret_cast<Level*>(top_ + 1);
+    asks_ = bids_ + depth;
+    hdr->depth = depth;
+    hdr->symbol_id = aether_symbol_id(symbol.c_str());
+    std::strncpy(hdr->symbol, symbol.c_str(), sizeof(hdr->symbol) - 1);
+    hdr->price_decimals = scale.price_decimals;
+    hdr->qty_decimals = scale.qty_decimals;
+    hdr->pid = uint32_t(getpid());
+    hdr->start_unix_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    hdr->version = VIEW_VERSION;
+    // magic last, as for rings: a reader never sees a half-built header
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr->magic = VIEW_MAGIC;
+    std::cerr << "[view] " << path << " (" << symbol << ", depth " << depth << ")\n";
+    return true;
+  }
+
+  void BookViewWriter::close() {
+    if (map_) munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    top_ = nullptr;
+    bids_ = asks_ = nullptr;
+    depth_ = 0;
+  }
+
+  void BookViewWriter::begin() {
+    st(top_->seq, ++seq_);
+    // the odd seq must be visible before any data store
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void BookViewWriter::end(uint64_t last_update_id, uint64_t event_time_ms, uint32_t flags,
+      uint32_t nb, uint32_t na) {
+    st(top_->last_update_id, last_update_id);
+    st(top_->bid_levels, uint16_t(nb));
+    st(top_->ask_levels, uint16_t(na));
+    st(top_->flags, flags);
+    st(top_->best_bid.price, nb ? ld(bids_[0].price) : PriceT(0));
+    st(top_->best_bid.qty, nb ? ld(bids_[0].qty) : SizeT(0));
+    st(top_->best_ask.price, na ? ld(asks_[0].price) : PriceT(0));
+    st(top_->best_ask.qty, na ? ld(asks_[0].qty) : SizeT(0));
+    st(top_->event_time_ms, event_time_ms);
+    std::atomic_ref<uint64_t>(top_->seq).store(++seq_, std::memory_order_release);
+  }
+
+  // -- reader --
+
+  BookViewReader::~BookViewReader() { close(); }
+
+  bool BookViewReader::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "[view] open " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || size_t(sb.st_size) < segment_size(1)) {
+      std::cerr << "[view] " << path << " is not a book view\n";
+      ::close(fd);
+      return false;
+    }
+    void *m = mmap(nullptr, size_t(sb.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+      std::cerr << "[view] mmap " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    map_ = m;
+    map_size_ = size_t(sb.st_size);
+    hdr_ = static_cast<const BookViewHeader*>(m);
+    if (hdr_->magic != VIEW_MAGIC || hdr_->version != VIEW_VERSION || hdr_->depth == 0
+        || hdr_->depth > MAX_DEPTH || segment_size(hdr_->depth) > map_size_) {
+      std::cerr << "[view] " << path << ": magic, version or layout mismatch\n";
+      close();
+      return false;
+    }
+    top_ = reinterpret_cast<const BookViewTop*>(static_cast<const uint8_t*>(m) + HEADER_BYTES);
+    bids_ = reinterpret_cast<const Level*>(top_ + 1);
+    asks_ = bids_ + hdr_->depth;
+    return true;
+  }
+
+  void BookViewReader::close() {
+    if (map_) munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    hdr_ = nullptr;
+    top_ = nullptr;
+    bids_ = asks_ = nullptr;
+  }
+
+  uint64_t BookViewReader::sequence() const noexcept {
+    return top_ ? std::atomic_ref<uint64_t>(const_cast<uint64_t&>(top_->seq)).load(std::memory_order_acquire) : 0;
+  }
+
+  // copy of the top cache line; the caller validates the sequence afterwards
+  static void copy_top(const BookViewTop &t, TopOfBook &out) {
+    out.last_update_id = ld(t.last_update_id);
+    out.event_time_ms = ld(t.event_time_ms);
+    out.flags = ld(t.flags);
+    uint16_t nb = ld(t.bid_levels), na = ld(t.ask_levels);
+    out.has_bid = nb != 0;
+    out.has_ask = na != 0;
+    out.bid = Level{ld(t.best_bid.price), ld(t.best_bid.qty)};
+    out.ask = Level{ld(t.best_ask.price), ld(t.best_ask.qty)};
+  }
+
+  bool BookViewReader::read_top(TopOfBook &out) const {
+    if (!top_) return false;
+    for (int i = 0; i < READ_SPINS; ++i) {
+      uint64_t s0 = sequence();
+      if (s0 & 1) { cpu_relax(); continue; }
+      copy_top(*top_, out);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (ld(top_->seq) == s0) {
+        out.seq = s0;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool BookViewReader::read(DepthSnapshot &out, size_t max_levels) const {
+    if (!top_) return false;
+    size_t cap = max_levels < hdr_->depth ? max_levels : hdr_->depth;
+    for (int i = 0; i < READ_SPINS; ++i) {
+      uint64_t s0 = sequence();
+      if (s0 & 1) { cpu_relax(); continue; }
+      copy_top(*top_, out.top);
+      size_t nb = ld(top_->bid_levels), na = ld(top_->ask_levels);
+      out.bid_levels = nb < cap ? nb : cap;
+      out.ask_levels = na < cap ? na : cap;
+      for (size_t k = 0; k < out.bid_levels; ++k) out.bids[k] = Level{ld(bids_[k].price), ld(bids_[k].qty)};
+      for (size_t k = 0; k < out.ask_levels; ++k) out.asks[k] = Level{ld(asks_[k].price), ld(asks_[k].qty)};
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (ld(top_->seq) == s0) {
+        out.top.seq = s0;
+        return true;
+      }
+    }
+    return false;
+  }
+
+}} // namespace aether::view
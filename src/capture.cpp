@@ -0,0 +1,234 @@
+// capture.cpp
+#include "capture.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <zlib.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace aether {
+
+  static constexpr uint32_t CAPTURE_MAGIC =
+    (uint32_t('A') << 24) | (uint32_t('C') << 16) |
+    (uint32_t('A') << 8)  | uint32_t('P'); // "ACAP"
+  static constexpr uint16_t CAPTURE_VERSION = 1;
+  // slots that held a large body (snapshots) give the memory back after writing
+  static constexpr size_t SLOT_KEEP_BYTES = 64 << 10;
+
+  static uint64_t wall_now_us() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+  }
+
+  static bool write_all(int fd, const void *p, size_t n) {
+    const uint8_t *b = static_cast<const uint8_t*>(p);
+    while (n) {
+      ssize_t w = ::write(fd, b, n);
+      if (w < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      b += w; n -= size_t(w);
+    }
+    return true;
+  }
+
+  // -- channel ------------------------------------------------------------------
+
+  CaptureChannel::CaptureChannel(size_t records, size_t max_bytes)
+    : q_(records), max_bytes_(max_bytes) {}
+
+  bool CaptureChannel::record(uint8_t kind, uint64_t mono_us, const void *payload, size_t len) {
+    if (queued_bytes_.load(std::memory_order_relaxed) + len > max_bytes_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    Slot *s = q_.try_claim();
+    if (!s) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    s->kind = kind;
+    s->mono_us = mono_us;
+    s->wall_us = wall_now_us();
+    const uint8_t *p = static_cast<const uint8_t*>(payload);
+    s->data.assign(p, p + len);
+    queued_bytes_.fetch_add(len, std::memory_order_relaxed);
+    q_.publish();
+    recorded_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // -- writer -------------------------------------------------------------------
+
+  CaptureWriter::CaptureWriter(const CaptureConfig &cfg) : cfg_(cfg) {}
+
+  CaptureWriter::~CaptureWriter() { stop(); }
+
+  CaptureChannel *CaptureWriter::add_channel() {
+    if (started_) return nullptr;
+    channels_.push_back(std::make_unique<CaptureChannel>(cfg_.channel_records, cfg_.channel_max_bytes));
+    return channels_.back().get();
+  }
+
+  bool CaptureWriter::start() {
+    if (started_ || cfg_.path.empty()) return false;
+    fd_ = ::open(cfg_.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      std::cerr << "[capture] open " << cfg_.path << " failed: " << strerror(errno) << "\n";
+      return false;
+    }
+    CaptureFileHeader h{};
+    h.magic = CAPTURE_MAGIC;
+    h.version = CAPTURE_VERSION;
+    if (!write_all(fd_, &h, sizeof(h))) {
+      ::close(fd_); fd_ = -1;
+      return false;
+    }
+    raw_.reserve(cfg_.block_bytes + SLOT_KEEP_BYTES);
+    comp_.reserve(compressBound(uLong(cfg_.block_bytes)) + sizeof(CaptureBlockHeader));
+    started_ = true;
+    thread_ = std::thread([this] { run(); });
+    std::cerr << "[capture] recording to " << cfg_.path << "\n";
+    return true;
+  }
+
+  void CaptureWriter::stop() {
+    if (!started_) return;
+    stop_.store(true, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+    started_ = false;
+    std::cerr << "[capture] stopped: records=" << records_written() << " dropped=" << dropped()
+      << " raw=" << bytes_raw() << " compressed=" << bytes_compressed() << "\n";
+  }
+
+  uint64_t CaptureWriter::dropped() const noexcept {
+    uint64_t n = 0;
+    for (const auto &c : channels_) n += c->dropped();
+    return n;
+  }
+
+  size_t CaptureWriter::drain(CaptureChannel &ch) {
+    return ch.q_.try_pop_n([&](CaptureChannel::Slot &s) {
+        CaptureRecordHeader h{};
+        h.len = uint32_t(s.data.size());
+        h.kind = s.kind;
+        h.mono_us = s.mono_us;
+        h.wall_us = s.wall_us;
+        raw_.insert(raw_.end(), reinterpret_cast<uint8_t*>(&h), reinterpret_cast<uint8_t*>(&h) + sizeof(h));
+        raw_.insert(raw_.end(), s.data.begin(), s.data.end());
+        ++block_records_;
+        ch.queued_bytes_.fetch_sub(s.data.size(), std::memory_order_relaxed);
+        if (s.data.capacity() > SLOT_KEEP_BYTES) std::vector<uint8_t>().swap(s.data);
+        if (raw_.size() >= cfg_.block_bytes) write_block();
+        return true;
+    }, 256);
+  }
+
+  void CaptureWriter::write_block() {
+    if (raw_.empty()) return;
+    uLongf comp_len = compressBound(uLong(raw_.size()));
+    comp_.resize(sizeof(CaptureBlockHeader) + comp_len);
+    int rc = compress2(comp_.data() + sizeof(CaptureBlockHeader), &comp_len,
+        raw_.data(), uLong(raw_.size()), cfg_.level);
+    if (rc != Z_OK) {
+      std::cerr << "[capture] compress failed (" << rc << "), dropping " << block_records_ << " records\n";
+    } else {
+      CaptureBlockHeader bh{};
+      bh.raw_len = uint32_t(raw_.size());
+      bh.comp_len = uint32_t(comp_len);
+      bh.records = block_records_;
+      bh.crc = uint32_t(crc32(0, raw_.data(), uInt(raw_.size())));
+      std::memcpy(comp_.data(), &bh, sizeof(bh));
+      if (!write_all(fd_, comp_.data(), sizeof(bh) + comp_len))
+        std::cerr << "[capture] write failed: " << strerror(errno) << "\n";
+      records_.fetch_add(block_records_, std::memory_order_relaxed);
+      bytes_raw_.fetch_add(raw_.size(), std::memory_order_relaxed);
+      bytes_comp_.fetch_add(sizeof(bh) + comp_len, std::memory_order_relaxed);
+    }
+    raw_.clear();
+    block_records_ = 0;
+  }
+
+  void CaptureWriter::run() {
+    rt::apply_thread_policy(cfg_.thread, "aether-capture");
+    using clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::milliseconds(cfg_.flush_interval_ms);
+    auto block_started = clock::now();
+    while (true) {
+      size_t n = 0;
+      for (auto &c : channels_) n += drain(*c);
+      if (raw_.empty()) block_started = clock::now();
+      else if (clock::now() - block_started >= interval) write_block();
+      if (n == 0) {
+        if (stop_.load(std::memory_order_acquire)) {
+          // producers may still have raced in a last record
+          size_t left = 0;
+          for (auto &c : channels_) left += drain(*c);
+          if (left == 0) break;
+          continue;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    write_block();
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+  // -- reader -------------------------------------------------------------------
+
+  bool is_capture_file(const std::string &path) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    CaptureFileHeader h;
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1 && h.magic == CAPTURE_MAGIC;
+    std::fclose(f);
+    return ok;
+  }
+
+  bool read_capture(const std::string &path, std::vector<FeedRecord> &out) {
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    CaptureFileHeader fh;
+    if (std::fread(&fh, sizeof(fh), 1, f) != 1 || fh.magic != CAPTURE_MAGIC || fh.version != CAPTURE_VERSION) {
+      std::fclose(f);
+      return false;
+    }
+    std::vector<uint8_t> comp, raw;
+    CaptureBlockHeader bh;
+    while (std::fread(&bh, sizeof(bh), 1, f) == 1) {
+      comp.resize(bh.comp_len);
+      raw.resize(bh.raw_len);
+      if (std::fread(comp.data(), 1, comp.size(), f) != comp.size()) break; // torn tail
+      uLongf raw_len = bh.raw_len;
+      if (uncompress(raw.data(), &raw_len, comp.data(), uLong(comp.size())) != Z_OK ||
+          raw_len != bh.raw_len || uint32_t(crc32(0, raw.data(), uInt(raw.size()))) != bh.crc) {
+        std::cerr << "[capture] corrupt block in " << path << ", stopping\n";
+        break;
+      }
+      size_t pos = 0;
+      for (uint32_t i = 0; i < bh.records && pos + sizeof(CaptureRecordHeader) <= raw.size(); ++i) {
+        CaptureRecordHeader rh;
+        std::memcpy(&rh, raw.data() + pos, sizeof(rh));
+        pos += sizeof(rh);
+        if (pos + rh.len > raw.size()) break;
+        FeedRecord r;
+        r.kind = rh.kind;
+        r.recv_us = rh.mono_us;
+        r.wall_us = rh.wall_us;
+        r.body.assign(reinterpret_cast<const char*>(raw.data() + pos), rh.len);
+        pos += rh.len;
+        out.push_back(std::move(r));
+      }
+    }
+    std::fclose(f);
+    return true;
+  }
+
+} // namespace aether
@@ -0,0 +1,57 @@
+// conflator.cpp
+#include "conflator.h"
+
+#include <algorithm>
+
+namespace aether {
+
+  bool parse_conflate_mode(const std::string &s, ConflateMode &out) {
+    if (s == "off") out = ConflateMode::Off;
+    else if (s == "always") out = ConflateMode::Always;
+    else if (s == "lag") out = ConflateMode::OnLag;
+    else return false;
+    return true;
+  }
+
+  void Conflator::add(const DepthDelta &d, uint64_t local_recv_us, uint64_t now_ns) {
+    if (deltas_ == 0) {
+      merged_.first_update_id = d.first_update_id;
+      started_ns_ = now_ns;
+    }
+    merged_.final_update_id = d.final_update_id;
+    merged_.event_time_ms = d.event_time_ms;
+    last_recv_us_ = local_recv_us;
+    ++deltas_;
+    for (const Level &l : d.bids) bids_.push_back(Entry{l.price, order_++, l.qty});
+    for (const Level &l : d.asks) asks_.push_back(Entry{l.price, order_++, l.qty});
+  }
+
+  // sort by price (best first), newest first within a price, then keep the first
+  // entry of every price
+  template <class Better>
+  static void fold(std::vector<Conflator::Entry> &in, std::vector<Level> &out, Better better) {
+    std::sort(in.begin(), in.end(), [&](const auto &a, const auto &b) {
+        if (a.price != b.price) return better(a.price, b.price);
+        return a.order > b.order;
+    });
+    out.clear();
+    for (size_t i = 0; i < in.size(); ++i)
+      if (i == 0 || in[i].price != in[i - 1].price) out.push_back(Level{in[i].price, in[i].qty});
+  }
+
+  const DepthDelta &Conflator::merge() {
+    fold(bids_, merged_.bids, [](PriceT a, PriceT b) { return a > b; });
+    fold(asks_, merged_.asks, [](PriceT a, PriceT b) { return a < b; });
+    return merged_;
+  }
+
+  void Conflator::clear() noexcept {
+    bids_.clear();
+    asks_.clear();
+    merged_.bids.clear();
+    merged_.asks.clear();
+    deltas_ = 0;
+    order_ = 0;
+  }
+
+} // namespace aether
@@ -0,0 +1,195 @@
+// depth_decoder.cpp
+#include "depth_decoder.h"
+#include <cstring>
+
+namespace aether {
+
+  namespace {
+
+    struct Cursor {
+      const char *p;
+      const char *end;
+    };
+
+    inline void skip_ws(Cursor &c) {
+      while (c.p < c.end && (*c.p == ' ' || *c.p == '\n' || *c.p == '\r' || *c.p == '\t')) ++c.p;
+    }
+
+    inline bool expect(Cursor &c, char ch) {
+      skip_ws(c);
+      if (c.p < c.end && *c.p == ch) { ++c.p; return true; }
+      return false;
+    }
+
+    // returns the raw bytes between the quotes; escapes are skipped, not decoded
+    // (nothing we read from a depthUpdate contains them)
+    inline bool read_string(Cursor &c, const char *&b, const char *&e) {
+      skip_ws(c);
+      if (c.p >= c.end || *c.p != '"') return false;
+      ++c.p;
+      b = c.p;
+      while (c.p < c.end && *c.p != '"') {
+        if (*c.p == '\\') ++c.p;
+        ++c.p;
+      }
+      if (c.p >= c.end) return false;
+      e = c.p;
+      ++c.p;
+      return true;
+    }
+
+    inline bool read_uint(Cursor &c, uint64_t &out) {
+      skip_ws(c);
+      const char *start = c.p;
+      uint64_t v = 0;
+      while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+        v = v * 10 + uint64_t(*c.p - '0');
+        ++c.p;
+      }
+      if (c.p == start || c.p - start > 19) return false;
+      out = v;
+      return true;
+    }
+
+    // skip any JSON value we do not care about
+    bool skip_value(Cursor &c) {
+      skip_ws(c);
+      if (c.p >= c.end) return false;
+      const char *b, *e;
+      if (*c.p == '"') return read_string(c, b, e);
+      if (*c.p == '{' || *c.p == '[') {
+        int depth = 0;
+        while (c.p < c.end) {
+          char ch = *c.p;
+          if (ch == '"') {
+            if (!read_string(c, b, e)) return false;
+            continue;
+          }
+          if (ch == '{' || ch == '[') ++depth;
+          else if (ch == '}' || ch == ']') {
+            if (--depth == 0) { ++c.p; return true; }
+          }
+          ++c.p;
+        }
+        return false;
+      }
+      // number / true / false / null
+      const char *start = c.p;
+      while (c.p < c.end && *c.p != ',' && *c.p != '}' && *c.p != ']' &&
+             *c.p != ' ' && *c.p != '\n' && *c.p != '\r' && *c.p != '\t') ++c.p;
+      return c.p != start;
+    }
+
+    // [["price","qty"], ...]
+    bool read_levels(Cursor &c, const DecimalScale &sc, std::vector<Level> &out) {
+      if (!expect(c, '[')) return false;
+      skip_ws(c);
+      if (c.p < c.end && *c.p == ']') { ++c.p; return true; }
+      while (true) {
+        if (!expect(c, '[')) return false;
+        const char *pb, *pe, *qb, *qe;
+        if (!read_string(c, pb, pe)) return false;
+        if (!expect(c, ',')) return false;
+        if (!read_string(c, qb, qe)) return false;
+        // tolerate trailing elements in a level tuple
+        while (expect(c, ',')) {
+          if (!skip_value(c)) return false;
+        }
+        if (!expect(c, ']')) return false;
+        Level lvl;
+        if (!parse_decimal(pb, pe, sc.price_decimals, lvl.price)) return false;
+        if (!parse_decimal(qb, qe, sc.qty_decimals, lvl.qty)) return false;
+        out.push_back(lvl);
+        skip_ws(c);
+        if (c.p >= c.end) return false;
+        if (*c.p == ',') { ++c.p; continue; }
+        if (*c.p == ']') { ++c.p; return true; }
+        return false;
+      }
+    }
+
+    // body of one depthUpdate object; with allow_envelope a combined-stream wrapper
+    // {"stream":..,"data":{..}} is unwrapped
+    DecodeStatus decode_object(Cursor &c, DepthDelta &out, const DecimalScale &scale, bool allow_envelope) {
+      if (!expect(c, '{')) return DecodeStatus::Malformed;
+
+      bool is_depth = false, have_U = false, have_u = false;
+      DecodeStatus inner = DecodeStatus::NotDepthUpdate;
+      bool wrapped = false;
+      skip_ws(c);
+      if (c.p < c.end && *c.p == '}') return DecodeStatus::NotDepthUpdate;
+
+      while (true) {
+        const char *kb, *ke;
+        if (!read_string(c, kb, ke)) return DecodeStatus::Malformed;
+        if (!expect(c, ':')) return DecodeStatus::Malformed;
+
+        bool ok = true;
+        if (ke - kb == 1) {
+          switch (*kb) {
+            case 'e': {
+              const char *vb, *ve;
+              ok = read_string(c, vb, ve);
+              if (!ok) break;
+              static constexpr char kDepth[] = "depthUpdate";
+              if (size_t(ve - vb) != sizeof(kDepth) - 1) return DecodeStatus::NotDepthUpdate;
+              for (size_t i = 0; i < sizeof(kDepth) - 1; ++i)
+                if (vb[i] != kDepth[i]) return DecodeStatus::NotDepthUpdate;
+              is_depth = true;
+              break;
+            }
+            case 'E': ok = read_uint(c, out.event_time_ms); break;
+            case 'U': ok = read_uint(c, out.first_update_id); have_U = ok; break;
+            case 'u': ok = read_uint(c, out.final_update_id); have_u = ok; break;
+            case 'b': ok = read_levels(c, scale, out.bids); break;
+            case 'a': ok = read_levels(c, scale, out.asks); break;
+            default:  ok = skip_value(c); break;
+          }
+        } else if (allow_envelope && ke - kb == 4 && kb[0] == 'd' && kb[1] == 'a' && kb[2] == 't' && kb[3] == 'a') {
+          inner = decode_object(c, out, scale, false);
+          if (inner != DecodeStatus::Ok) return inner;
+          wrapped = true;
+        } else {
+          ok = skip_value(c);
+        }
+        if (!ok) return DecodeStatus::Malformed;
+
+        skip_ws(c);
+        if (c.p >= c.end) return DecodeStatus::Malformed;
+        if (*c.p == ',') { ++c.p; continue; }
+        if (*c.p == '}') { ++c.p; break; }
+        return DecodeStatus::Malformed;
+      }
+
+      if (wrapped) return inner;
+      if (!is_depth) return DecodeStatus::NotDepthUpdate;
+      if (!have_U || !have_u) return DecodeStatus::Malformed;
+      return DecodeStatus::Ok;
+    }
+
+  } // namespace
+
+  DecodeStatus decode_depth_update(const char *data, size_t len, DepthDelta &out,
+      const DecimalScale &scale) {
+    out.clear();
+    Cursor c{data, data + len};
+    return decode_object(c, out, scale, true);
+  }
+
+  std::string_view depth_frame_symbol(const char *data, size_t len) {
+    static constexpr char kKey[] = "\"s\":\"";
+    constexpr size_t klen = sizeof(kKey) - 1;
+    const char *end = data + len;
+    for (const char *p = data; p + klen <= end; ++p) {
+      p = static_cast<const char*>(std::memchr(p, '"', size_t(end - p)));
+      if (!p || p + klen > end) break;
+      if (std::memcmp(p, kKey, klen) != 0) continue;
+      const char *b = p + klen;
+      const char *e = static_cast<const char*>(std::memchr(b, '"', size_t(end - b)));
+      if (!e) break;
+      return std::string_view(b, size_t(e - b));
+    }
+    return std::string_view();
+  }
+
+} // namespace aether
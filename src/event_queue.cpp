@@ -1,48 +1,32 @@
 // event_queue.cpp
 #include "event_queue.h"
+#include <thread>
 
-EventQueue::EventQueue() = default;
+EventQueue::EventQueue(size_t capacity) : q_(capacity) {}
 EventQueue::~EventQueue() = default;
 
-void EventQueue::push(JsonEvent &&e) {
-  {
-    std::lock_guard<std::mutex> lk(m_);
-    dq_.push_back(std::move(e));
-  }
-  cv_.notify_one();
+void EventQueue::prewarm(size_t levels_per_side) {
+  q_.for_each_slot([levels_per_side](DepthEvent &e) {
+      e.delta.bids.reserve(levels_per_side);
+      e.delta.asks.reserve(levels_per_side);
+  });
 }
 
-JsonEvent EventQueue::pop_blocking() {
-  std::unique_lock<std::mutex> lk(m_);
-  cv_.wait(lk, [&]{ return !dq_.empty(); });
-  JsonEvent e = std::move(dq_.front());
-  dq_.pop_front();
-  return e;
+void EventQueue::push(DepthEvent &&e) {
+  while (!q_.try_push(std::move(e))) std::this_thread::yield();
 }
 
-size_t EventQueue::size() {
-  std::lock_guard<std::mutex> lk(m_);
-  return dq_.size();
+void EventQueue::pop_blocking(DepthEvent &e) {
+  q_.pop(e);
 }
 
-bool EventQueue::peek_first_U(uint64_t &outU) {
-  std::lock_guard<std::mutex> lk(m_);
-  if (dq_.empty()) return false;
-  try {
-    outU = dq_.front().j.at("U").get<uint64_t>();
-    return true;
-  } catch(...) {
-    return false;
-  }
+size_t EventQueue::size() {
+  return q_.size();
 }
 
-std::vector<JsonEvent> EventQueue::drain_all() {
-  std::lock_guard<std::mutex> lk(m_);
-  std::vector<JsonEvent> v;
-  v.reserve(dq_.size());
-  while (!dq_.empty()) {
-    v.push_back(std::move(dq_.front()));
-    dq_.pop_front();
-  }
-  return v;
+bool EventQueue::peek_first_U(uint64_t &outU) {
+  DepthEvent *e = q_.front();
+  if (!e) return false;
+  outU = e->delta.first_update_id;
+  return true;
 }
@@ -0,0 +1,78 @@
+// feed_source.cpp
+#include "feed_source.h"
+#include "log.h"
+#include <thread>
+#include <nlohmann/json.hpp>
+
+namespace aether {
+
+  static bool scale_from_symbol(const nlohmann::json &sym, DecimalScale &scale) {
+    std::string tick, step;
+    for (const auto &f : sym.at("filters")) {
+      const auto &type = f.at("filterType").get_ref<const std::string&>();
+      if (type == "PRICE_FILTER") tick = f.at("tickSize").get<std::string>();
+      else if (type == "LOT_SIZE") step = f.at("stepSize").get<std::string>();
+    }
+    if (DecimalScale::from_filters(tick, step, scale)) return true;
+    scale = DecimalScale{};
+    return false;
+  }
+
+  bool scale_from_exchange_info(const std::string &body, DecimalScale &scale) {
+    scale = DecimalScale{};
+    try {
+      nlohmann::json info = nlohmann::json::parse(body);
+      return scale_from_symbol(info.at("symbols").at(0), scale);
+    } catch (...) {
+    }
+    scale = DecimalScale{};
+    return false;
+  }
+
+  size_t scales_from_exchange_info(const std::string &body,
+      std::unordered_map<std::string, DecimalScale> &scales) {
+    size_t n = 0;
+    try {
+      nlohmann::json info = nlohmann::json::parse(body);
+      for (const auto &sym : info.at("symbols")) {
+        DecimalScale sc;
+        if (!scale_from_symbol(sym, sc)) continue;
+        scales[sym.at("symbol").get<std::string>()] = sc;
+        ++n;
+      }
+    } catch (...) {
+    }
+    return n;
+  }
+
+  void SnapshotSource::request_snapshot(std::shared_ptr<SnapshotRequest> req, int) {
+    req->state.store(SnapshotRequest::Fetching, std::memory_order_relaxed);
+    while (!req->cancelled.load(std::memory_order_relaxed)) {
+      std::string body;
+      try {
+        if (!fetch_snapshot(req->symbol, body)) break;
+        req->snapshot = nlohmann::json::parse(body);
+        req->snapshot.at("lastUpdateId").get<uint64_t>();
+        req->state.store(SnapshotRequest::Ready, std::memory_order_release);
+        return;
+      } catch (...) {
+        AETHER_LOG_WARN("[feed] {} unusable snapshot, trying the next one", req->symbol);
+      }
+    }
+    req->state.store(SnapshotRequest::Failed, std::memory_order_release);
+  }
+
+  void push_end_of_stream(EventQueue &queue, const std::atomic<bool> &stop) {
+    DepthEvent *ev = queue.try_claim();
+    while (!ev && !stop.load()) {
+      std::this_thread::yield();
+      ev = queue.try_claim();
+    }
+    if (!ev) return;
+    ev->delta.clear();
+    ev->local_recv_ts_us = 0;
+    ev->end_of_stream = true;
+    queue.publish();
+  }
+
+} // namespace aether
@@ -0,0 +1,79 @@
+// frame_codec.cpp
+#include "frame_codec.h"
+
+namespace aether {
+
+  static_assert(sizeof(Level) == sizeof(aether_level), "Level must match aether_level");
+
+  size_t encode_depth_frame(void *buf, size_t cap, const FrameMeta &meta,
+      const DepthDelta &d, uint64_t local_ts_us, uint16_t flags) {
+    size_t need = depth_frame_size(d);
+    if (cap < need) return 0;
+
+    aether_frame_header h{};
+    h.version = AETHER_FRAME_VERSION;
+    h.flags = flags;
+    h.symbol_id = meta.symbol_id;
+    h.first_update_id = d.first_update_id;
+    h.final_update_id = d.final_update_id;
+    h.exch_ts_ms = d.event_time_ms;
+    h.local_ts_us = local_ts_us;
+    h.bid_count = uint32_t(d.bids.size());
+    h.ask_count = uint32_t(d.asks.size());
+    h.price_decimals = int8_t(meta.scale.price_decimals);
+    h.qty_decimals = int8_t(meta.scale.qty_decimals);
+
+    uint8_t *p = static_cast<uint8_t*>(buf);
+    std::memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    // Level is {int64 price, int64 qty} like aether_level: copy the arrays wholesale
+    if (!d.bids.empty()) std::memcpy(p, d.bids.data(), d.bids.size() * sizeof(Level));
+    p += d.bids.size() * sizeof(Level);
+    if (!d.asks.empty()) std::memcpy(p, d.asks.data(), d.asks.size() * sizeof(Level));
+    return need;
+  }
+
+  size_t append_analytics(void *buf, size_t cap, size_t n, const BookAnalytics &a) {
+    if (n < sizeof(aether_frame_header) || cap < n + sizeof(aether_analytics)) return 0;
+    aether_analytics t{};
+    t.bid_price = a.bid.price;
+    t.bid_qty = a.bid.qty;
+    t.ask_price = a.ask.price;
+    t.ask_qty = a.ask.qty;
+    t.spread = a.spread;
+    t.bid_depth_qty = a.bid_qty;
+    t.ask_depth_qty = a.ask_qty;
+    t.bid_depth_notional = a.bid_notional;
+    t.ask_depth_notional = a.ask_notional;
+    t.mid = a.mid;
+    t.microprice = a.microprice;
+    t.imbalance = a.imbalance;
+    t.depth = uint16_t(a.depth);
+    t.bid_levels = uint16_t(a.bid_levels);
+    t.ask_levels = uint16_t(a.ask_levels);
+    uint8_t *p = static_cast<uint8_t*>(buf);
+    std::memcpy(p + n, &t, sizeof(t));
+    // flags sit right after the version in the header
+    uint16_t flags;
+    std::memcpy(&flags, p + offsetof(aether_frame_header, flags), sizeof(flags));
+    flags |= AETHER_FRAME_FLAG_ANALYTICS;
+    std::memcpy(p + offsetof(aether_frame_header, flags), &flags, sizeof(flags));
+    return n + sizeof(t);
+  }
+
+  size_t encode_resync_frame(void *buf, size_t cap, const FrameMeta &meta,
+      uint64_t last_applied_u, uint64_t gap_U, uint64_t local_ts_us) {
+    if (cap < sizeof(aether_frame_header)) return 0;
+    aether_frame_header h{};
+    h.version = AETHER_FRAME_VERSION;
+    h.symbol_id = meta.symbol_id;
+    h.first_update_id = last_applied_u;
+    h.final_update_id = gap_U;
+    h.local_ts_us = local_ts_us;
+    h.price_decimals = int8_t(meta.scale.price_decimals);
+    h.qty_decimals = int8_t(meta.scale.qty_decimals);
+    std::memcpy(buf, &h, sizeof(h));
+    return sizeof(h);
+  }
+
+} // namespace aether
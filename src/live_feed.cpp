@@ -0,0 +1,160 @@
+// live_feed.cpp
+#include "live_feed.h"
+#include "log.h"
+#include "ws_client.h"
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+#include <boost/system/system_error.hpp>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace net = boost::asio;
+using aether::SnapshotRequest;
+
+static uint64_t mono_now_us() {
+  using namespace std::chrono;
+  return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+LiveFeed::LiveFeed(aether::NetLoop &loop, const LiveFeedConfig &cfg)
+  : loop_(loop), cfg_(cfg), rest_(loop, cfg.rest), snapshots_(loop, rest_, cfg.snapshots) {
+  // stream names are lowercase, rest endpoints need the symbol in uppercase
+  for (std::string s : cfg_.symbols) {
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+    symbols_.push_back(s);
+    std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+    symbols_upper_.push_back(s);
+  }
+}
+
+LiveFeed::~LiveFeed() { join(); }
+
+void LiveFeed::record(uint8_t kind, const std::string &body) {
+  if (!rest_capture_) return;
+  std::lock_guard<std::mutex> lk(rest_capture_mu_); // the channel is single-producer
+  rest_capture_->record(kind, mono_now_us(), body.data(), body.size());
+}
+
+std::string LiveFeed::get(const std::string &target, uint8_t kind) {
+  std::string body = rest_.get_blocking(target);
+  record(kind, body);
+  return body;
+}
+
+std::string LiveFeed::exchange_info() {
+  std::string target = "/api/v3/exchangeInfo?symbol=" + symbols_upper_.at(0);
+  if (symbols_upper_.size() > 1) {
+    target = "/api/v3/exchangeInfo?symbols=%5B";
+    for (size_t i = 0; i < symbols_upper_.size(); ++i) {
+      if (i) target += ",";
+      target += "%22" + symbols_upper_[i] + "%22";
+    }
+    target += "%5D";
+  }
+  try {
+    return get(target, aether::FeedRecord::ExchangeInfo);
+  } catch (const std::exception &ex) {
+    AETHER_LOG_WARN("[live_feed] exchangeInfo fetch failed: {}", ex.what());
+    return std::string();
+  }
+}
+
+void LiveFeed::start(const aether::DecimalScale &scale, EventQueue &queue, std::atomic<bool> &stop) {
+  reader_ = aether::spawn_ws_reader(loop_, cfg_.ws, symbols_.at(0), cfg_.update_speed, scale, queue, stop, ws_capture_, stats_);
+}
+
+void LiveFeed::start_combined(const aether::SymbolRouter &router, std::atomic<bool> &stop) {
+  reader_ = aether::spawn_combined_ws_reader(loop_, cfg_.ws, symbols_, cfg_.update_speed, router, stop, ws_capture_, stats_);
+}
+
+std::string LiveFeed::depth_target(const std::string &symbol) const {
+  return "/api/v3/depth?symbol=" + symbol + "&limit=" + std::to_string(cfg_.snapshot_limit);
+}
+
+bool LiveFeed::fetch_snapshot(const std::string &symbol, std::string &body) {
+  if (loop_.cancelled()) return false; // shutting down: no point retrying
+  std::future<aether::HttpResponse> fut = net::co_spawn(loop_.context(),
+      snapshots_.get(depth_target(symbol), aether::depth_request_weight(cfg_.snapshot_limit), [] {}),
+      net::use_future);
+  while (fut.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+    if (!loop_.running()) return false;
+  aether::HttpResponse res = fut.get();
+  if (res.status != 200)
+    throw std::runtime_error("snapshot " + symbol + ": HTTP " + std::to_string(res.status));
+  record(aether::FeedRecord::Snapshot, res.body);
+  body = std::move(res.body);
+  return true;
+}
+
+void LiveFeed::request_snapshot(std::shared_ptr<SnapshotRequest> req, int delay_ms) {
+  net::co_spawn(loop_.context(), fetch(std::move(req), delay_ms), net::detached);
+}
+
+// one symbol's snapshot, retried until it parses, the exchange refuses it for good,
+// the pipeline cancels or the loop shuts down
+net::awaitable<void> LiveFeed::fetch(std::shared_ptr<SnapshotRequest> req, int delay_ms) {
+  net::steady_timer timer(co_await net::this_coro::executor);
+  std::string target = depth_target(req->symbol);
+  uint32_t weight = aether::depth_request_weight(cfg_.snapshot_limit);
+  int delay = delay_ms;
+  while (!req->cancelled.load(std::memory_order_relaxed) && !loop_.cancelled()) {
+    try {
+      if (delay > 0) {
+        timer.expires_after(std::chrono::milliseconds(delay));
+        aether::NetLoop::CancelScope scope(loop_, [&timer] { timer.cancel(); });
+        boost::system::error_code ec;
+        co_await timer.async_wait(net::redirect_error(net::use_awaitable, ec));
+        if (req->cancelled.load(std::memory_order_relaxed) || loop_.cancelled()) break;
+      }
+      delay = retry_delay_ms();
+      aether::HttpResponse res = co_await snapshots_.get(target, weight,
+          [&req] { req->state.store(SnapshotRequest::Fetching, std::memory_order_relaxed); });
+      if (res.status == 200) {
+        record(aether::FeedRecord::Snapshot, res.body);
+        req->snapshot = nlohmann::json::parse(res.body);
+        req->snapshot.at("lastUpdateId").get<uint64_t>();
+        req->state.store(SnapshotRequest::Ready, std::memory_order_release);
+        co_return;
+      }
+      if (res.status == 429 || res.status == 418) {
+        delay = 0; // the scheduler holds every request back for now
+      } else if (res.status >= 400 && res.status < 500) {
+        AETHER_LOG_ERROR("[live_feed] {} snapshot refused: HTTP {} {}", req->symbol, res.status, res.body);
+        break;
+      } else {
+        AETHER_LOG_WARN("[live_feed] {} snapshot: HTTP {}, retrying", req->symbol, res.status);
+      }
+    } catch (const boost::system::system_error &ex) {
+      if (!loop_.cancelled()) AETHER_LOG_WARN("[live_feed] {} snapshot fetch error: {}", req->symbol, ex.what());
+    } catch (const std::exception &ex) {
+      AETHER_LOG_WARN("[live_feed] {} unusable snapshot: {}", req->symbol, ex.what());
+    }
+    req->state.store(SnapshotRequest::Queued, std::memory_order_relaxed);
+  }
+  req->state.store(SnapshotRequest::Failed, std::memory_order_release);
+}
+
+aether::SnapshotSchedulerStats LiveFeed::snapshot_stats() {
+  if (!loop_.running()) return snapshots_.stats();
+  auto p = std::make_shared<std::promise<aether::SnapshotSchedulerStats>>();
+  std::future<aether::SnapshotSchedulerStats> fut = p->get_future();
+  net::post(loop_.context(), [this, p] { p->set_value(snapshots_.stats()); });
+  while (fut.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+    if (!loop_.running()) return aether::SnapshotSchedulerStats();
+  return fut.get();
+}
+
+void LiveFeed::join() {
+  if (!reader_.valid()) return;
+  // a loop stopped under a live reader never completes it
+  while (reader_.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+    if (!loop_.running()) return;
+  reader_.get();
+}
@@ -0,0 +1,372 @@
+// log.cpp
+#include "log.h"
+#include "tsc_clock.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aether { namespace log {
+
+  std::atomic<int> g_level{Info};
+
+  namespace {
+
+    // every record starts 8-aligned with this header; a PAD_LEVEL header skips the
+    // rest of the buffer (records never wrap)
+    struct RecordHeader {
+      uint32_t len;         // bytes including the header, multiple of 8
+      uint32_t level;
+      FormatFn fn;
+      const char *fmt;
+      uint64_t tsc;
+    };
+    constexpr uint32_t PAD_LEVEL = 0xFFFFFFFFu;
+
+    // byte SPSC ring: the owning thread writes, the logger thread reads
+    struct ThreadBuffer {
+      explicit ThreadBuffer(size_t cap) : buf(cap), mask(cap - 1) {}
+      std::vector<uint8_t> buf;
+      uint64_t mask;
+      alignas(64) std::atomic<uint64_t> head{0};
+      uint64_t pending = 0;        // producer: end of the reserved record
+      std::atomic<bool> busy{false}; // producer: between reserve() and commit()
+      uint64_t tail_cache = 0;
+      alignas(64) std::atomic<uint64_t> tail{0};
+      std::atomic<bool> exited{false};
+    };
+
+    struct Logger {
+      ~Logger() { stop(); }
+      std::mutex mu;               // guards buffers (registration and removal only)
+      std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+      std::atomic<bool> running{false};
+      std::thread thread;
+      Config cfg;
+      int fd = STDERR_FILENO;
+      uint64_t base_tsc = 0;
+      int64_t base_wall_ns = 0;
+      double ticks_per_ns = 1.0;
+      std::atomic<uint64_t> dropped{0};
+      std::atomic<uint64_t> suppressed{0};
+    };
+
+    Logger &logger() {
+      static Logger l;
+      return l;
+    }
+
+    struct ThreadState {
+      ~ThreadState() { if (buf) buf->exited.store(true, std::memory_order_release); }
+      std::shared_ptr<ThreadBuffer> buf;
+      std::vector<uint8_t> scratch; // record being built while the logger is not running
+      bool inline_mode = false;
+    };
+    thread_local ThreadState t_state;
+
+    int64_t wall_now_ns() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    const char level_char[] = {'D', 'I', 'W', 'E'};
+
+    // "2026-01-02 13:04:05.123456 I "
+    void put_prefix(std::string &out, int64_t wall_ns, uint32_t level) {
+      time_t secs = time_t(wall_ns / 1000000000);
+      struct tm tm;
+      localtime_r(&secs, &tm);
+      char buf[48];
+      size_t n = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+      n += size_t(std::snprintf(buf + n, sizeof(buf) - n, ".%06d %c ", int(wall_ns % 1000000000 / 1000),
+            level < 4 ? level_char[level] : '?'));
+      out.append(buf, n);
+    }
+
+    void format_line(std::string &out, const RecordHeader &h, int64_t wall_ns) {
+      put_prefix(out, wall_ns, h.level);
+      h.fn(out, h.fmt, reinterpret_cast<const uint8_t*>(&h) + sizeof(RecordHeader));
+      out += '\n';
+    }
+
+    void write_all(int fd, const std::string &s) {
+      size_t off = 0;
+      while (off < s.size()) {
+        ssize_t n = ::write(fd, s.data() + off, s.size() - off);
+        if (n <= 0) {
+          if (n < 0 && errno == EINTR) continue;
+          return;
+        }
+        off += size_t(n);
+      }
+    }
+
+    // formats every committed record of b into out; returns records drained
+    size_t drain(Logger &lg, ThreadBuffer &b, std::string &out) {
+      uint64_t tail = b.tail.load(std::memory_order_relaxed);
+      uint64_t head = b.head.load(std::memory_order_acquire);
+      size_t n = 0;
+      while (tail < head) {
+        const RecordHeader &h = *reinterpret_cast<const RecordHeader*>(&b.buf[tail & b.mask]);
+        if (h.level != PAD_LEVEL) {
+          int64_t wall = lg.base_wall_ns + int64_t(double(int64_t(h.tsc - lg.base_tsc)) / lg.ticks_per_ns);
+          format_line(out, h, wall);
+          ++n;
+        }
+        tail += h.len;
+      }
+      b.tail.store(tail, std::memory_order_release);
+      return n;
+    }
+
+    void run(Logger &lg) {
+      rt::apply_thread_policy(lg.cfg.thread, "aether-log");
+      std::vector<std::shared_ptr<ThreadBuffer>> active;
+      std::string out;
+      out.reserve(1 << 20);
+      bool last = false;
+      while (!last) {
+        last = !lg.running.load(std::memory_order_acquire); // one more pass after stop()
+        {
+          std::lock_guard<std::mutex> lk(lg.mu);
+          active = lg.buffers;
+        }
+        size_t n = 0;
+        for (auto &b : active) {
+          bool exited = b->exited.load(std::memory_order_acquire);
+          n += drain(lg, *b, out);
+          if (exited) {
+            std::lock_guard<std::mutex> lk(lg.mu);
+            for (size_t i = 0; i < lg.buffers.size(); ++i) {
+              if (lg.buffers[i] == b) {
+                lg.buffers.erase(lg.buffers.begin() + long(i));
+                break;
+              }
+            }
+          }
+        }
+        if (!out.empty()) {
+          write_all(lg.fd, out);
+          out.clear();
+        }
+        if (!n && !last) std::this_thread::sleep_for(std::chrono::microseconds(lg.cfg.poll_interval_us));
+      }
+    }
+
+    // text up to the next "{}" (or all of it, if the format has fewer placeholders)
+    void literal(std::string &out, const char *&fmt) {
+      const char *q = std::strstr(fmt, "{}");
+      if (!q) {
+        out += fmt;
+        fmt += std::strlen(fmt);
+        out += ' ';
+        return;
+      }
+      out.append(fmt, size_t(q - fmt));
+      fmt = q + 2;
+    }
+
+  } // namespace
+
+  bool start(const Config &cfg) {
+    Logger &lg = logger();
+    if (lg.running.load()) return true;
+    lg.cfg = cfg;
+    size_t cap = 4096;
+    while (cap < cfg.thread_buffer_bytes) cap <<= 1;
+    lg.cfg.thread_buffer_bytes = cap;
+    lg.fd = STDERR_FILENO;
+    if (!cfg.path.empty()) {
+      int fd = ::open(cfg.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+      if (fd < 0) {
+        std::cerr << "[log] cannot open " << cfg.path << ": " << strerror(errno) << "\n";
+        return false;
+      }
+      lg.fd = fd;
+    }
+    lg.ticks_per_ns = tsc_ticks_per_ns();
+    lg.base_wall_ns = wall_now_ns();
+    lg.base_tsc = tsc_now();
+    set_level(cfg.level);
+    lg.running.store(true, std::memory_order_release);
+    lg.thread = std::thread([&lg] { run(lg); });
+    return true;
+  }
+
+  void stop() {
+    Logger &lg = logger();
+    if (!lg.running.exchange(false)) return;
+    if (lg.thread.joinable()) lg.thread.join();
+    // a producer that saw running just before the exchange may commit after the
+    // thread's last pass: wait for it and drain what is left here
+    std::vector<std::shared_ptr<ThreadBuffer>> rest;
+    {
+      std::lock_guard<std::mutex> lk(lg.mu);
+      rest = lg.buffers;
+    }
+    std::string out;
+    for (auto &b : rest) {
+      while (b->busy.load(std::memory_order_acquire)) std::this_thread::yield();
+      drain(lg, *b, out);
+    }
+    write_all(lg.fd, out);
+    uint64_t d = lg.dropped.load(), s = lg.suppressed.load();
+    if (d || s) {
+      std::string line;
+      put_prefix(line, wall_now_ns(), Warn);
+      line += "[log] " + std::to_string(d) + " records dropped (buffer full), " + std::to_string(s)
+        + " suppressed by rate limits\n";
+      write_all(lg.fd, line);
+    }
+    if (lg.fd != STDERR_FILENO) ::close(lg.fd);
+    lg.fd = STDERR_FILENO;
+  }
+
+  bool parse_level(const std::string &s, Level &out) {
+    static const char *names[] = {"debug", "info", "warn", "error", "off"};
+    for (int i = 0; i <= Off; ++i) {
+      if (s == names[i]) {
+        out = Level(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint64_t dropped() { return logger().dropped.load(std::memory_order_relaxed); }
+  uint64_t suppressed() { return logger().suppressed.load(std::memory_order_relaxed); }
+
+  uint8_t *reserve(size_t args_bytes, Level level, FormatFn fn, const char *fmt) {
+    ThreadState &ts = t_state;
+    Logger &lg = logger();
+    size_t len = (sizeof(RecordHeader) + args_bytes + 7) & ~size_t(7);
+    RecordHeader h{uint32_t(len), uint32_t(level), fn, fmt, tsc_now()};
+
+    if (!ts.buf && lg.running.load(std::memory_order_acquire)) {
+      ts.buf = std::make_shared<ThreadBuffer>(lg.cfg.thread_buffer_bytes);
+      std::lock_guard<std::mutex> lk(lg.mu);
+      lg.buffers.push_back(ts.buf);
+    }
+    // busy before the running check (both seq_cst): stop() either sees busy and waits
+    // for the commit, or this thread sees running == false and writes inline
+    if (ts.buf) ts.buf->busy.store(true, std::memory_order_seq_cst);
+    if (!lg.running.load(std::memory_order_seq_cst)) {
+      if (ts.buf) ts.buf->busy.store(false, std::memory_order_release);
+      ts.inline_mode = true;
+      ts.scratch.resize(len);
+      std::memcpy(ts.scratch.data(), &h, sizeof(h));
+      return ts.scratch.data() + sizeof(h);
+    }
+    ts.inline_mode = false;
+
+    ThreadBuffer &b = *ts.buf;
+    uint64_t cap = b.buf.size();
+    if (len > cap / 2) {
+      lg.dropped.fetch_add(1, std::memory_order_relaxed);
+      b.busy.store(false, std::memory_order_release);
+      return nullptr;
+    }
+    uint64_t head = b.head.load(std::memory_order_relaxed);
+    uint64_t room = cap - (head & b.mask);
+    uint64_t need = len <= room ? len : room + len;
+    if (head + need - b.tail_cache > cap) {
+      b.tail_cache = b.tail.load(std::memory_order_acquire);
+      if (head + need - b.tail_cache > cap) {
+        lg.dropped.fetch_add(1, std::memory_order_relaxed);
+        b.busy.store(false, std::memory_order_release);
+        return nullptr;
+      }
+    }
+    if (len > room) {
+      // records never wrap: pad out this lap (room >= 8, records are 8-aligned)
+      uint32_t pad[2] = {uint32_t(room), PAD_LEVEL};
+      std::memcpy(&b.buf[head & b.mask], pad, sizeof(pad));
+      head += room;
+    }
+    uint8_t *p = &b.buf[head & b.mask];
+    std::memcpy(p, &h, sizeof(h));
+    b.pending = head + len;
+    return p + sizeof(h);
+  }
+
+  void commit() {
+    ThreadState &ts = t_state;
+    if (!ts.inline_mode) {
+      ts.buf->head.store(ts.buf->pending, std::memory_order_release);
+      ts.buf->busy.store(false, std::memory_order_release);
+      return;
+    }
+    std::string line;
+    format_line(line, *reinterpret_cast<const RecordHeader*>(ts.scratch.data()), wall_now_ns());
+    write_all(STDERR_FILENO, line);
+  }
+
+  namespace detail {
+
+    void put_text(std::string &out, const char *&fmt, const uint8_t *&p) {
+      literal(out, fmt);
+      uint32_t n;
+      std::memcpy(&n, p, sizeof(n));
+      out.append(reinterpret_cast<const char*>(p + sizeof(n)), n);
+      p += sizeof(n) + n;
+    }
+
+    void put_signed(std::string &out, const char *&fmt, const uint8_t *&p) {
+      literal(out, fmt);
+      int64_t v;
+      std::memcpy(&v, p, 8);
+      p += 8;
+      char buf[24];
+      out.append(buf, size_t(std::to_chars(buf, buf + sizeof(buf), v).ptr - buf));
+    }
+
+    void put_unsigned(std::string &out, const char *&fmt, const uint8_t *&p) {
+      literal(out, fmt);
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+      p += 8;
+      char buf[24];
+      out.append(buf, size_t(std::to_chars(buf, buf + sizeof(buf), v).ptr - buf));
+    }
+
+    void put_bool(std::string &out, const char *&fmt, const uint8_t *&p) {
+      literal(out, fmt);
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+      p += 8;
+      out += v ? "true" : "false";
+    }
+
+    void put_double(std::string &out, const char *&fmt, const uint8_t *&p) {
+      literal(out, fmt);
+      double v;
+      std::memcpy(&v, p, 8);
+      p += 8;
+      char buf[32];
+      out.append(buf, size_t(std::to_chars(buf, buf + sizeof(buf), v).ptr - buf));
+    }
+
+    bool RateLimit::allow() {
+      int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+      if (window_.load(std::memory_order_relaxed) != now) {
+        window_.store(now, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+      }
+      if (count_.fetch_add(1, std::memory_order_relaxed) < per_sec_) return true;
+      logger().suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+  } // namespace detail
+
+}} // namespace aether::log
@@ -1,224 +1,299 @@
 // main.cpp
 #include "event_queue.h"
-#include "utils.h"
 #include "orderbook.h"
-#include "rest_client.h"
-#include "ws_client.h"
-#include "ring_mmap.h"
+#include "capture.h"
+#include "live_feed.h"
+#include "log.h"
+#include "net_loop.h"
+#include "runtime.h"
+#include "shard_engine.h"
+#include "stats_shm.h"
+#include "wal.h"
 
+#include <algorithm>
+#include <csignal>
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <atomic>
+#include <unordered_map>
 #include <vector>
-#include <nlohmann/json.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
 
-
-using json = nlohmann::json;
 using namespace aether;
-using aether::ring::RingHandle;
-using aether::ring::create_ring;
-using aether::ring::open_ring;
-using aether::ring::close_ring;
-using aether::ring::publish_message;
-using aether::ring::publish_snapshot_json;
-using aether::ring::ring_buf_size;
 
-int main(int argc, char** argv) {
-  if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " SYMBOL [100ms]\n";
-    return 1;
-  }
-  std::string symbol = argv[1];
-  std::string updateSpeed = (argc >= 3 ? argv[2] : "");
-  std::string ring_path = (argc >= 4 ? argv[3] : "/dev/shm/aether.byte.ring");
-  size_t ring_buf_size = 8 * 1024 * 1024; // 8MB (tune as required)
+// book level storage is chosen at build time (-DAETHER_USE_LADDER_BOOK=ON)
+#ifdef AETHER_USE_LADDER_BOOK
+using Book = LadderOrderBook;
+#else
+using Book = OrderBook;
+#endif
+using Engine = BasicShardEngine<Book>;
 
-  EventQueue queue;
-  std::atomic<bool> stopFlag{false};
+static bool starts_with(const std::string &s, const char *prefix) {
+  return s.rfind(prefix, 0) == 0;
+}
 
-  // Create or open ring using the C++ API
-  RingHandle *ring = nullptr;
-  ring = create_ring(ring_path.c_str(), ring_buf_size);
-  if (!ring) {
-    std::cerr << "[main] create_ring failed; trying open_ring...\n";
-    ring = open_ring(ring_path.c_str());
-    if (!ring) {
-      std::cerr << "[main] ring_create/open failed. continuing WITHOUT publishing to ring.\n";
-    } else {
-      std::cerr << "[main] opened existing ring: " << ring_path << " (buf_size=" << ring_buf_size << ")\n";
-    }
-  } else {
-    std::cerr << "[main] created ring at " << ring_path << " (buf_size=" << ring_buf_size << ")\n";
-  }
+static std::string upper(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+  return s;
+}
+
+static std::vector<std::string> split(const std::string &s, char sep) {
+  std::vector<std::string> out;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, sep))
+    if (!item.empty()) out.push_back(item);
+  return out;
+}
 
-  // start ws reader thread
-  std::thread ws_thread = start_ws_reader(symbol, updateSpeed, queue, stopFlag);
-
-  
-  // Wait for initial buffered events per Binance spec
-  uint64_t firstU = wait_for_initial_buffer(queue, /*min_events=*/5, /*timeout_ms=*/500);
-  std::cerr << "[main] noted first event U = " << firstU << "\n";
-
-  // setup io_context and ssl ctx for REST
-  boost::asio::io_context ioc;
-  boost::asio::ssl::context ctx{boost::asio::ssl::context::tlsv12_client};
-  ctx.set_verify_mode(boost::asio::ssl::verify_none); // production: enable verify
-
-  // binance needs the symbol target in uppercase for rest endpoints.
-  auto to_upper = [](std::string s) {
-    std::transform(s.begin(), s.end(), s.begin(), ::toupper);
-    return s;
-  };
-
-  // fetch snapshot until lastUpdateId >= firstU
-  json snapshot;
-  std::string host = "api.binance.com";
-  std::string port = "443";
-  std::string target = "/api/v3/depth?symbol=" + to_upper(symbol) + "&limit=5000";
-  while (true) {
-    try {
-      std::cerr << "[main] fetching snapshot...\n";
-      std::string body = https_get_sync(ioc, ctx, host, port, target);
-      snapshot = json::parse(body);
-      uint64_t lastUpdateId = snapshot.at("lastUpdateId").get<uint64_t>();
-      std::cerr << "[main] snapshot.lastUpdateId = " << lastUpdateId << "\n";
-      if (lastUpdateId >= firstU) break;
-      std::cerr << "[main] snapshot too old, retrying in 1s\n";
-      std::this_thread::sleep_for(std::chrono::seconds(1));
-    } catch (...) {
-      std::cerr << "[main] snapshot fetch error, retrying\n";
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+static int usage(const char *argv0) {
+  std::cerr << "Usage: " << argv0 << " SYMBOL[,SYMBOL...] [100ms] [ring_path]"
+    << " [--shards=N] [--shard-map=SYM:N,...]"
+    << " [--wal-dir=DIR] [--wal-sync=none|periodic|batch] [--wal-segment-mb=256]"
+    << " [--capture=FILE] [--verbose] [--ws-url=wss://host:port] [--rest-url=https://host:port]"
+    << " [--stats=/dev/shm/aether.stats|off] [--log-level=info] [--log-file=PATH]"
+    << " [--view-dir=/dev/shm|off] [--view-depth=20] [--checkpoint-ms=0] [--checkpoint-events=0]"
+    << " [--checkpoint-ring-pct=12]"
+    << " [--conflate=off|always|lag] [--conflate-ms=10] [--conflate-events=0] [--conflate-lag-pct=50]"
+    << " [--analytics-depth=0] [--cpu-net=N] [--cpu-book=LIST] [--cpu-wal=N] [--cpu-log=N]"
+    << " [--cpu-capture=N] [--rt-priority=N] [--mlock] [--prefault-mb=N] [--ring-pages=4k|thp|huge]"
+    << " [--queue-prewarm=LEVELS] [--book-reserve=LEVELS] [--snapshot-limit=5000]"
+    << " [--snapshot-weight=3000] [--snapshot-concurrency=4]\n";
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  // positional: SYMBOL[,SYMBOL...] [speed] [ring_path]
+  // options: --shards=N --shard-map=SYM:N,... --wal-dir=DIR --wal-sync=MODE
+  //          --wal-segment-mb=N --capture=FILE --verbose --ws-url=URL --rest-url=URL
+  //          --stats=PATH|off --log-level=debug|info|warn|error|off --log-file=PATH
+  //          --view-dir=DIR|off --view-depth=N --checkpoint-ms=N --checkpoint-events=N
+  //          --checkpoint-ring-pct=N
+  //          --conflate=off|always|lag --conflate-ms=N --conflate-events=N --conflate-lag-pct=N
+  //          --analytics-depth=N --cpu-net=N --cpu-book=LIST --cpu-wal=N --cpu-log=N
+  //          --cpu-capture=N --rt-priority=N --mlock --prefault-mb=N --ring-pages=4k|thp|huge
+  //          --queue-prewarm=LEVELS --book-reserve=LEVELS --snapshot-limit=N
+  //          --snapshot-weight=N --snapshot-concurrency=N
+  std::vector<std::string> pos;
+  std::string stats_path = "/dev/shm/aether.stats";
+  log::Config log_cfg;
+  bool log_level_set = false;
+  ShardConfig ecfg;
+  ecfg.view_dir = "/dev/shm";
+  CaptureConfig cap_cfg;
+  LiveFeedConfig feed_cfg;
+  rt::ThreadPolicy net_policy;
+  bool lock_mem = false;
+  std::unordered_map<std::string, int> shard_map;
+  // a malformed number (--shards=x) lands in the catch
+  std::string a;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      a = argv[i];
+      if (starts_with(a, "--wal-dir=")) ecfg.wal.dir = a.substr(10);
+      else if (starts_with(a, "--capture=")) cap_cfg.path = a.substr(10);
+      else if (starts_with(a, "--stats=")) stats_path = a.substr(8) == "off" ? "" : a.substr(8);
+      else if (starts_with(a, "--log-file=")) log_cfg.path = a.substr(11);
+      else if (starts_with(a, "--view-dir=")) ecfg.view_dir = a.substr(11) == "off" ? "" : a.substr(11);
+      else if (starts_with(a, "--view-depth=")) ecfg.view_depth = uint32_t(std::stoul(a.substr(13)));
+      else if (starts_with(a, "--checkpoint-ms=")) ecfg.checkpoint_ms = uint32_t(std::stoul(a.substr(16)));
+      else if (starts_with(a, "--checkpoint-events=")) ecfg.checkpoint_events = std::stoull(a.substr(20));
+      else if (starts_with(a, "--checkpoint-ring-pct=")) ecfg.checkpoint_ring_pct = uint32_t(std::stoul(a.substr(22)));
+      else if (starts_with(a, "--conflate=")) {
+        if (!parse_conflate_mode(a.substr(11), ecfg.conflate)) {
+          std::cerr << "[main] --conflate must be off, always or lag\n";
+          return 1;
+        }
+      }
+      else if (starts_with(a, "--conflate-ms=")) ecfg.conflate_ms = uint32_t(std::stoul(a.substr(14)));
+      else if (starts_with(a, "--conflate-events=")) ecfg.conflate_events = uint32_t(std::stoul(a.substr(18)));
+      else if (starts_with(a, "--conflate-lag-pct=")) ecfg.conflate_lag_pct = uint32_t(std::stoul(a.substr(19)));
+      else if (starts_with(a, "--analytics-depth=")) ecfg.analytics_depth = uint32_t(std::stoul(a.substr(18)));
+      else if (starts_with(a, "--cpu-net=")) net_policy.cpu = std::stoi(a.substr(10));
+      else if (starts_with(a, "--cpu-wal=")) ecfg.wal.thread.cpu = std::stoi(a.substr(10));
+      else if (starts_with(a, "--cpu-log=")) log_cfg.thread.cpu = std::stoi(a.substr(10));
+      else if (starts_with(a, "--cpu-capture=")) cap_cfg.thread.cpu = std::stoi(a.substr(14));
+      else if (starts_with(a, "--cpu-book=")) {
+        if (!rt::parse_cpu_list(a.substr(11), ecfg.book_cpus)) {
+          std::cerr << "[main] --cpu-book takes a CPU list such as 2,3 or 4-7\n";
+          return 1;
+        }
+      }
+      else if (starts_with(a, "--rt-priority=")) net_policy.rt_priority = ecfg.book_rt_priority = std::stoi(a.substr(14));
+      else if (a == "--mlock") lock_mem = true;
+      else if (starts_with(a, "--prefault-mb=")) ecfg.prefault_heap_bytes = std::stoull(a.substr(14)) << 20;
+      else if (starts_with(a, "--queue-prewarm=")) ecfg.queue_prewarm_levels = std::stoul(a.substr(16));
+      else if (starts_with(a, "--book-reserve=")) ecfg.book_reserve_levels = std::stoul(a.substr(15));
+      else if (starts_with(a, "--ring-pages=")) {
+        if (!ring::parse_ring_pages(a.substr(13).c_str(), ecfg.ring_pages)) {
+          std::cerr << "[main] --ring-pages must be 4k, thp or huge\n";
+          return 1;
+        }
+      }
+      else if (starts_with(a, "--log-level=")) {
+        if (!log::parse_level(a.substr(12), log_cfg.level)) {
+          std::cerr << "[main] --log-level must be debug, info, warn, error or off\n";
+          return 1;
+        }
+        log_level_set = true;
+      }
+      else if (starts_with(a, "--wal-sync=")) {
+        if (!wal::parse_durability(a.substr(11), ecfg.wal.durability)) {
+          std::cerr << "[main] --wal-sync must be none, periodic or batch\n";
+          return 1;
+        }
+      } else if (starts_with(a, "--wal-segment-mb=")) ecfg.wal.segment_bytes = std::stoull(a.substr(17)) << 20;
+      else if (starts_with(a, "--shards=")) ecfg.shards = std::stoul(a.substr(9));
+      else if (starts_with(a, "--shard-map=")) {
+        for (const std::string &e : split(a.substr(12), ',')) {
+          size_t colon = e.find(':');
+          if (colon == std::string::npos) {
+            std::cerr << "[main] --shard-map entries are SYMBOL:SHARD\n";
+            return 1;
+          }
+          shard_map[upper(e.substr(0, colon))] = std::stoi(e.substr(colon + 1));
+        }
+      } else if (starts_with(a, "--ws-url=") || starts_with(a, "--rest-url=")) {
+        bool ws = starts_with(a, "--ws-url=");
+        if (!parse_endpoint(a.substr(a.find('=') + 1), ws ? feed_cfg.ws : feed_cfg.rest)) {
+          std::cerr << "[main] bad endpoint URL: " << a << "\n";
+          return 1;
+        }
+      } else if (starts_with(a, "--snapshot-limit=")) feed_cfg.snapshot_limit = uint32_t(std::stoul(a.substr(17)));
+      else if (starts_with(a, "--snapshot-weight=")) feed_cfg.snapshots.weight_per_minute = uint32_t(std::stoul(a.substr(18)));
+      else if (starts_with(a, "--snapshot-concurrency=")) feed_cfg.snapshots.max_in_flight = std::stoul(a.substr(23));
+      else if (a == "--verbose") ecfg.verbose = true;
+      else pos.push_back(a);
     }
+  } catch (const std::exception &) {
+    std::cerr << "[main] bad value in " << a << "\n";
+    return usage(argv[0]);
   }
-
-  // Publish snapshot to ring (if ring available)
-  if (ring) {
-    std::string snap_str = snapshot.dump();
-    bool ok = publish_snapshot_json(ring, snap_str.c_str());
-    if (!ok) {
-      std::cerr << "[main] Warning: publish_snapshot_json failed. Will continue but consumer may not get snapshot.\n";
-    } else {
-      std::cerr << "[main] Published snapshot to ring (" << snap_str.size() << " bytes)\n";
+  if (pos.empty()) return usage(argv[0]);
+  // one pipeline per symbol: a repeated symbol (in any case) would never see an event
+  std::vector<std::string> symbols;
+  for (const std::string &s : split(pos[0], ',')) {
+    if (std::any_of(symbols.begin(), symbols.end(), [&](const std::string &t) { return upper(t) == upper(s); })) {
+      std::cerr << "[main] duplicate symbol " << s << " ignored\n";
+      continue;
     }
+    symbols.push_back(s);
   }
+  feed_cfg.symbols = symbols;
+  feed_cfg.update_speed = (pos.size() >= 2 ? pos[1] : "");
+  ecfg.ring_path = (pos.size() >= 3 ? pos[2] : "/dev/shm/aether.byte.ring");
+  ecfg.ring_bytes = 8 * 1024 * 1024; // 8MB per shard (tune as required)
+  if (symbols.size() == 1) ecfg.verbose = true; // single-symbol runs keep the per-event log
 
-  // drain buffered events and keep those after lastUpdateId
-  std::vector<JsonEvent> buffered = queue.drain_all();
-  std::cerr << "[main] buffered events count = " << buffered.size() << "\n";
-  uint64_t lastUpdateId = snapshot.at("lastUpdateId").get<uint64_t>();
-  size_t idx = 0;
-  while (idx < buffered.size()) {
-    uint64_t u = buffered[idx].j.at("u").get<uint64_t>();
-    if (u <= lastUpdateId) ++idx;
-    else break;
-  }
-  std::vector<JsonEvent> to_apply;
-  for (size_t i = idx; i < buffered.size(); ++i) to_apply.push_back(std::move(buffered[i]));
-  std::cerr << "[main] to_apply size after discard = " << to_apply.size() << "\n";
-
-  if (!to_apply.empty()) {
-    uint64_t firstBufU = to_apply.front().j.at("U").get<uint64_t>();
-    uint64_t firstBufu = to_apply.front().j.at("u").get<uint64_t>();
-    if (!(firstBufU <= lastUpdateId + 1 && lastUpdateId + 1 <= firstBufu)) {
-      std::cerr << "[main] buffered event range does not cover snapshot+1. Exiting.\n";
-      stopFlag.store(true);
-      if (ws_thread.joinable()) ws_thread.join();
-      if (ring) close_ring(ring);
-      return 2;
-    }
-  } else {
-    std::cerr << "[main] no buffered events after discarding old ones. Proceeding with snapshot only.\n";
+  // per-event records are debug level: formatted and written off the hot threads
+  if (!log_level_set) log_cfg.level = ecfg.verbose ? log::Debug : log::Info;
+  if (!log::start(log_cfg)) return 1;
+  // before any ring, book or queue is allocated, so all of them are locked as they map
+  if (lock_mem) {
+    rt::retain_heap();
+    rt::lock_memory();
   }
 
-  // build local book from snapshot
-  OrderBook book;
-  book.setFromSnapshot(snapshot);
-  std::cerr << "[main] built local book lastUpdateId=" << book.lastUpdateId() << " levels=" << book.totalLevels() << "\n";
-  book.printTop(5);
-
-  // helper: publish JSON payload with small retry
-  auto publish_json_to_ring = [&](RingHandle *r, uint8_t msg_type, const std::string &s) -> bool {
-    if (!r) return false;
-    const void *data = s.data();
-    size_t len = s.size();
-    const int MAX_TRIES = 3;
-    for (int t=0;t<MAX_TRIES;++t) {
-      bool ok = publish_message(r, msg_type, data, len);
-      if (ok) return true;
-      // simple backoff
-      std::this_thread::sleep_for(std::chrono::milliseconds(10 * (t+1)));
-    }
-    return false;
-  };
-
-  // apply buffered events sequentially
-  size_t applied = 0;
-  for (auto &ev : to_apply) {
-    bool ok = book.applyEvent(ev.j);
-    if (!ok) {
-      std::cerr << "[main] gap detected while applying buffered events. Need to resync. Exiting.\n";
-      stopFlag.store(true);
-      if (ws_thread.joinable()) ws_thread.join();
-      if (ring) close_ring(ring);
-      return 3;
-    }
+  std::atomic<bool> stopFlag{false};
+  std::atomic<bool> signalled{false};
 
-    // publish buffered event to ring as DEPTH_UPDATE (type=1)
-    if (ring) {
-      std::string evs = ev.j.dump();
-      if (!publish_json_to_ring(ring, 1, evs)) {
-        std::cerr << "[main] Warning: failed to publish buffered event to ring after retries\n";
-      }
-    }
+  // every WS stream and REST request runs on this one loop; SIGINT/SIGTERM cancel it,
+  // which closes the stream and lets the shards drain and exit
+  NetLoop loop;
+  boost::asio::signal_set signals(loop.context(), SIGINT, SIGTERM);
+  signals.async_wait([&](const boost::system::error_code &ec, int sig) {
+      if (ec) return;
+      AETHER_LOG_INFO("[main] signal {}, shutting down", sig);
+      signalled.store(true);
+      stopFlag.store(true);
+      loop.cancel();
+  });
+  loop.start(net_policy);
+  LiveFeed feed(loop, feed_cfg);
 
-    ++applied;
+  // counters and stage latencies for aether_stat: one block for the reader, one per shard
+  stats::StatsSegment stats_seg;
+  if (!stats_path.empty() && stats_seg.create(stats_path, ecfg.shards + 1)) {
+    ecfg.stats = &stats_seg;
+    feed.set_stats(stats_seg.add_block("feed"));
   }
-  std::cerr << "[main] applied " << applied << " buffered events. book_update_id now = " << book.lastUpdateId() << "\n";
-  book.printTop(5);
-
-  // live processing
-  std::cerr << "[main] entering live processing loop. Ctrl+C to exit.\n";
-  size_t liveCounter = 0;
-  while (true) {
-    JsonEvent ev = queue.pop_blocking();
-    uint64_t U = ev.j.at("U").get<uint64_t>();
-    uint64_t u = ev.j.at("u").get<uint64_t>();
-    std::cerr << "[ws] incoming U=" << U << " u=" << u << " book=" << book.lastUpdateId() << "\n";
-    if (u < book.lastUpdateId()) continue;
-    if (U > book.lastUpdateId() + 1) {
-      std::cerr << "[main] SEQ GAP DETECTED. Need resync. Exiting.\n";
-      stopFlag.store(true);
-      break;
-    }
-    bool ok = book.applyEvent(ev.j);
-    if (!ok) {
-      std::cerr << "[main] applyEvent returned false (gap). Exiting.\n";
-      stopFlag.store(true);
-      break;
-    }
 
-    // publish live depthUpdate to ring (type=1)
-    if (ring) {
-      std::string evs = ev.j.dump();
-      if (!publish_json_to_ring(ring, 1, evs)) {
-        std::cerr << "[main] Warning: failed to publish live event to ring after retries\n";
-      }
-    }
+  // optional raw capture of everything the feed receives (replayable with aether_replay)
+  CaptureWriter capture(cap_cfg);
+  if (!cap_cfg.path.empty()) {
+    CaptureChannel *ws_ch = capture.add_channel();
+    CaptureChannel *rest_ch = capture.add_channel();
+    if (capture.start()) feed.set_capture(ws_ch, rest_ch);
+  }
 
-    book.printTop(5);
-    ++liveCounter;
-    if (liveCounter % 10000 == 0) {
-      std::cerr << "[main] applied " << liveCounter << " live events. book_update_id=" << book.lastUpdateId() << " levels=" << book.totalLevels() << "\n";
-    }
-    if (liveCounter % 1000 == 0) book.printTop(5);
+  // price/qty scales must be known before the reader starts decoding
+  std::unordered_map<std::string, DecimalScale> scales;
+  scales_from_exchange_info(feed.exchange_info(), scales);
+  std::vector<SymbolSpec> specs;
+  for (const std::string &s : symbols) {
+    SymbolSpec spec;
+    spec.symbol = upper(s);
+    auto it = scales.find(spec.symbol);
+    if (it != scales.end()) spec.scale = it->second;
+    else AETHER_LOG_WARN("[main] {} not in exchangeInfo, using default scale", spec.symbol);
+    auto m = shard_map.find(spec.symbol);
+    if (m != shard_map.end()) spec.shard = m->second;
+    AETHER_LOG_INFO("[main] {} scale price_decimals={} qty_decimals={}", spec.symbol,
+        spec.scale.price_decimals, spec.scale.qty_decimals);
+    specs.push_back(spec);
   }
 
-  stopFlag.store(true);
-  if (ws_thread.joinable()) ws_thread.join();
-  if (ring) {
-    close_ring(ring);
-    std::cerr << "[main] closed ring\n";
+  // one book thread, queue, ring and WAL per shard (plus a book view per symbol); every
+  // symbol bootstraps from its own snapshot while the combined stream is buffered
+  Engine engine(ecfg, specs);
+  // with no symbol left to book, close the stream so the process exits (with an error)
+  engine.start(feed, stopFlag, [&] {
+      AETHER_LOG_ERROR("[main] every symbol stopped, shutting down");
+      stopFlag.store(true);
+      loop.cancel();
+  });
+  feed.start_combined(engine.router(), stopFlag);
+
+  AETHER_LOG_INFO("[main] {} symbols on {} shards. Ctrl+C to exit.", specs.size(), engine.shardCount());
+  // the reader queues end_of_stream when the stream ends, so the shards drain and return
+  feed.join();
+  engine.join();
+  RestClientStats rs = feed.rest_stats();
+  SnapshotSchedulerStats ss = feed.snapshot_stats();
+  boost::asio::post(loop.context(), [&] { signals.cancel(); });
+  loop.stop();
+  capture.stop();
+
+  PipelineStats ps = engine.totals();
+  AETHER_LOG_INFO("[main] applied={} resyncs={} resync_retries={}", ps.applied, ps.resyncs, ps.resync_retries);
+  if (ps.checkpoints)
+    AETHER_LOG_INFO("[main] checkpoints={} checkpoint_p50_ns={} checkpoint_max_ns={}", ps.checkpoints,
+        ps.checkpoint_ns.percentile(50), ps.checkpoint_ns.max());
+  if (ps.conflated_frames)
+    AETHER_LOG_INFO("[main] conflated_frames={} conflated_deltas={}", ps.conflated_frames, ps.conflated_deltas);
+  if (mem::counting)
+    AETHER_LOG_INFO("[main] book allocs={} in {} live events (last at event {})", ps.allocs, ps.alloc_events,
+        ps.last_alloc_event);
+  if (ps.resyncs)
+    AETHER_LOG_INFO("[main] resync_p50_us={} resync_max_us={}", ps.resync_us.percentile(50), ps.resync_us.max());
+  AETHER_LOG_INFO("[main] rest requests={} connects={} reused={} tls_resumed={} dns_lookups={}",
+      rs.requests, rs.connects, rs.reused, rs.tls_resumed, rs.dns_lookups);
+  AETHER_LOG_INFO("[main] snapshots requests={} weight={} rate_limited={} banned={} waited_ms={}",
+      ss.requests, ss.weight, ss.rate_limited, ss.banned, ss.waited_ms);
+  // exit status: 0 after a signal, 2 if a symbol stopped (no usable snapshot, or a gap
+  // it could not recover from), 3 if the stream ended on its own
+  int rc = 0;
+  if (ps.stopped) {
+    AETHER_LOG_ERROR("[main] {} of {} symbols stopped", ps.stopped, specs.size());
+    rc = 2;
+  } else if (!signalled.load()) {
+    AETHER_LOG_ERROR("[main] stream ended without a signal");
+    rc = 3;
   }
-  std::cerr << "[main] exiting.\n";
-  return 0;
+  AETHER_LOG_INFO("[main] exiting.");
+  log::stop();
+  return rc;
 }
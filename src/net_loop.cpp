@@ -0,0 +1,78 @@
+// net_loop.cpp
+#include "net_loop.h"
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/system/system_error.hpp>
+#include <iostream>
+
+namespace aether {
+
+  bool parse_endpoint(const std::string &url, Endpoint &out) {
+    size_t sep = url.find("://");
+    if (sep == std::string::npos) return false;
+    std::string scheme = url.substr(0, sep);
+    Endpoint ep;
+    if (scheme == "wss" || scheme == "https") { ep.tls = true; ep.port = "443"; }
+    else if (scheme == "ws" || scheme == "http") { ep.tls = false; ep.port = "80"; }
+    else return false;
+    std::string rest = url.substr(sep + 3);
+    size_t slash = rest.find('/');
+    if (slash != std::string::npos) rest.resize(slash);
+    size_t colon = rest.rfind(':');
+    if (colon != std::string::npos) {
+      ep.port = rest.substr(colon + 1);
+      rest.resize(colon);
+    }
+    if (rest.empty() || ep.port.empty()) return false;
+    ep.host = rest;
+    out = ep;
+    return true;
+  }
+
+  NetLoop::NetLoop()
+    : work_(boost::asio::make_work_guard(ioc_)), tls_(boost::asio::ssl::context::tlsv12_client) {
+    tls_.set_verify_mode(boost::asio::ssl::verify_none); // production: enable verify
+  }
+
+  NetLoop::~NetLoop() { stop(); }
+
+  void NetLoop::start(const rt::ThreadPolicy &policy) {
+    if (thread_.joinable()) return;
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread([this, policy] {
+        rt::apply_thread_policy(policy, "aether-net");
+        try {
+          ioc_.run();
+        } catch (const std::exception &ex) {
+          std::cerr << "[net] loop exception: " << ex.what() << "\n";
+        }
+        running_.store(false, std::memory_order_release);
+    });
+  }
+
+  void NetLoop::cancel() {
+    if (cancelled_.exchange(true, std::memory_order_acq_rel)) return;
+    boost::asio::post(ioc_, [this] {
+        auto open = std::move(open_);
+        open_.clear();
+        for (auto &kv : open) kv.second();
+    });
+  }
+
+  void NetLoop::stop() {
+    cancel();
+    work_.reset();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  NetLoop::CancelScope::CancelScope(NetLoop &loop, std::function<void()> close)
+    : loop_(loop), id_(loop.next_id_++) {
+    // a connection opened after cancel() does not start at all
+    if (loop_.cancelled()) throw boost::system::system_error(boost::asio::error::operation_aborted);
+    loop_.open_.emplace(id_, std::move(close));
+  }
+
+  NetLoop::CancelScope::~CancelScope() { loop_.open_.erase(id_); }
+
+} // namespace aether
@@ -1,94 +1,196 @@
 // orderbook.cpp
 #include "orderbook.h"
-#include <cmath>
 #include <iostream>
+#include <stdexcept>
 
 namespace aether {
 
-  static constexpr int64_t PRICE_SCALE = 100000000LL; // or set per-symbol
+  template <class Levels>
+  BasicOrderBook<Levels>::BasicOrderBook(const DecimalScale &scale, const SideConfig &side_cfg)
+    : bids_(side_cfg), asks_(side_cfg), last_update_id_(0), scale_(scale) {}
 
-  OrderBook::OrderBook() : bids_(), asks_(), last_update_id_(0) {}
-  OrderBook::~OrderBook() = default;
+  template <class Levels>
+  BasicOrderBook<Levels>::~BasicOrderBook() = default;
 
-  auto OrderBook::parsePriceScaled(const std::string &ps) -> PriceT {
-    double d = std::stod(ps);
-    return static_cast<PriceT>(llround(d * PRICE_SCALE));
+  template <class Levels>
+  PriceT BasicOrderBook<Levels>::parsePriceScaled(std::string_view ps) const {
+    PriceT p;
+    if (!parse_price(ps, scale_, p))
+      throw std::invalid_argument("bad price: " + std::string(ps));
+    return p;
   }
-  auto OrderBook::parseSizeScaled(const std::string &qs) -> SizeT {
-    double d = std::stod(qs);
-    return static_cast<SizeT>(llround(d * PRICE_SCALE));
+  template <class Levels>
+  SizeT BasicOrderBook<Levels>::parseSizeScaled(std::string_view qs) const {
+    SizeT q;
+    if (!parse_qty(qs, scale_, q))
+      throw std::invalid_argument("bad size: " + std::string(qs));
+    return q;
   }
 
-  void OrderBook::setFromSnapshot(const nlohmann::json &snapshot) {
+  template <class Levels>
+  void BasicOrderBook<Levels>::setFromSnapshot(const nlohmann::json &snapshot) {
     bids_.clear();
     asks_.clear();
     const auto lastId = snapshot.at("lastUpdateId").get<uint64_t>();
     last_update_id_ = lastId;
 
     for (const auto &b : snapshot.at("bids")) {
-      PriceT p = parsePriceScaled(b.at(0).get<std::string>());
-      SizeT  q = parseSizeScaled(b.at(1).get<std::string>());
-      if (q > 0) bids_[p] = q;
+      PriceT p = parsePriceScaled(b.at(0).get_ref<const std::string&>());
+      SizeT  q = parseSizeScaled(b.at(1).get_ref<const std::string&>());
+      if (q > 0) bids_.set(p, q);
     }
     for (const auto &a : snapshot.at("asks")) {
-      PriceT p = parsePriceScaled(a.at(0).get<std::string>());
-      SizeT  q = parseSizeScaled(a.at(1).get<std::string>());
-      if (q > 0) asks_[p] = q;
+      PriceT p = parsePriceScaled(a.at(0).get_ref<const std::string&>());
+      SizeT  q = parseSizeScaled(a.at(1).get_ref<const std::string&>());
+      if (q > 0) asks_.set(p, q);
     }
+    resetSum(bids_, bid_sum_);
+    resetSum(asks_, ask_sum_);
   }
 
-  bool OrderBook::applyEvent(const nlohmann::json &event) {
-    uint64_t U = event.at("U").get<uint64_t>();
-    uint64_t u = event.at("u").get<uint64_t>();
-    if (u < last_update_id_) return true;            // old, ignore
-    if (U > last_update_id_ + 1) return false;       // gap -> resync needed
+  template <class Levels>
+  void BasicOrderBook<Levels>::setAnalyticsDepth(size_t n) {
+    depth_n_ = n;
+    resetSum(bids_, bid_sum_);
+    resetSum(asks_, ask_sum_);
+  }
 
-    if (event.contains("b")) {
-      for (const auto &lvl : event.at("b")) {
-        PriceT p = parsePriceScaled(lvl.at(0).get<std::string>());
-        SizeT  q = parseSizeScaled(lvl.at(1).get<std::string>());
-        if (q == 0) bids_.erase(p);
-        else bids_[p] = q;
-      }
+  template <class Levels>
+  void BasicOrderBook<Levels>::reserveLevels(size_t n) {
+    bids_.reserve(n);
+    asks_.reserve(n);
+  }
+
+  // full walk of the best depth_n_ levels (snapshot, depth change)
+  template <class Levels>
+  template <class Side>
+  void BasicOrderBook<Levels>::resetSum(const Side &side, DepthSum &s) const {
+    s = DepthSum{};
+    if (depth_n_ == 0) return;
+    side.visit([&](PriceT p, SizeT q) {
+      s.qty += q;
+      s.notional += __int128(p) * q;
+      s.edge = p;
+      return ++s.levels < depth_n_;
+    });
+  }
+
+  // Move one side's sum from a level change old_q -> q at p (the side already holds q).
+  // The sum covers the best depth_n_ levels, down to and including s.edge.
+  template <class Levels>
+  template <class Side>
+  void BasicOrderBook<Levels>::trackLevel(const Side &side, DepthSum &s, PriceT p, SizeT old_q, SizeT q) const {
+    if (old_q == q) return;
+    auto better = [](PriceT a, PriceT b) { return Side::is_bid ? a > b : a < b; };
+    auto add = [&s](PriceT price, SizeT dq) {
+      s.qty += dq;
+      s.notional += __int128(price) * dq;
+    };
+    bool inside = s.levels < depth_n_ || !better(s.edge, p);
+    if (old_q != 0 && q != 0) {
+      if (inside) add(p, q - old_q);
+      return;
     }
-    if (event.contains("a")) {
-      for (const auto &lvl : event.at("a")) {
-        PriceT p = parsePriceScaled(lvl.at(0).get<std::string>());
-        SizeT  q = parseSizeScaled(lvl.at(1).get<std::string>());
-        if (q == 0) asks_.erase(p);
-        else asks_[p] = q;
+    SizeT nq;
+    if (q != 0) {
+      // new level: joins a short sum, or pushes the current edge level out
+      if (s.levels < depth_n_) {
+        add(p, q);
+        if (s.levels++ == 0 || better(s.edge, p)) s.edge = p;
+      } else if (better(p, s.edge)) {
+        add(p, q);
+        add(s.edge, -side.qty_at(s.edge));
+        side.next_better(s.edge, s.edge, nq);
       }
+      return;
+    }
+    // removed level: the next level past the edge (if any) moves into the sum
+    if (!inside) return;
+    add(p, -old_q);
+    PriceT np;
+    if (s.levels == depth_n_ && side.next_worse(s.edge, np, nq)) {
+      add(np, nq);
+      s.edge = np;
+      return;
+    }
+    if (--s.levels > 0 && p == s.edge) side.next_better(p, s.edge, nq);
+  }
+
+  template <class Levels>
+  BookAnalytics BasicOrderBook<Levels>::analytics() const {
+    BookAnalytics a;
+    a.has_bid = bids_.best(a.bid.price, a.bid.qty);
+    a.has_ask = asks_.best(a.ask.price, a.ask.qty);
+    if (a.has_bid && a.has_ask) {
+      a.spread = a.ask.price - a.bid.price;
+      a.mid = (double(a.bid.price) + double(a.ask.price)) / 2;
+      double w = double(a.bid.qty) + double(a.ask.qty);
+      a.microprice = w > 0 ? (double(a.bid.price) * double(a.ask.qty) + double(a.ask.price) * double(a.bid.qty)) / w
+                           : a.mid;
+    }
+    a.depth = uint32_t(depth_n_);
+    a.bid_levels = uint32_t(bid_sum_.levels);
+    a.ask_levels = uint32_t(ask_sum_.levels);
+    a.bid_qty = bid_sum_.qty;
+    a.ask_qty = ask_sum_.qty;
+    a.bid_notional = double(bid_sum_.notional);
+    a.ask_notional = double(ask_sum_.notional);
+    double total = double(a.bid_qty) + double(a.ask_qty);
+    if (total > 0) a.imbalance = (double(a.bid_qty) - double(a.ask_qty)) / total;
+    return a;
+  }
+
+  template <class Levels>
+  bool BasicOrderBook<Levels>::applyEvent(const DepthDelta &delta) {
+    uint64_t U = delta.first_update_id;
+    uint64_t u = delta.final_update_id;
+    if (u < last_update_id_) return true;            // old, ignore
+    if (U > last_update_id_ + 1) return false;       // gap -> resync needed
+
+    if (depth_n_ == 0) {
+      for (const Level &lvl : delta.bids) bids_.set(lvl.price, lvl.qty);
+      for (const Level &lvl : delta.asks) asks_.set(lvl.price, lvl.qty);
+    } else {
+      for (const Level &lvl : delta.bids)
+        trackLevel(bids_, bid_sum_, lvl.price, bids_.set(lvl.price, lvl.qty), lvl.qty);
+      for (const Level &lvl : delta.asks)
+        trackLevel(asks_, ask_sum_, lvl.price, asks_.set(lvl.price, lvl.qty), lvl.qty);
     }
     last_update_id_ = u;
     return true;
   }
 
-  uint64_t OrderBook::lastUpdateId() const noexcept { return last_update_id_; }
-  size_t OrderBook::totalLevels() const noexcept { return bids_.size() + asks_.size(); }
+  template <class Levels>
+  uint64_t BasicOrderBook<Levels>::lastUpdateId() const noexcept { return last_update_id_; }
+  template <class Levels>
+  size_t BasicOrderBook<Levels>::totalLevels() const noexcept { return bids_.size() + asks_.size(); }
 
-  bool OrderBook::bestBid(PriceT &price_out, SizeT &size_out) const {
-    if (bids_.empty()) return false;
-    auto it = bids_.begin();
-    price_out = it->first; size_out = it->second; return true;
+  template <class Levels>
+  bool BasicOrderBook<Levels>::bestBid(PriceT &price_out, SizeT &size_out) const {
+    return bids_.best(price_out, size_out);
   }
-  bool OrderBook::bestAsk(PriceT &price_out, SizeT &size_out) const {
-    if (asks_.empty()) return false;
-    auto it = asks_.begin();
-    price_out = it->first; size_out = it->second; return true;
+  template <class Levels>
+  bool BasicOrderBook<Levels>::bestAsk(PriceT &price_out, SizeT &size_out) const {
+    return asks_.best(price_out, size_out);
   }
 
-  void OrderBook::printTop(int n) const {
+  template <class Levels>
+  void BasicOrderBook<Levels>::printTop(int n) const {
+    auto print = [&](PriceT p, SizeT q) {
+      if (n-- <= 0) return false;
+      std::cout << "  " << ticks_to_double(p, scale_.price_decimals) << " : " << ticks_to_double(q, scale_.qty_decimals) << "\n";
+      return true;
+    };
+    int top = n;
     std::cout << "OrderBook last_update_id=" << last_update_id_ << "\n";
     std::cout << " Asks (lowest):\n";
-    int i=0;
-    for (auto it = asks_.begin(); it != asks_.end() && i<n; ++it, ++i) {
-      std::cout << "  " << double(it->first)/PRICE_SCALE << " : " << double(it->second)/PRICE_SCALE << "\n";
-    }
+    asks_.visit(print);
+    n = top;
     std::cout << " Bids (highest):\n";
-    i=0;
-    for (auto it = bids_.begin(); it != bids_.end() && i<n; ++it, ++i) {
-      std::cout << "  " << double(it->first)/PRICE_SCALE << " : " << double(it->second)/PRICE_SCALE << "\n";
-    }
+    bids_.visit(print);
   }
 
+  template class BasicOrderBook<MapLevels>;
+  template class BasicOrderBook<LadderLevels>;
+
 } // namespace aether
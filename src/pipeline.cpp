@@ -0,0 +1,630 @@
+// pipeline.cpp
+#include "pipeline.h"
+#include "log.h"
+#include "tsc_clock.h"
+#include "utils.h"
+
+#include <chrono>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+namespace aether {
+
+  using json = nlohmann::json;
+
+  static uint64_t mono_now_ns() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  // b - a for stamps that may come from different cores (never wraps below zero)
+  static uint64_t ticks_between(uint64_t a, uint64_t b) { return b > a ? b - a : 0; }
+
+  template <class Book>
+  BasicPipeline<Book>::BasicPipeline(const PipelineConfig &cfg, const DecimalScale &scale)
+    : cfg_(cfg), book_(scale) {
+    // binary frames carry the symbol id and scale so consumers need no side channel
+    meta_.symbol_id = aether_symbol_id(cfg_.symbol.c_str());
+    meta_.scale = scale;
+    frame_buf_.reserve(64 * 1024);
+    conflating_ = cfg_.conflate == ConflateMode::Always && cfg_.ring;
+    book_.setAnalyticsDepth(cfg_.analytics_depth);
+    if (cfg_.book_reserve_levels) book_.reserveLevels(cfg_.book_reserve_levels);
+    if (cfg_.prewarm_levels) {
+      resync_buf_.resize(cfg_.resync_prewarm_events);
+      for (DepthEvent &e : resync_buf_) {
+        e.delta.bids.reserve(cfg_.prewarm_levels);
+        e.delta.asks.reserve(cfg_.prewarm_levels);
+      }
+    }
+  }
+
+  template <class Book>
+  BasicPipeline<Book>::~BasicPipeline() { cancel_fetch(); }
+
+  template <class Book>
+  BootstrapStatus BasicPipeline<Book>::bootstrap(FeedSource &feed, EventQueue &queue) {
+    // Wait for initial buffered events per Binance spec
+    uint64_t firstU = wait_for_initial_buffer(queue, /*min_events=*/5, /*timeout_ms=*/500);
+    AETHER_LOG_INFO("[pipeline] noted first event U = {}", firstU);
+
+    // fetch snapshot until lastUpdateId >= firstU
+    json snapshot;
+    while (true) {
+      try {
+        AETHER_LOG_INFO("[pipeline] fetching snapshot...");
+        std::string body;
+        if (!feed.fetch_snapshot(cfg_.symbol, body)) {
+          AETHER_LOG_WARN("[pipeline] feed has no snapshot covering the stream");
+          return BootstrapStatus::EndOfStream;
+        }
+        snapshot = json::parse(body);
+        uint64_t lastUpdateId = snapshot.at("lastUpdateId").get<uint64_t>();
+        AETHER_LOG_INFO("[pipeline] snapshot.lastUpdateId = {}", lastUpdateId);
+        if (lastUpdateId >= firstU) break;
+        AETHER_LOG_WARN("[pipeline] snapshot too old, retrying");
+      } catch (...) {
+        AETHER_LOG_WARN("[pipeline] snapshot fetch error, retrying");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(feed.retry_delay_ms()));
+    }
+
+    // consume the buffered events in place (the slots keep their level storage) and
+    // keep those after lastUpdateId
+    size_t buffered = 0;
+    bool ended = false;
+    BootstrapStatus st = rebuild(snapshot, [&](auto &&f) {
+        queue.try_pop_n([&](DepthEvent &e) {
+            ++buffered;
+            if (e.end_of_stream) {
+              ended = true;
+              return false;
+            }
+            return f(e);
+        }, queue.capacity());
+    });
+    AETHER_LOG_INFO("[pipeline] buffered events count = {}", buffered);
+    if (st != BootstrapStatus::Ok) return st;
+    if (cfg_.verbose) log_top(5);
+    return ended ? BootstrapStatus::EndOfStream : BootstrapStatus::Ok;
+  }
+
+  template <class Book>
+  template <class ForEach>
+  BootstrapStatus BasicPipeline<Book>::rebuild(const json &snapshot, ForEach &&for_each) {
+    uint64_t lastUpdateId = snapshot.at("lastUpdateId").get<uint64_t>();
+    BootstrapStatus st = BootstrapStatus::Ok;
+    bool built = false;
+    size_t discarded = 0, applied = 0;
+    auto build = [&] {
+      AETHER_LOG_INFO("[pipeline] discarded {} buffered events covered by the snapshot", discarded);
+      // build local book from snapshot
+      book_.setFromSnapshot(snapshot);
+      synced_ = true;
+      built = true;
+      publish_view();
+      AETHER_LOG_INFO("[pipeline] built local book lastUpdateId={} levels={}", book_.lastUpdateId(), book_.totalLevels());
+      if (cfg_.verbose) log_top(5);
+
+      if (!publish_snapshot()) {
+        ++stats_.publish_failures;
+        if (cfg_.stats) cfg_.stats->add(stats::Drops);
+        AETHER_LOG_WARN("[pipeline] Warning: snapshot publish failed. Will continue but consumer may not get snapshot.");
+      }
+    };
+
+    // every event is consumed, also after a failure, so none is left over for a retry
+    for_each([&](DepthEvent &ev) {
+      if (st != BootstrapStatus::Ok) return true;
+      if (!built) {
+        if (ev.delta.final_update_id <= lastUpdateId) {
+          ++discarded;
+          return true;
+        }
+        if (!(ev.delta.first_update_id <= lastUpdateId + 1 && lastUpdateId + 1 <= ev.delta.final_update_id)) {
+          AETHER_LOG_WARN("[pipeline] buffered event range does not cover snapshot+1.");
+          st = BootstrapStatus::NoCoverage;
+          return true;
+        }
+        build();
+      }
+      // apply buffered events sequentially
+      if (!apply(ev)) {
+        AETHER_LOG_WARN("[pipeline] gap detected while applying buffered events.");
+        synced_ = false;
+        publish_view();
+        st = BootstrapStatus::Gap;
+        return true;
+      }
+      ++applied;
+      return true;
+    });
+    if (st == BootstrapStatus::NoCoverage) return st;
+    if (st == BootstrapStatus::Gap) {
+      end_batch();
+      return st;
+    }
+    if (!built) {
+      AETHER_LOG_INFO("[pipeline] no buffered events after discarding old ones. Proceeding with snapshot only.");
+      build();
+    }
+    end_batch();
+    AETHER_LOG_INFO("[pipeline] applied {} buffered events. book_update_id now = {}", applied, book_.lastUpdateId());
+    return BootstrapStatus::Ok;
+  }
+
+  template <class Book>
+  RunStatus BasicPipeline<Book>::run(FeedSource &feed, EventQueue &queue, const std::atomic<bool> &stop) {
+    status_ = RunStatus::Stopped;
+    bool running = true;
+    auto on_ev = [&](DepthEvent &ev) { return running = on_event(feed, ev); };
+
+    while (running && !stop.load(std::memory_order_relaxed)) {
+      if (!resyncing_) {
+        // drain bursts in batches; slots go back to the reader in one release. An open
+        // conflation window must close on time, so it polls instead of blocking.
+        size_t n = holding() ? queue.try_pop_n(on_ev, 256) : queue.pop_n_blocking(on_ev, 256);
+        size_t depth = queue.size();
+        end_batch(depth);
+        if (cfg_.stats) {
+          cfg_.stats->set(stats::QueueDepth, depth);
+          cfg_.stats->set_max(stats::QueueDepthMax, depth);
+          if (cfg_.ring) cfg_.stats->set(stats::Overwrites, ring::ring_evicted(cfg_.ring));
+        }
+        if (n == 0 && holding()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        continue;
+      }
+      // keep the reader flowing while the snapshot is fetched in the background
+      size_t n = queue.try_pop_n(on_ev, 256);
+      if (!running) break;
+      if (!poll(feed)) break;
+      if (resyncing_ && n == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    drain();
+    cancel_fetch();
+    return status_;
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::start_sync(SnapshotSource &snaps) {
+    resyncing_ = true;
+    initial_sync_ = true;
+    resync_n_ = 0;
+    resync_start_us_ = mono_now_ns() / 1000;
+    start_fetch(snaps, 0);
+  }
+
+  template <class Book>
+  bool BasicPipeline<Book>::on_event(SnapshotSource &snaps, DepthEvent &ev) {
+    if (resyncing_) return buffer_event(ev);
+    if (on_live_event(ev)) return true;
+    if (status_ == RunStatus::Gap && cfg_.resync) {
+      begin_resync(snaps, ev.delta.first_update_id);
+      status_ = RunStatus::Stopped;
+      return buffer_event(ev);
+    }
+    return false;
+  }
+
+  template <class Book>
+  bool BasicPipeline<Book>::on_live_event(DepthEvent &ev) {
+    if (ev.end_of_stream) {
+      AETHER_LOG_INFO("[pipeline] feed ended.");
+      status_ = RunStatus::EndOfStream;
+      return false;
+    }
+    uint64_t U = ev.delta.first_update_id;
+    uint64_t u = ev.delta.final_update_id;
+    if (cfg_.verbose) AETHER_LOG_DEBUG("[ws] incoming U={} u={} book={}", U, u, book_.lastUpdateId());
+    if (u < book_.lastUpdateId()) {
+      ++stats_.stale;
+      if (cfg_.stats) cfg_.stats->add(stats::Stale);
+      return true;
+    }
+    if (U > book_.lastUpdateId() + 1) {
+      AETHER_LOG_WARN("[pipeline] SEQ GAP DETECTED (U={} book={}).", U, book_.lastUpdateId());
+      if (cfg_.stats) cfg_.stats->add(stats::Gaps);
+      status_ = RunStatus::Gap;
+      return false;
+    }
+    if (cfg_.measure) stats_.queue_us.record(mono_now_ns() / 1000 - ev.local_recv_ts_us);
+    if (!apply(ev, true)) {
+      AETHER_LOG_WARN("[pipeline] applyEvent returned false (gap).");
+      if (cfg_.stats) cfg_.stats->add(stats::Gaps);
+      status_ = RunStatus::Gap;
+      return false;
+    }
+
+    ++live_;
+    if (cfg_.verbose) {
+      if (log::enabled(log::Debug)) {
+        PriceT bp = 0, ap = 0;
+        SizeT bq = 0, aq = 0;
+        book_.bestBid(bp, bq);
+        book_.bestAsk(ap, aq);
+        const DecimalScale &sc = book_.scale();
+        AETHER_LOG_DEBUG("[book] {} bid {} : {} ask {} : {}", cfg_.symbol,
+            ticks_to_double(bp, sc.price_decimals), ticks_to_double(bq, sc.qty_decimals),
+            ticks_to_double(ap, sc.price_decimals), ticks_to_double(aq, sc.qty_decimals));
+      }
+      if (live_ % 10000 == 0) {
+        AETHER_LOG_INFO("[pipeline] applied {} live events. book_update_id={} levels={}", live_, book_.lastUpdateId(), book_.totalLevels());
+      }
+    }
+    return true;
+  }
+
+  // hold an event while resyncing; swapped in so both sides keep their buffers
+  template <class Book>
+  bool BasicPipeline<Book>::buffer_event(DepthEvent &ev) {
+    if (ev.end_of_stream) {
+      AETHER_LOG_INFO("[pipeline] feed ended during resync.");
+      status_ = RunStatus::EndOfStream;
+      return false;
+    }
+    // a snapshot taken later covers every delta up to its own: while the request waits
+    // for its turn only the newest one is worth holding
+    if (fetch_ && fetch_->state.load(std::memory_order_relaxed) == SnapshotRequest::Queued) resync_n_ = 0;
+    if (resync_n_ >= cfg_.resync_max_buffered) {
+      // snapshot is taking too long: keep only the newest deltas, the next snapshot
+      // must then cover those
+      AETHER_LOG_WARN("[pipeline] resync buffer full, dropping {} buffered deltas", resync_n_);
+      if (cfg_.stats) cfg_.stats->add(stats::Drops, resync_n_);
+      resync_n_ = 0;
+    }
+    if (resync_n_ == resync_buf_.size()) {
+      // past the pre-reserved entries: give the new one level storage too, or the slot
+      // it is swapped with would go back to the reader empty
+      resync_buf_.emplace_back();
+      resync_buf_.back().delta.bids.reserve(cfg_.prewarm_levels);
+      resync_buf_.back().delta.asks.reserve(cfg_.prewarm_levels);
+    }
+    std::swap(resync_buf_[resync_n_++], ev);
+    return true;
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::begin_resync(SnapshotSource &snaps, uint64_t gap_U) {
+    AETHER_LOG_WARN("[pipeline] {} resync: book={} gap at U={}", cfg_.symbol, book_.lastUpdateId(), gap_U);
+    resyncing_ = true;
+    resync_start_us_ = mono_now_ns() / 1000;
+    synced_ = false;
+    publish_view();
+    publish_resync(gap_U);
+    end_batch();
+    start_fetch(snaps, 0);
+  }
+
+  template <class Book>
+  bool BasicPipeline<Book>::poll(SnapshotSource &snaps) {
+    if (!resyncing_) return true;
+    int st = fetch_ ? fetch_->state.load(std::memory_order_acquire) : int(SnapshotRequest::Failed);
+    if (st == SnapshotRequest::Failed) {
+      AETHER_LOG_WARN("[pipeline] {} resync: feed has no snapshot to offer", cfg_.symbol);
+      status_ = RunStatus::Gap;
+      return false;
+    }
+    // the snapshot is only judged against buffered deltas, so hold it until one arrives
+    if (st != SnapshotRequest::Ready || resync_n_ == 0) return true;
+    json snapshot = std::move(fetch_->snapshot);
+    fetch_.reset();
+
+    uint64_t lastUpdateId = snapshot.at("lastUpdateId").get<uint64_t>();
+    uint64_t firstU = resync_n_ ? resync_buf_[0].delta.first_update_id : 0;
+    if (lastUpdateId < firstU) {
+      AETHER_LOG_WARN("[pipeline] {} resync: snapshot {} older than buffered U={}, retrying", cfg_.symbol, lastUpdateId, firstU);
+      ++stats_.resync_retries;
+      start_fetch(snaps, snaps.retry_delay_ms());
+      return true;
+    }
+    BootstrapStatus bs = rebuild(snapshot, [this](auto &&f) {
+        for (size_t i = 0; i < resync_n_; ++i) f(resync_buf_[i]);
+    });
+    if (bs != BootstrapStatus::Ok) {
+      // the buffered deltas themselves are broken: start over from fresh ones
+      ++stats_.resync_retries;
+      resync_n_ = 0;
+      if (!initial_sync_) publish_resync(book_.lastUpdateId() + 1);
+      end_batch();
+      start_fetch(snaps, snaps.retry_delay_ms());
+      return true;
+    }
+    resync_n_ = 0;
+    resyncing_ = false;
+    uint64_t took = mono_now_ns() / 1000 - resync_start_us_;
+    if (initial_sync_) {
+      initial_sync_ = false;
+      AETHER_LOG_INFO("[pipeline] {} synced in {}us, book={}", cfg_.symbol, took, book_.lastUpdateId());
+      return true;
+    }
+    ++stats_.resyncs;
+    stats_.resync_us.record(took);
+    if (cfg_.stats) cfg_.stats->add(stats::Resyncs);
+    AETHER_LOG_INFO("[pipeline] {} resync done in {}us, book={} (resyncs={})", cfg_.symbol, took, book_.lastUpdateId(), stats_.resyncs);
+    return true;
+  }
+
+  // hand the fetch to the source; it retries transient errors itself
+  template <class Book>
+  void BasicPipeline<Book>::start_fetch(SnapshotSource &snaps, int delay_ms) {
+    cancel_fetch();
+    fetch_ = std::make_shared<SnapshotRequest>();
+    fetch_->symbol = cfg_.symbol;
+    snaps.request_snapshot(fetch_, delay_ms);
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::cancel_fetch() {
+    if (!fetch_) return;
+    fetch_->cancelled.store(true, std::memory_order_relaxed);
+    fetch_.reset();
+  }
+
+  // apply one event to the book and publish it; live events also get their stage
+  // latencies recorded in the stats segment (buffered ones waited on purpose)
+  template <class Book>
+  bool BasicPipeline<Book>::apply(const DepthEvent &ev, bool live) {
+    uint64_t a0 = mem::thread_allocs();
+    stats::StatsBlock *sb = live && ev.recv_tsc ? cfg_.stats : nullptr;
+    uint64_t c0 = sb ? tsc_now() : 0;
+    uint64_t t0 = cfg_.measure ? mono_now_ns() : 0;
+    if (!book_.applyEvent(ev.delta)) return false;
+    ++stats_.applied;
+    if (cfg_.stats) cfg_.stats->add(stats::Events);
+    uint64_t c1 = sb ? tsc_now() : 0;
+    if (!cfg_.ring && !cfg_.wal) {
+      if (cfg_.measure) stats_.apply_ns.record(mono_now_ns() - t0);
+    } else {
+      uint64_t t1 = cfg_.measure ? mono_now_ns() : 0;
+      if (publish_delta(ev)) ++stats_.published;
+      else {
+        ++stats_.publish_failures;
+        if (cfg_.stats) cfg_.stats->add(stats::Drops);
+      }
+      if (cfg_.measure) {
+        stats_.apply_ns.record(t1 - t0);
+        stats_.publish_ns.record(mono_now_ns() - t1);
+      }
+    }
+    if (cfg_.view) {
+      view_event_ms_ = ev.delta.event_time_ms;
+      publish_view();
+    }
+    if (sb) {
+      uint64_t c2 = tsc_now();
+      sb->record(stats::StageDecode, ticks_between(ev.recv_tsc, ev.decoded_tsc));
+      sb->record(stats::StageQueue, ticks_between(ev.decoded_tsc, c0));
+      sb->record(stats::StageApply, c1 - c0);
+      if (cfg_.ring || cfg_.wal || cfg_.view) sb->record(stats::StagePublish, c2 - c1);
+      sb->record(stats::StageTotal, ticks_between(ev.recv_tsc, c2));
+    }
+    if (mem::counting && live) note_allocs(a0, true);
+    return true;
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::note_allocs(uint64_t before, bool event) {
+    uint64_t n = mem::thread_allocs() - before;
+    if (!n) return;
+    stats_.allocs += n;
+    if (event) ++stats_.alloc_events;
+    stats_.last_alloc_event = stats_.applied;
+    if (cfg_.stats) cfg_.stats->add(stats::Allocs, n);
+  }
+
+  // encode a depth update in place inside the ring as DEPTH_UPDATE; it becomes
+  // visible to readers at the next flush() (one head store per batch). The WAL copies
+  // the same encoded bytes.
+  template <class Book>
+  bool BasicPipeline<Book>::publish_delta(const DepthEvent &ev) {
+    size_t cap = depth_frame_size(ev.delta) + trailer_size();
+    uint64_t u = ev.delta.final_update_id;
+    if (!cfg_.ring || (conflating_ && cfg_.wal)) {
+      frame_buf_.resize(cap);
+      size_t n = encode_depth_frame(frame_buf_.data(), cap, meta_, ev.delta, ev.local_recv_ts_us);
+      n = add_trailer(frame_buf_.data(), cap, n, book_.analytics());
+      if (!cfg_.ring) return n && cfg_.wal->append(AETHER_MSG_DEPTH_UPDATE, meta_.symbol_id, u, frame_buf_.data(), n);
+      if (n) cfg_.wal->append(AETHER_MSG_DEPTH_UPDATE, meta_.symbol_id, u, frame_buf_.data(), n);
+    }
+    if (conflating_) {
+      conflator_.add(ev.delta, ev.local_recv_ts_us, conflator_.empty() ? mono_now_ns() : 0);
+      if (cfg_.analytics_depth) window_analytics_ = book_.analytics();
+      return true;
+    }
+    void *p = ring::reserve(cfg_.ring, cap);
+    if (!p) return false;
+    size_t n = encode_depth_frame(p, cap, meta_, ev.delta, ev.local_recv_ts_us);
+    n = add_trailer(p, cap, n, book_.analytics());
+    if (!n) { ring::abort(cfg_.ring); return false; }
+    if (cfg_.wal) cfg_.wal->append(AETHER_MSG_DEPTH_UPDATE, meta_.symbol_id, u, p, n);
+    return ring::commit_deferred(cfg_.ring, AETHER_MSG_DEPTH_UPDATE, n);
+  }
+
+  template <class Book>
+  size_t BasicPipeline<Book>::add_trailer(void *buf, size_t cap, size_t n, const BookAnalytics &a) {
+    if (!cfg_.analytics_depth || !n) return n;
+    return append_analytics(buf, cap, n, a);
+  }
+
+  // SNAPSHOT frame encoded from the book itself. One attempt: the shard thread serves
+  // other symbols too, so a failure is counted by the caller rather than waited out
+  template <class Book>
+  bool BasicPipeline<Book>::publish_snapshot() {
+    if (!cfg_.ring && !cfg_.wal) return true;
+    flush_conflated();
+    uint64_t now_ns = mono_now_ns();
+    checkpoint_at_ns_ = now_ns;
+    checkpoint_at_events_ = stats_.applied;
+    size_t n = encode_book_snapshot(frame_buf_, meta_, book_, now_ns / 1000);
+    if (cfg_.analytics_depth) {
+      frame_buf_.resize(n + trailer_size());
+      add_trailer(frame_buf_.data(), frame_buf_.size(), n, book_.analytics());
+    }
+    if (cfg_.wal) {
+      cfg_.wal->append(AETHER_MSG_SNAPSHOT, meta_.symbol_id, book_.lastUpdateId(), frame_buf_.data(), frame_buf_.size());
+      cfg_.wal->end_batch();
+    }
+    if (!cfg_.ring) return true;
+    if (!ring::publish_message(cfg_.ring, AETHER_MSG_SNAPSHOT, frame_buf_.data(), frame_buf_.size())) return false;
+    AETHER_LOG_INFO("[pipeline] Published snapshot to ring ({} bytes)", frame_buf_.size());
+    return true;
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::publish_resync(uint64_t gap_U) {
+    if (!cfg_.ring && !cfg_.wal) return;
+    flush_conflated();
+    uint8_t buf[sizeof(aether_frame_header)];
+    size_t n = encode_resync_frame(buf, sizeof(buf), meta_, book_.lastUpdateId(), gap_U, mono_now_ns() / 1000);
+    if (cfg_.wal) cfg_.wal->append(AETHER_MSG_RESYNC, meta_.symbol_id, book_.lastUpdateId(), buf, n);
+    if (cfg_.ring && !ring::publish_message(cfg_.ring, AETHER_MSG_RESYNC, buf, n))
+      AETHER_LOG_WARN("[pipeline] Warning: resync marker publish failed");
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::publish_view() {
+    if (cfg_.view) cfg_.view->update(book_, view_event_ms_, synced_ ? view::VIEW_SYNCED : 0);
+  }
+
+  // top levels of both sides as debug records (the formatting happens on the log thread)
+  template <class Book>
+  void BasicPipeline<Book>::log_top(int levels) {
+    if (!log::enabled(log::Debug)) return;
+    const DecimalScale &sc = book_.scale();
+    int n = levels;
+    auto level = [&](const char *side, PriceT p, SizeT q) {
+      AETHER_LOG_DEBUG("[book] {} {} {} : {}", cfg_.symbol, side, ticks_to_double(p, sc.price_decimals),
+          ticks_to_double(q, sc.qty_decimals));
+      return --n > 0;
+    };
+    AETHER_LOG_DEBUG("[book] {} last_update_id={}", cfg_.symbol, book_.lastUpdateId());
+    book_.forEachAsk([&](PriceT p, SizeT q) { return level("ask", p, q); });
+    n = levels;
+    book_.forEachBid([&](PriceT p, SizeT q) { return level("bid", p, q); });
+  }
+
+  // A checkpoint is due once enough time or events have passed since the last
+  // snapshot; nothing is published for a book that has not changed. While events are
+  // queued it is held back (encoding a deep book takes tens of us), up to twice the
+  // interval, so bursts are not delayed by it.
+  template <class Book>
+  void BasicPipeline<Book>::maybe_checkpoint(size_t backlog) {
+    if (!synced_ || resyncing_ || (!cfg_.ring && !cfg_.wal)) return;
+    uint64_t events = stats_.applied - checkpoint_at_events_;
+    if (!events) return;
+    uint64_t limit = backlog ? 2 : 1;
+    uint64_t elapsed = mono_now_ns() - checkpoint_at_ns_;
+    if (cfg_.checkpoint_bytes_per_s &&
+        elapsed < book_snapshot_size(book_) * 1000000000 / cfg_.checkpoint_bytes_per_s) return;
+    bool due = cfg_.checkpoint_events && events >= limit * cfg_.checkpoint_events;
+    if (!due && cfg_.checkpoint_ms) due = elapsed >= limit * cfg_.checkpoint_ms * 1000000;
+    if (!due) return;
+    flush_conflated();
+    uint64_t t0 = mono_now_ns();
+    if (!publish_checkpoint()) {
+      ++stats_.publish_failures;
+      if (cfg_.stats) cfg_.stats->add(stats::Drops);
+    } else {
+      ++stats_.checkpoints;
+      if (cfg_.stats) cfg_.stats->add(stats::Checkpoints);
+    }
+    uint64_t t1 = mono_now_ns();
+    stats_.checkpoint_ns.record(t1 - t0);
+    checkpoint_at_ns_ = t1;
+    checkpoint_at_events_ = stats_.applied;
+  }
+
+  // the book encoded in place in a ring reservation (deferred like the deltas, so the
+  // batch's flush publishes both); the WAL copies the same bytes
+  template <class Book>
+  bool BasicPipeline<Book>::publish_checkpoint() {
+    size_t cap = book_snapshot_size(book_) + trailer_size();
+    uint64_t u = book_.lastUpdateId();
+    uint64_t now_us = mono_now_ns() / 1000;
+    if (!cfg_.ring) {
+      frame_buf_.resize(cap);
+      size_t n = encode_book_snapshot(frame_buf_.data(), cap, meta_, book_, now_us, AETHER_FRAME_FLAG_CHECKPOINT);
+      n = add_trailer(frame_buf_.data(), cap, n, book_.analytics());
+      return n && cfg_.wal->append(AETHER_MSG_SNAPSHOT, meta_.symbol_id, u, frame_buf_.data(), n);
+    }
+    void *p = ring::reserve(cfg_.ring, cap);
+    if (!p) return false;
+    size_t n = encode_book_snapshot(p, cap, meta_, book_, now_us, AETHER_FRAME_FLAG_CHECKPOINT);
+    n = add_trailer(p, cap, n, book_.analytics());
+    if (!n) { ring::abort(cfg_.ring); return false; }
+    if (cfg_.wal) cfg_.wal->append(AETHER_MSG_SNAPSHOT, meta_.symbol_id, u, p, n);
+    return ring::commit_deferred(cfg_.ring, AETHER_MSG_SNAPSHOT, n);
+  }
+
+  // OnLag: follow the slowest reader's lag (polled at most once per ms), with hysteresis
+  template <class Book>
+  void BasicPipeline<Book>::update_conflation() {
+    if (cfg_.conflate != ConflateMode::OnLag || !cfg_.ring) return;
+    uint64_t now = mono_now_ns();
+    if (now - lag_checked_ns_ < 1000000) return;
+    lag_checked_ns_ = now;
+    uint64_t pct = ring::ring_max_reader_lag(cfg_.ring) * 100 / ring::ring_buf_size(cfg_.ring);
+    if (!conflating_ && pct >= cfg_.conflate_lag_pct) {
+      conflating_ = true;
+      AETHER_LOG_INFO("[pipeline] {} reader lag {}% of ring, conflating deltas", cfg_.symbol, pct);
+    } else if (conflating_ && pct < cfg_.conflate_lag_pct / 2) {
+      conflating_ = false;
+      AETHER_LOG_INFO("[pipeline] {} reader lag {}% of ring, conflation off", cfg_.symbol, pct);
+    }
+  }
+
+  // publish the open window as one DEPTH_UPDATE (flagged CONFLATED when it merged
+  // several deltas), deferred like any delta
+  template <class Book>
+  void BasicPipeline<Book>::flush_conflated() {
+    if (conflator_.empty()) return;
+    size_t deltas = conflator_.deltas();
+    const DepthDelta &m = conflator_.merge();
+    size_t cap = depth_frame_size(m) + trailer_size();
+    void *p = ring::reserve(cfg_.ring, cap);
+    size_t n = p ? encode_depth_frame(p, cap, meta_, m, conflator_.last_recv_us(),
+        deltas > 1 ? AETHER_FRAME_FLAG_CONFLATED : 0) : 0;
+    n = add_trailer(p, cap, n, window_analytics_);
+    if (n && ring::commit_deferred(cfg_.ring, AETHER_MSG_DEPTH_UPDATE, n)) {
+      if (deltas > 1) {
+        ++stats_.conflated_frames;
+        stats_.conflated_deltas += deltas;
+        if (cfg_.stats) cfg_.stats->add(stats::Conflated, deltas);
+      }
+    } else {
+      if (p) ring::abort(cfg_.ring);
+      ++stats_.publish_failures;
+      if (cfg_.stats) cfg_.stats->add(stats::Drops, deltas);
+    }
+    conflator_.clear();
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::drain() {
+    if (conflator_.empty()) return;
+    flush_conflated();
+    if (cfg_.ring) ring::flush(cfg_.ring);
+  }
+
+  template <class Book>
+  void BasicPipeline<Book>::end_batch(size_t backlog) {
+    uint64_t a0 = mem::thread_allocs();
+    if (cfg_.conflate != ConflateMode::Off) {
+      update_conflation();
+      if (!conflator_.empty()) {
+        bool due = !conflating_ || conflator_.levels() >= 65536
+          || (cfg_.conflate_events && conflator_.deltas() >= cfg_.conflate_events)
+          || mono_now_ns() - conflator_.started_ns() >= uint64_t(cfg_.conflate_ms) * 1000000;
+        if (due) flush_conflated();
+      }
+    }
+    if (cfg_.checkpoint_ms || cfg_.checkpoint_events) maybe_checkpoint(backlog);
+    if (cfg_.ring) ring::flush(cfg_.ring);
+    if (cfg_.wal) cfg_.wal->end_batch();
+    if (mem::counting && synced_) note_allocs(a0, false);
+  }
+
+  template class BasicPipeline<OrderBook>;
+  template class BasicPipeline<LadderOrderBook>;
+
+} // namespace aether
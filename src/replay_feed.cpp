@@ -0,0 +1,133 @@
+// replay_feed.cpp
+#include "replay_feed.h"
+#include "alloc_count.h"
+#include "capture.h"
+#include "tsc_clock.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace aether {
+
+  static uint64_t mono_now_ns() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+  bool load_feed_text(const std::string &path, std::vector<FeedRecord> &out) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.empty()) continue;
+      FeedRecord r;
+      if (line[0] == '{') {
+        r.body = std::move(line);
+      } else {
+        // "<kind> <recv_us> <body>"
+        size_t sp = line.find(' ', 2);
+        if (line.size() < 4 || line[1] != ' ' || sp == std::string::npos) continue;
+        char k = line[0];
+        if (k != FeedRecord::WsFrame && k != FeedRecord::Snapshot && k != FeedRecord::ExchangeInfo) continue;
+        r.kind = uint8_t(k);
+        r.recv_us = std::strtoull(line.c_str() + 2, nullptr, 10);
+        r.body = line.substr(sp + 1);
+      }
+      out.push_back(std::move(r));
+    }
+    return true;
+  }
+
+  bool load_feed(const std::string &path, std::vector<FeedRecord> &out) {
+    return is_capture_file(path) ? read_capture(path, out) : load_feed_text(path, out);
+  }
+
+  ReplayFeed::ReplayFeed(std::vector<FeedRecord> records, ReplayPace pace, double speed)
+    : records_(std::move(records)), pace_(pace), speed_(speed > 0 ? speed : 1.0) {}
+
+  ReplayFeed::~ReplayFeed() { join(); }
+
+  std::string ReplayFeed::exchange_info() {
+    for (const auto &r : records_)
+      if (r.kind == FeedRecord::ExchangeInfo) return r.body;
+    return std::string();
+  }
+
+  bool ReplayFeed::fetch_snapshot(const std::string &, std::string &body) {
+    for (; next_snapshot_ < records_.size(); ++next_snapshot_) {
+      if (records_[next_snapshot_].kind == FeedRecord::Snapshot) {
+        body = records_[next_snapshot_++].body;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void ReplayFeed::start(const DecimalScale &scale, EventQueue &queue, std::atomic<bool> &stop) {
+    thread_ = std::thread([this, scale, &queue, &stop] { run(scale, queue, stop); });
+  }
+
+  void ReplayFeed::join() {
+    if (thread_.joinable()) thread_.join();
+  }
+
+  void ReplayFeed::run(DecimalScale scale, EventQueue &queue, std::atomic<bool> &stop) {
+    uint64_t first_ts_us = 0;
+    uint64_t start_ns = 0;
+    bool paced = pace_ == ReplayPace::Recorded;
+
+    for (const auto &r : records_) {
+      if (stop.load(std::memory_order_relaxed)) break;
+      if (r.kind != FeedRecord::WsFrame) continue;
+
+      DepthEvent *ev = queue.try_claim();
+      while (!ev && !stop.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+        ev = queue.try_claim();
+      }
+      if (!ev) break;
+
+      uint64_t t0 = mono_now_ns();
+      uint64_t c0 = tsc_now();
+      uint64_t a0 = mem::thread_allocs();
+      DecodeStatus st = decode_depth_update(r.body.data(), r.body.size(), ev->delta, scale);
+      uint64_t decode_ticks = tsc_now() - c0;
+      if (mem::counting && mem::thread_allocs() != a0) {
+        decode_allocs_ += mem::thread_allocs() - a0;
+        last_decode_alloc_ = frames_ + 1;
+      }
+      decode_ns_.record(mono_now_ns() - t0);
+      if (st != DecodeStatus::Ok) {
+        if (st == DecodeStatus::Malformed) ++malformed_;
+        continue; // slot stays claimed and is reused for the next frame
+      }
+
+      if (paced) {
+        // frames without a receive stamp are paced by exchange event time
+        uint64_t ts_us = r.recv_us ? r.recv_us : ev->delta.event_time_ms * 1000;
+        if (!start_ns) {
+          start_ns = mono_now_ns();
+          first_ts_us = ts_us;
+        }
+        uint64_t rel_us = ts_us > first_ts_us ? ts_us - first_ts_us : 0;
+        uint64_t due_ns = start_ns + uint64_t(double(rel_us) * 1000.0 / speed_);
+        for (uint64_t now = mono_now_ns(); now < due_ns && !stop.load(std::memory_order_relaxed); now = mono_now_ns()) {
+          if (due_ns - now > 200000) std::this_thread::sleep_for(std::chrono::nanoseconds(due_ns - now - 100000));
+          else cpu_relax();
+        }
+      }
+
+      ev->local_recv_ts_us = mono_now_ns() / 1000;
+      // stage stamps as if the frame had arrived now (pacing waits are not decode time)
+      ev->decoded_tsc = tsc_now();
+      ev->recv_tsc = ev->decoded_tsc - decode_ticks;
+      ev->end_of_stream = false;
+      queue.publish();
+      ++frames_;
+    }
+    push_end_of_stream(queue, stop);
+  }
+
+} // namespace aether
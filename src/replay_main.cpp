@@ -0,0 +1,207 @@
+// replay_main.cpp
+// aether_replay: drive a recorded feed through the same bootstrap / applyEvent /
+// ring-publish pipeline as the live binary and report throughput and per-stage
+// latency. The offline yardstick for performance changes.
+#include "log.h"
+#include "pipeline.h"
+#include "replay_feed.h"
+#include "ring_mmap.h"
+#include "stats_shm.h"
+#include "wal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace aether;
+
+static uint64_t mono_now_ns() {
+  using namespace std::chrono;
+  return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool starts_with(const std::string &s, const char *prefix) {
+  return s.rfind(prefix, 0) == 0;
+}
+
+static void print_stage(const char *name, const LatencyHistogram &h, const char *unit) {
+  if (!h.count()) return;
+  std::printf("  %-10s n=%-10llu mean=%-9.1f p50=%-8llu p99=%-8llu p99.9=%-8llu max=%llu %s\n",
+      name, (unsigned long long)h.count(), h.mean(),
+      (unsigned long long)h.percentile(50), (unsigned long long)h.percentile(99),
+      (unsigned long long)h.percentile(99.9), (unsigned long long)h.max(), unit);
+}
+
+// preallocation knobs (the allocs line of AETHER_COUNT_ALLOCS builds shows what is left)
+struct Prealloc {
+  size_t prewarm_levels = 0;   // EventQueue::prewarm, PipelineConfig::prewarm_levels
+  size_t book_reserve = 0;     // PipelineConfig::book_reserve_levels
+};
+
+template <class Book>
+static int replay(ReplayFeed &feed, const PipelineConfig &pcfg, const DecimalScale &scale, const char *book_name,
+    const Prealloc &pa) {
+  EventQueue queue;
+  if (pa.prewarm_levels) queue.prewarm(pa.prewarm_levels);
+  std::atomic<bool> stop{false};
+  BasicPipeline<Book> pipeline(pcfg, scale);
+
+  uint64_t t0 = mono_now_ns();
+  feed.start(scale, queue, stop);
+  BootstrapStatus bs = pipeline.bootstrap(feed, queue);
+  RunStatus rs = RunStatus::EndOfStream;
+  if (bs == BootstrapStatus::Ok) rs = pipeline.run(feed, queue, stop);
+  uint64_t elapsed = mono_now_ns() - t0;
+  stop.store(true);
+  feed.join();
+
+  const PipelineStats &st = pipeline.stats();
+  double secs = double(elapsed) / 1e9;
+  std::printf("replay: book=%s frames=%llu malformed=%llu applied=%llu stale=%llu published=%llu publish_failures=%llu\n",
+      book_name, (unsigned long long)feed.frames(), (unsigned long long)feed.malformed(),
+      (unsigned long long)st.applied, (unsigned long long)st.stale,
+      (unsigned long long)st.published, (unsigned long long)st.publish_failures);
+  std::printf("  elapsed=%.3fs throughput=%.0f events/s final_update_id=%llu levels=%zu\n",
+      secs, secs > 0 ? double(st.applied) / secs : 0.0,
+      (unsigned long long)pipeline.book().lastUpdateId(), pipeline.book().totalLevels());
+  std::printf("  resyncs=%llu resync_retries=%llu checkpoints=%llu conflated_frames=%llu conflated_deltas=%llu\n",
+      (unsigned long long)st.resyncs, (unsigned long long)st.resync_retries, (unsigned long long)st.checkpoints,
+      (unsigned long long)st.conflated_frames, (unsigned long long)st.conflated_deltas);
+  print_stage("decode", feed.decode_ns(), "ns");
+  print_stage("queue", st.queue_us, "us");
+  print_stage("apply", st.apply_ns, "ns");
+  print_stage("publish", st.publish_ns, "ns");
+  print_stage("resync", st.resync_us, "us");
+  print_stage("checkpoint", st.checkpoint_ns, "ns");
+  if (mem::counting)
+    std::printf("  allocs: decode=%llu (last at frame %llu) book=%llu in %llu events (last at event %llu)\n",
+        (unsigned long long)feed.decode_allocs(), (unsigned long long)feed.last_decode_alloc(),
+        (unsigned long long)st.allocs, (unsigned long long)st.alloc_events,
+        (unsigned long long)st.last_alloc_event);
+
+  if (bs != BootstrapStatus::Ok && bs != BootstrapStatus::EndOfStream) {
+    std::fprintf(stderr, "[replay] bootstrap failed\n");
+    return 2;
+  }
+  if (rs == RunStatus::Gap) {
+    std::fprintf(stderr, "[replay] sequence gap in recording\n");
+    return 3;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  std::string path;
+  std::string symbol = "BTCUSDT";
+  std::string ring_path = "/dev/shm/aether.replay.ring";
+  std::string book = "map";
+  ReplayPace pace = ReplayPace::Fast;
+  double speed = 1.0;
+  bool verbose = false;
+  wal::WalConfig wal_cfg;
+  std::string stats_path;
+  std::string view_path;
+  uint32_t checkpoint_ms = 0;
+  uint64_t checkpoint_events = 0;
+  ConflateMode conflate = ConflateMode::Off;
+  uint32_t conflate_ms = 10;
+  uint32_t conflate_events = 0;
+  uint32_t conflate_lag_pct = 50;
+  uint32_t analytics_depth = 0;
+  Prealloc prealloc;
+  log::Config log_cfg;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--pace=fast") pace = ReplayPace::Fast;
+    else if (a == "--pace=recorded") pace = ReplayPace::Recorded;
+    else if (starts_with(a, "--speed=")) speed = std::stod(a.substr(8));
+    else if (starts_with(a, "--symbol=")) symbol = a.substr(9);
+    else if (starts_with(a, "--ring=")) ring_path = a.substr(7);
+    else if (starts_with(a, "--book=")) book = a.substr(7);
+    else if (starts_with(a, "--wal-dir=")) wal_cfg.dir = a.substr(10);
+    else if (starts_with(a, "--stats=")) stats_path = a.substr(8);
+    else if (starts_with(a, "--view=")) view_path = a.substr(7);
+    else if (starts_with(a, "--checkpoint-ms=")) checkpoint_ms = uint32_t(std::stoul(a.substr(16)));
+    else if (starts_with(a, "--checkpoint-events=")) checkpoint_events = std::stoull(a.substr(20));
+    else if (starts_with(a, "--conflate=") && parse_conflate_mode(a.substr(11), conflate)) {}
+    else if (starts_with(a, "--conflate-ms=")) conflate_ms = uint32_t(std::stoul(a.substr(14)));
+    else if (starts_with(a, "--conflate-events=")) conflate_events = uint32_t(std::stoul(a.substr(18)));
+    else if (starts_with(a, "--conflate-lag-pct=")) conflate_lag_pct = uint32_t(std::stoul(a.substr(19)));
+    else if (starts_with(a, "--analytics-depth=")) analytics_depth = uint32_t(std::stoul(a.substr(18)));
+    else if (starts_with(a, "--queue-prewarm=")) prealloc.prewarm_levels = std::stoul(a.substr(16));
+    else if (starts_with(a, "--book-reserve=")) prealloc.book_reserve = std::stoul(a.substr(15));
+    else if (starts_with(a, "--log-level=") && log::parse_level(a.substr(12), log_cfg.level)) {}
+    else if (a == "--verbose") verbose = true;
+    else if (!starts_with(a, "--") && path.empty()) path = a;
+    else {
+      std::cerr << "[replay] unknown argument " << a << "\n";
+      return 1;
+    }
+  }
+  if (path.empty() || (book != "map" && book != "ladder")) {
+    std::cerr << "Usage: " << argv[0] << " RECORDING [--pace=fast|recorded] [--speed=X]"
+      << " [--symbol=BTCUSDT] [--ring=PATH|none] [--book=map|ladder] [--wal-dir=DIR] [--stats=PATH] [--view=PATH]"
+      << " [--checkpoint-ms=N] [--checkpoint-events=N] [--conflate=off|always|lag]"
+      << " [--conflate-ms=N] [--conflate-events=N] [--conflate-lag-pct=N] [--analytics-depth=N]"
+      << " [--queue-prewarm=LEVELS] [--book-reserve=LEVELS]"
+      << " [--log-level=info] [--verbose]\n";
+    return 1;
+  }
+
+  if (verbose && log_cfg.level > log::Debug) log_cfg.level = log::Debug;
+  if (!log::start(log_cfg)) return 1;
+
+  std::vector<FeedRecord> records;
+  if (!load_feed(path, records)) {
+    std::cerr << "[replay] cannot read " << path << "\n";
+    return 1;
+  }
+  std::cerr << "[replay] loaded " << records.size() << " records from " << path << "\n";
+  ReplayFeed feed(std::move(records), pace, speed);
+
+  DecimalScale scale;
+  std::string info = feed.exchange_info();
+  if (!info.empty() && !scale_from_exchange_info(info, scale))
+    std::cerr << "[replay] recorded exchangeInfo unusable, using default scale\n";
+
+  ring::RingHandle *ring = nullptr;
+  if (ring_path != "none") {
+    ring = ring::create_ring(ring_path.c_str(), 8 * 1024 * 1024);
+    if (!ring) ring = ring::open_ring(ring_path.c_str());
+    if (!ring) std::cerr << "[replay] ring unavailable, replaying without it\n";
+  }
+  wal::WalWriter wal(wal_cfg);
+  bool wal_on = !wal_cfg.dir.empty() && wal.start();
+
+  PipelineConfig pcfg;
+  pcfg.symbol = symbol;
+  pcfg.ring = ring;
+  pcfg.wal = wal_on ? &wal : nullptr;
+  pcfg.verbose = verbose;
+  pcfg.measure = true;
+  pcfg.checkpoint_ms = checkpoint_ms;
+  pcfg.checkpoint_events = checkpoint_events;
+  pcfg.conflate = conflate;
+  pcfg.conflate_ms = conflate_ms;
+  pcfg.conflate_events = conflate_events;
+  pcfg.conflate_lag_pct = conflate_lag_pct;
+  pcfg.analytics_depth = analytics_depth;
+  pcfg.book_reserve_levels = prealloc.book_reserve;
+  pcfg.prewarm_levels = prealloc.prewarm_levels;
+  // optional live view of the run through aether_stat
+  stats::StatsSegment stats_seg;
+  if (!stats_path.empty() && stats_seg.create(stats_path, 1)) pcfg.stats = stats_seg.add_block("replay");
+  view::BookViewWriter view;
+  if (!view_path.empty() && view.create(view_path, symbol, scale)) pcfg.view = &view;
+
+  int rc = book == "ladder"
+    ? replay<LadderOrderBook>(feed, pcfg, scale, "ladder", prealloc)
+    : replay<OrderBook>(feed, pcfg, scale, "map", prealloc);
+
+  wal.stop();
+  if (ring) ring::close_ring(ring);
+  log::stop();
+  return rc;
+}
@@ -1,87 +1,247 @@
 // rest_client.cpp
 #include "rest_client.h"
 
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/ssl.hpp>
-#include <boost/asio/ip/tcp.hpp>
 #include <openssl/ssl.h>
-#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <memory>
+#include <future>
+#include <stdexcept>
 
 namespace beast = boost::beast;
 namespace http = boost::beast::http;
 namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
+using clock_type = std::chrono::steady_clock;
 
-std::string https_get_sync(net::io_context &ioc,
-    boost::asio::ssl::context &ctx,
-    const std::string &host,
-    const std::string &port,
-    const std::string &target) {
-  try {
-    tcp::resolver resolver{ioc};
-
-    // Use beast::tcp_stream wrapped in ssl_stream for correct layering on some toolchains
-    beast::tcp_stream tcp_stream{ioc};
-    auto const results = resolver.resolve(host, port);
-
-    // Connect TCP socket (tries all endpoints)
-    std::cerr << "[rest_client] connecting TCP to " << host << ":" << port << " ...\n";
-    boost::asio::connect(tcp_stream.socket(), results);
-    std::cerr << "[rest_client] TCP connected\n";
-
-    // Now upgrade to SSL on top of the connected tcp socket
-    beast::ssl_stream<beast::tcp_stream> stream{std::move(tcp_stream), ctx};
-
-    // IMPORTANT: set SNI (Server Name Indication) before TLS handshake
-    if (stream.native_handle() != nullptr) {
-      if (!SSL_set_tlsext_host_name(stream.native_handle(), host.c_str())) {
-        std::cerr << "[rest_client] warning: SSL_set_tlsext_host_name failed\n";
-      } else {
-        std::cerr << "[rest_client] SNI set to " << host << "\n";
-      }
-    } else {
-      std::cerr << "[rest_client] warning: native_handle() returned null\n";
-    }
+namespace aether {
 
-    // Perform TLS handshake
-    std::cerr << "[rest_client] performing TLS handshake...\n";
-    stream.handshake(boost::asio::ssl::stream_base::client);
-    std::cerr << "[rest_client] TLS handshake succeeded\n";
+  struct RestClient::Conn {
+    Conn(const net::any_io_executor &ex, net::ssl::context &ctx, bool tls) : tcp(ex) {
+      if (tls) ssl = std::make_unique<beast::ssl_stream<beast::tcp_stream &>>(tcp, ctx);
+    }
+    beast::tcp_stream tcp;
+    std::unique_ptr<beast::ssl_stream<beast::tcp_stream &>> ssl;
+    beast::flat_buffer buffer;      // may hold bytes read past a response
+    clock_type::time_point idle_since;
+    uint64_t served = 0;
+  };
 
-    // Prepare HTTP request
-    http::request<http::string_body> req{http::verb::get, target, 11};
+  // one request/response on a connected (and, for TLS, handshaken) stream
+  template <class Stream>
+  static net::awaitable<HttpResponse> exchange(Stream &stream, beast::flat_buffer &buffer,
+      const std::string &host, const std::string &target, bool &keep_alive) {
+    http::request<http::empty_body> req{http::verb::get, target, 11};
     req.set(http::field::host, host);
     req.set(http::field::user_agent, "aether-binance");
+    req.keep_alive(true);
+    co_await http::async_write(stream, req, net::use_awaitable);
 
-    // Send the HTTP request over SSL
-    std::cerr << "[rest_client] sending HTTP request " << target << "\n";
-    http::write(stream, req);
-
-    // Receive HTTP response
-    beast::flat_buffer buffer;
     http::response<http::string_body> res;
-    std::cerr << "[rest_client] waiting to read response...\n";
-    http::read(stream, buffer, res);
-    std::cerr << "[rest_client] HTTP response read (status " << res.result_int() << ")\n";
-
-    // Shutdown TLS (ignore EOF as non-fatal)
-    beast::error_code ec;
-    stream.shutdown(ec);
-    if (ec == boost::asio::error::eof) {
-      // Normal EOF on some servers — treat as success
-      ec.assign(0, ec.category());
-      std::cerr << "[rest_client] shutdown EOF ignored\n";
+    co_await http::async_read(stream, buffer, res, net::use_awaitable);
+    keep_alive = res.keep_alive();
+    HttpResponse out{res.result_int(), std::move(res.body())};
+    auto number = [&res](beast::string_view name) -> uint32_t {
+      auto it = res.find(name);
+      if (it == res.end()) return 0;
+      uint32_t v = 0;
+      std::from_chars(it->value().data(), it->value().data() + it->value().size(), v);
+      return v;
+    };
+    out.retry_after_s = number(http::to_string(http::field::retry_after));
+    out.used_weight = number("X-MBX-USED-WEIGHT-1M");
+    co_return out;
+  }
+
+  RestClient::RestClient(NetLoop &loop, const Endpoint &ep, const RestClientConfig &cfg)
+    : loop_(loop), ep_(ep), cfg_(cfg) {
+    if (cfg_.max_connections == 0) cfg_.max_connections = 1;
+  }
+
+  // pooled connections are loop objects: destroy the client once the loop has stopped
+  RestClient::~RestClient() {
+    idle_.clear();
+    if (session_) SSL_SESSION_free(session_);
+  }
+
+  net::awaitable<HttpResponse> RestClient::get(const std::string &target) {
+    ++stats_.requests;
+    for (int attempt = 0; ; ++attempt) {
+      std::unique_ptr<Conn> c = co_await acquire(attempt > 0);
+      Conn *p = c.get();
+      bool reused = p->served > 0;
+      NetLoop::CancelScope scope(loop_, [p] { p->tcp.close(); });
+      try {
+        bool keep_alive = false;
+        p->tcp.expires_after(cfg_.timeout);
+        HttpResponse res;
+        if (p->ssl) res = co_await exchange(*p->ssl, p->buffer, ep_.host, target, keep_alive);
+        else res = co_await exchange(p->tcp, p->buffer, ep_.host, target, keep_alive);
+        if (p->ssl && p->served == 0) {
+          // TLS 1.3 tickets arrive after the handshake, so take the session only now
+          SSL_SESSION *s = SSL_get1_session(p->ssl->native_handle());
+          if (s && SSL_SESSION_is_resumable(s)) {
+            if (session_) SSL_SESSION_free(session_);
+            session_ = s;
+          } else if (s) {
+            SSL_SESSION_free(s);
+          }
+        }
+        ++p->served;
+        if (p->ssl && !keep_alive) {
+          // close_notify: servers drop sessions of connections that just vanish
+          boost::system::error_code ec;
+          co_await p->ssl->async_shutdown(net::redirect_error(net::use_awaitable, ec));
+        }
+        release(std::move(c), keep_alive);
+        co_return res;
+      } catch (const boost::system::system_error &) {
+        release(std::move(c), false);
+        // an idle keep-alive connection the server has dropped fails on first use
+        if (!reused || attempt > 0 || loop_.cancelled()) throw;
+      }
+    }
+  }
+
+  net::awaitable<std::unique_ptr<RestClient::Conn>> RestClient::acquire(bool fresh) {
+    auto ex = co_await net::this_coro::executor;
+    while (true) {
+      if (loop_.cancelled()) throw boost::system::system_error(net::error::operation_aborted);
+      auto now = clock_type::now();
+      while (!idle_.empty()) {
+        std::unique_ptr<Conn> c = std::move(idle_.back());
+        idle_.pop_back();
+        if (!fresh && now - c->idle_since < cfg_.idle_timeout) {
+          ++stats_.reused;
+          co_return c;
+        }
+        --open_; // expired (or a fresh one is wanted): close it
+      }
+      if (open_ < cfg_.max_connections) {
+        ++open_;
+        std::unique_ptr<Conn> c;
+        std::exception_ptr err;
+        try {
+          c = co_await connect();
+        } catch (...) {
+          err = std::current_exception();
+        }
+        if (err) {
+          release(nullptr, false);
+          std::rethrow_exception(err);
+        }
+        co_return c;
+      }
+      // all connections busy: wait for release() (or cancellation) to wake us
+      net::steady_timer wake(ex, clock_type::time_point::max());
+      waiters_.push_back(&wake);
+      {
+        NetLoop::CancelScope scope(loop_, [&wake] { wake.cancel(); });
+        boost::system::error_code ec;
+        co_await wake.async_wait(net::redirect_error(net::use_awaitable, ec));
+      }
+      waiters_.erase(std::remove(waiters_.begin(), waiters_.end(), &wake), waiters_.end());
     }
+  }
+
+  net::awaitable<std::unique_ptr<RestClient::Conn>> RestClient::connect() {
+    auto ex = co_await net::this_coro::executor;
+    auto results = co_await resolve();
+    auto c = std::make_unique<Conn>(ex, loop_.tls(), ep_.tls);
+    Conn *p = c.get();
+    NetLoop::CancelScope scope(loop_, [p] { p->tcp.close(); });
+    p->tcp.expires_after(cfg_.timeout);
+    boost::system::error_code ec;
+    co_await p->tcp.async_connect(results, net::redirect_error(net::use_awaitable, ec));
     if (ec) {
-      std::cerr << "[rest_client] shutdown error: " << ec.message() << " (non-fatal)\n";
+      dns_expiry_ = {}; // the address may have moved: look it up again next time
+      throw boost::system::system_error(ec);
+    }
+    ++stats_.connects;
+    if (p->ssl) {
+      SSL *ssl = p->ssl->native_handle();
+      SSL_set_tlsext_host_name(ssl, ep_.host.c_str()); // SNI before the handshake
+      if (session_) SSL_set_session(ssl, session_);
+      co_await p->ssl->async_handshake(net::ssl::stream_base::client, net::use_awaitable);
+      if (SSL_session_reused(ssl)) ++stats_.tls_resumed;
+    }
+    co_return c;
+  }
+
+  net::awaitable<tcp::resolver::results_type> RestClient::resolve() {
+    auto ex = co_await net::this_coro::executor;
+    // concurrent first requests share one lookup
+    while (resolving_) {
+      net::steady_timer wake(ex, clock_type::time_point::max());
+      dns_waiters_.push_back(&wake);
+      {
+        NetLoop::CancelScope scope(loop_, [&wake] { wake.cancel(); });
+        boost::system::error_code ec;
+        co_await wake.async_wait(net::redirect_error(net::use_awaitable, ec));
+      }
+      dns_waiters_.erase(std::remove(dns_waiters_.begin(), dns_waiters_.end(), &wake), dns_waiters_.end());
+      if (loop_.cancelled()) throw boost::system::system_error(net::error::operation_aborted);
+    }
+    if (!dns_.empty() && clock_type::now() < dns_expiry_) co_return dns_;
+
+    resolving_ = true;
+    tcp::resolver resolver(ex);
+    boost::system::error_code ec;
+    {
+      NetLoop::CancelScope scope(loop_, [&resolver] { resolver.cancel(); });
+      dns_ = co_await resolver.async_resolve(ep_.host, ep_.port, net::redirect_error(net::use_awaitable, ec));
+    }
+    resolving_ = false;
+    for (net::steady_timer *w : dns_waiters_) w->cancel();
+    dns_waiters_.clear();
+    if (ec) throw boost::system::system_error(ec);
+    dns_expiry_ = clock_type::now() + cfg_.dns_ttl;
+    ++stats_.dns_lookups;
+    co_return dns_;
+  }
+
+  void RestClient::release(std::unique_ptr<Conn> c, bool reusable) {
+    if (c && reusable && !loop_.cancelled()) {
+      c->tcp.expires_never();
+      c->idle_since = clock_type::now();
+      idle_.push_back(std::move(c));
     } else {
-      std::cerr << "[rest_client] TLS shutdown succeeded\n";
+      --open_;
     }
+    if (!waiters_.empty()) {
+      waiters_.front()->cancel();
+      waiters_.pop_front();
+    }
+  }
 
-    return res.body();
-  } catch (const std::exception &ex) {
-    std::cerr << "[rest_client] exception: " << ex.what() << "\n";
-    return std::string(); // signal failure to caller (caller should retry/backoff)
+  std::string RestClient::get_blocking(const std::string &target) {
+    std::future<HttpResponse> fut = net::co_spawn(loop_.context(), get(target), net::use_future);
+    while (fut.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+      if (!loop_.running()) throw beast::system_error(net::error::operation_aborted);
+    }
+    HttpResponse res = fut.get();
+    if (res.status != 200)
+      throw std::runtime_error("GET " + target + ": HTTP " + std::to_string(res.status));
+    return std::move(res.body);
+  }
+
+  RestClientStats RestClient::stats() {
+    if (!loop_.running()) return stats_;
+    auto p = std::make_shared<std::promise<RestClientStats>>();
+    std::future<RestClientStats> fut = p->get_future();
+    net::post(loop_.context(), [this, p] { p->set_value(stats_); });
+    while (fut.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready)
+      if (!loop_.running()) return RestClientStats();
+    return fut.get();
   }
-}
+
+} // namespace aether
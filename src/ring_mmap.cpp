@@ -3,22 +3,30 @@
 
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <signal.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
+#include <fstream>
 #include <iostream>
-#include <chrono>
+#include <string>
+#include <vector>
 
 namespace aether { namespace ring {
 
   static constexpr uint32_t RING_MAGIC =
     (uint32_t('A') << 24) | (uint32_t('E') << 16) |
     (uint32_t('T') << 8)  | uint32_t('H'); // "AETH"
-  static constexpr uint16_t RING_VERSION = 1;
+  static constexpr uint16_t RING_VERSION = 3;
   static constexpr uint32_t WRAP_MARKER = 0xFFFFFFFFu;
+  static constexpr size_t PRODUCER_OFFSET = 64;   // head/tail cache line
+  static constexpr size_t READERS_OFFSET = 128;   // first ReaderSlot
 
   struct RingHandle {
     int fd;
@@ -26,9 +34,18 @@ namespace aether { namespace ring {
     void *map_base;              // base of mmap
     RingHeader *hdr;
     std::atomic<uint64_t> *head; // absolute byte offset of next free byte to write
-    std::atomic<uint64_t> *tail; // absolute byte offset of next unread byte by consumer
+    std::atomic<uint64_t> *tail; // absolute byte offset of oldest intact frame (producer-owned)
+    ReaderSlot *readers;         // max_readers slots
+    uint32_t max_readers;
     void *buf_base;              // start of circular buffer region
     uint64_t buf_size;           // convenience copy from header
+    int legacy_slot;             // slot used by ring_set_tail, -1 until first use
+    // producer-local reserve/commit state
+    uint64_t pending_head;       // end of committed frames, >= published head
+    uint64_t res_start;          // absolute offset of the reserved frame
+    uint64_t res_cap;            // payload bytes reserved
+    bool     reserved;
+    uint64_t evicted;            // frames overwritten by this producer
   };
 
   // page align helper
@@ -37,57 +54,113 @@ namespace aether { namespace ring {
     return ((s + p - 1) / p) * p;
   }
 
-  static uint64_t now_us() {
-    using namespace std::chrono;
-    return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+  static std::atomic<uint32_t>* slot_state(ReaderSlot *r) { return reinterpret_cast<std::atomic<uint32_t>*>(&r->state); }
+  static std::atomic<uint64_t>* slot_cursor(ReaderSlot *r) { return reinterpret_cast<std::atomic<uint64_t>*>(&r->cursor); }
+
+  static void bind_layout(RingHandle *h) {
+    uint8_t *m = reinterpret_cast<uint8_t*>(h->map_base);
+    h->head = reinterpret_cast<std::atomic<uint64_t>*>(m + PRODUCER_OFFSET);
+    h->tail = reinterpret_cast<std::atomic<uint64_t>*>(m + PRODUCER_OFFSET + sizeof(uint64_t));
+    h->readers = reinterpret_cast<ReaderSlot*>(m + READERS_OFFSET);
+    h->max_readers = h->hdr->max_readers;
+    h->buf_base = m + h->hdr->data_offset;
+    h->buf_size = h->hdr->buf_size;
+    h->legacy_slot = -1;
+    h->pending_head = h->head->load(std::memory_order_acquire);
+    h->res_start = 0;
+    h->res_cap = 0;
+    h->reserved = false;
+    h->evicted = 0;
+  }
+
+  bool parse_ring_pages(const char *s, RingPages &out) {
+    std::string v = s ? s : "";
+    if (v == "4k") out = RingPages::Default;
+    else if (v == "thp") out = RingPages::Transparent;
+    else if (v == "huge") out = RingPages::Huge;
+    else return false;
+    return true;
   }
 
-  // layout:
-  // [RingHeader][uint64_t head][uint64_t tail][padding (to page)][circular buffer (buf_size bytes)]
-  // head/tail are atomics placed in mmap region
-  RingHandle* create_ring(const char *path, size_t buf_size) {
-    if (!path || buf_size < 4096) {
+  // THP for shared memory is off unless shmem_enabled says otherwise, whatever madvise says
+  static bool advise_huge(void *m, size_t len) {
+    if (madvise(m, len, MADV_HUGEPAGE) != 0) {
+      std::cerr << "[ring] MADV_HUGEPAGE failed (" << strerror(errno) << "), using 4K pages\n";
+      return false;
+    }
+    std::ifstream f("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+    std::string modes;
+    std::getline(f, modes);
+    if (modes.find("[never]") != std::string::npos || modes.find("[deny]") != std::string::npos) {
+      std::cerr << "[ring] transparent huge pages are off for shared memory (shmem_enabled: " << modes
+        << "), using 4K pages\n";
+      return false;
+    }
+    return true;
+  }
+
+  // layout: see ring_mmap.h
+  RingHandle* create_ring(const char *path, size_t buf_size, uint32_t max_readers, RingPages pages) {
+    buf_size &= ~size_t(7); // frames are 8-byte aligned
+    if (!path || buf_size < 4096 || max_readers == 0) {
       std::cerr << "[ring] create_ring: invalid args\n";
       return nullptr;
     }
-    size_t header_sz = sizeof(RingHeader);
-    size_t atomics_sz = sizeof(uint64_t) * 2;
-    size_t meta_pad = 64; // pad so buffer starts at comfy offset
-    size_t total = header_sz + atomics_sz + meta_pad + buf_size;
-    size_t total_mmap = page_round_up(total);
+    static_assert(sizeof(RingHeader) <= PRODUCER_OFFSET, "RingHeader must fit before producer line");
+    static_assert(sizeof(ReaderSlot) == 64, "ReaderSlot must be one cache line");
+    size_t data_offset = page_round_up(READERS_OFFSET + size_t(max_readers) * sizeof(ReaderSlot));
+    size_t total_mmap = page_round_up(data_offset + buf_size);
 
     int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
     if (fd < 0) {
       std::cerr << "[ring] create open failed: " << strerror(errno) << "\n";
       return nullptr;
     }
+    // a hugetlbfs file must be a whole number of huge pages
+    struct statfs fs;
+    bool hugetlb = pages == RingPages::Huge && fstatfs(fd, &fs) == 0 && fs.f_type == HUGETLBFS_MAGIC;
+    if (hugetlb) {
+      size_t hp = (size_t)fs.f_bsize;
+      total_mmap = (total_mmap + hp - 1) / hp * hp;
+    } else if (pages == RingPages::Huge) {
+      std::cerr << "[ring] " << path << " is not on hugetlbfs, trying transparent huge pages\n";
+      pages = RingPages::Transparent;
+    }
     if (ftruncate(fd, (off_t)total_mmap) != 0) {
       std::cerr << "[ring] ftruncate failed: " << strerror(errno) << "\n";
-      close(fd); return nullptr;
+      close(fd); unlink(path); return nullptr;
     }
     void *m = mmap(nullptr, total_mmap, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (m == MAP_FAILED) {
-      std::cerr << "[ring] mmap failed: " << strerror(errno) << "\n";
-      close(fd); return nullptr;
+      // hugetlbfs reserves the pages here: ENOMEM means the pool is too small
+      std::cerr << "[ring] mmap failed: " << strerror(errno)
+        << (hugetlb ? " (not enough free huge pages? see /proc/sys/vm/nr_hugepages)" : "") << "\n";
+      close(fd); unlink(path); return nullptr;
     }
+    if (pages == RingPages::Transparent && !advise_huge(m, total_mmap)) pages = RingPages::Default;
     std::memset(m, 0, total_mmap);
 
     RingHandle *h = new RingHandle();
     h->fd = fd; h->file_size = total_mmap; h->map_base = m;
     h->hdr = reinterpret_cast<RingHeader*>(m);
-    h->hdr->magic = RING_MAGIC;
-    h->hdr->version = RING_VERSION;
     h->hdr->buf_size = (uint64_t)buf_size;
+    h->hdr->max_readers = max_readers;
+    h->hdr->data_offset = data_offset;
 
-    uint8_t *p = reinterpret_cast<uint8_t*>(m) + header_sz;
+    uint8_t *p = reinterpret_cast<uint8_t*>(m) + PRODUCER_OFFSET;
     // placement-new atomic head/tail
-    h->head = new (p) std::atomic<uint64_t>(0);
-    h->tail = new (p + sizeof(uint64_t)) std::atomic<uint64_t>(0);
+    new (p) std::atomic<uint64_t>(0);
+    new (p + sizeof(uint64_t)) std::atomic<uint64_t>(0);
+    bind_layout(h);
 
-    h->buf_base = reinterpret_cast<void*>(reinterpret_cast<uint8_t*>(m) + header_sz + atomics_sz + meta_pad);
-    h->buf_size = buf_size;
+    // publish magic/version last so a concurrent open never sees a half-built header
+    h->hdr->version = RING_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    h->hdr->magic = RING_MAGIC;
 
-    std::cerr << "[ring] created ring " << path << " mmap=" << total_mmap << " buf_size=" << buf_size << "\n";
+    std::cerr << "[ring] created ring " << path << " mmap=" << total_mmap << " buf_size=" << buf_size
+      << " max_readers=" << max_readers << (hugetlb ? " pages=hugetlbfs" : pages == RingPages::Transparent ? " pages=thp" : "")
+      << "\n";
     return h;
   }
 
@@ -98,26 +171,28 @@ namespace aether { namespace ring {
     struct stat st;
     if (fstat(fd, &st) != 0) { std::cerr << "[ring] fstat failed\n"; close(fd); return nullptr; }
     size_t total_mmap = (size_t)st.st_size;
+    if (total_mmap < sizeof(RingHeader)) { std::cerr << "[ring] file too small\n"; close(fd); return nullptr; }
     void *m = mmap(nullptr, total_mmap, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (m == MAP_FAILED) { std::cerr << "[ring] mmap open failed: " << strerror(errno) << "\n"; close(fd); return nullptr; }
     RingHeader *hdr = reinterpret_cast<RingHeader*>(m);
     if (hdr->magic != RING_MAGIC) { std::cerr << "[ring] magic mismatch\n"; munmap(m, total_mmap); close(fd); return nullptr; }
+    if (hdr->version != RING_VERSION) {
+      std::cerr << "[ring] version mismatch: file v" << hdr->version << ", expected v" << RING_VERSION << "\n";
+      munmap(m, total_mmap); close(fd); return nullptr;
+    }
+    if (hdr->data_offset + hdr->buf_size > total_mmap) {
+      std::cerr << "[ring] header sizes exceed file\n"; munmap(m, total_mmap); close(fd); return nullptr;
+    }
     RingHandle *h = new RingHandle();
     h->fd = fd; h->file_size = total_mmap; h->map_base = m; h->hdr = hdr;
-    size_t header_sz = sizeof(RingHeader);
-    uint8_t *p = reinterpret_cast<uint8_t*>(m) + header_sz;
-    h->head = reinterpret_cast<std::atomic<uint64_t>*>(p);
-    h->tail = reinterpret_cast<std::atomic<uint64_t>*>(p + sizeof(uint64_t));
-    size_t atomics_sz = sizeof(uint64_t)*2;
-    size_t meta_pad = 64;
-    h->buf_base = reinterpret_cast<void*>(reinterpret_cast<uint8_t*>(m) + header_sz + atomics_sz + meta_pad);
-    h->buf_size = (uint64_t)hdr->buf_size;
+    bind_layout(h);
     std::cerr << "[ring] opened ring " << path << " buf_size=" << h->buf_size << "\n";
     return h;
   }
 
   void close_ring(RingHandle *h) {
     if (!h) return;
+    if (h->legacy_slot >= 0) deregister_reader(h, h->legacy_slot);
     munmap(h->map_base, h->file_size);
     close(h->fd);
     delete h;
@@ -126,68 +201,308 @@ namespace aether { namespace ring {
   uint64_t ring_head(const RingHandle *h) { return h ? h->head->load(std::memory_order_acquire) : 0; }
   uint64_t ring_tail(const RingHandle *h) { return h ? h->tail->load(std::memory_order_acquire) : 0; }
   uint64_t ring_buf_size(const RingHandle *h) { return h ? h->buf_size : 0; }
+  uint64_t ring_evicted(const RingHandle *h) { return h ? h->evicted : 0; }
 
-  // publish framed message with wrap-on-need. Overwrite-oldest policy by advancing tail if needed.
-  bool publish_message(RingHandle *h, uint8_t msg_type, const void *payload, size_t payload_len) {
-    if (!h) return false;
-    if (payload_len > (size_t)h->buf_size) return false; // too big
+  uint64_t ring_max_reader_lag(const RingHandle *h) {
+    if (!h) return 0;
+    uint64_t head = h->head->load(std::memory_order_acquire);
+    uint64_t tail = h->tail->load(std::memory_order_acquire);
+    uint64_t lag = 0;
+    for (uint32_t i = 0; i < h->max_readers; ++i) {
+      ReaderSlot *r = &h->readers[i];
+      if (slot_state(r)->load(std::memory_order_relaxed) != 1) continue;
+      uint64_t cur = slot_cursor(r)->load(std::memory_order_relaxed);
+      if (cur < tail || cur > head) continue;
+      if (head - cur > lag) lag = head - cur;
+    }
+    return lag;
+  }
 
-    uint32_t msg_len = (uint32_t)(1 + payload_len); // type + payload
-    uint64_t need = (uint64_t)4 + msg_len; // length field + msg_len
+  static constexpr uint64_t FRAME_ALIGN = 8;
 
-    // load positions
-    uint64_t head = h->head->load(std::memory_order_relaxed);
-    uint64_t tail = h->tail->load(std::memory_order_acquire);
-    uint64_t used = head - tail;
-    if (need > h->buf_size) return false;
+  static uint64_t frame_total(uint64_t payload_len) {
+    return (sizeof(FrameHeader) + payload_len + FRAME_ALIGN - 1) & ~(FRAME_ALIGN - 1);
+  }
 
-    if (need > h->buf_size - used) {
-      // drop oldest bytes to make room (advance tail)
-      uint64_t want_free = need - (h->buf_size - used);
-      tail += want_free;
-      h->tail->store(tail, std::memory_order_release);
-      // note: consumer will see tail advanced and will skip messages (lost)
-    }
+  // absolute offset of the frame after the one starting at off; frames counts real
+  // frames stepped over (not wrap markers)
+  static uint64_t next_frame(const RingHandle *h, uint64_t off, uint64_t &frames) {
+    uint64_t pos = off % h->buf_size;
+    uint64_t room = h->buf_size - pos;
+    uint32_t len;
+    std::memcpy(&len, reinterpret_cast<const uint8_t*>(h->buf_base) + pos, sizeof(len));
+    if (len == WRAP_MARKER) return off + room;
+    ++frames;
+    return off + frame_total(len);
+  }
 
+  // Reserve space for a frame after pending_head, with wrap-on-need. Overwrite-oldest
+  // policy: tail is walked forward frame by frame (so it always sits on a frame
+  // boundary) and stored before any byte of an old frame is overwritten; that store is
+  // what lets readers validate a frame after use. Readers are never consulted.
+  void* reserve(RingHandle *h, size_t max_len) {
+    if (!h || h->reserved) return nullptr;
+    if (max_len > (size_t)h->buf_size || max_len >= WRAP_MARKER) return nullptr; // too big
+
+    uint64_t need = frame_total(max_len);
+    if (need > h->buf_size) return nullptr;
+
+    uint64_t head = h->pending_head;
     uint64_t pos = head % h->buf_size;
-    uint8_t *buf = reinterpret_cast<uint8_t*>(h->buf_base);
+    uint64_t start = head;
+    if (pos + need > h->buf_size) start = head + (h->buf_size - pos); // frame goes to next lap
+    uint64_t end = start + need;
 
-    if (pos + need <= h->buf_size) {
-      // one contiguous write
-      uint32_t len_field = msg_len;
-      std::memcpy(buf + pos, &len_field, sizeof(uint32_t));
-      buf[pos + 4] = msg_type;
-      if (payload_len) std::memcpy(buf + pos + 5, payload, payload_len);
-    } else {
-      // need wrap: write WRAP_MARKER at pos, then write frame at 0
+    // evict frames overlapping [head, end - buf_size) before touching their bytes
+    uint64_t tail = h->tail->load(std::memory_order_relaxed);
+    if (tail + h->buf_size < end) {
+      while (tail < head && tail + h->buf_size < end) tail = next_frame(h, tail, h->evicted);
+      if (tail + h->buf_size < end) tail = start;
+      h->tail->store(tail, std::memory_order_relaxed);
+      // order the tail store before the overwriting stores below (seqlock writer side)
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    uint8_t *buf = reinterpret_cast<uint8_t*>(h->buf_base);
+    if (start != head) {
+      // frames are 8-aligned and buf_size is a multiple of 8, so the marker always fits
       uint32_t wm = WRAP_MARKER;
-      if (pos + sizeof(uint32_t) <= h->buf_size) {
-        std::memcpy(buf + pos, &wm, sizeof(uint32_t));
-      } else {
-        // theoretically pos+4 cannot exceed buf_size because we tested pos+need>buf_size and sizeof(uint32_t)=4 <= need
-        // but defensive
-        size_t part = h->buf_size - pos;
-        std::memcpy(buf + pos, &wm, part);
-        std::memcpy(buf, reinterpret_cast<uint8_t*>(&wm) + part, sizeof(uint32_t)-part);
-      }
-      // write frame at start
-      uint32_t len_field = msg_len;
-      std::memcpy(buf + 0, &len_field, sizeof(uint32_t));
-      buf[4] = msg_type;
-      if (payload_len) std::memcpy(buf + 5, payload, payload_len);
-      // Note: remaining bytes after payload at end of frame are left as-is or zeroed optional
+      std::memcpy(buf + pos, &wm, sizeof(uint32_t));
+      h->pending_head = start; // the skipped tail end belongs to the previous lap
     }
+    h->res_start = start;
+    h->res_cap = max_len;
+    h->reserved = true;
+    return buf + (start % h->buf_size) + sizeof(FrameHeader);
+  }
+
+  bool commit_deferred(RingHandle *h, uint8_t msg_type, size_t len) {
+    if (!h || !h->reserved || len > h->res_cap) return false;
+    FrameHeader fh{};
+    fh.len = (uint32_t)len;
+    fh.type = msg_type;
+    fh.seq = h->res_start;
+    uint8_t *buf = reinterpret_cast<uint8_t*>(h->buf_base);
+    std::memcpy(buf + (h->res_start % h->buf_size), &fh, sizeof(fh));
+    h->pending_head = h->res_start + frame_total(len);
+    h->reserved = false;
+    return true;
+  }
 
+  void flush(RingHandle *h) {
+    if (!h) return;
     // release fence to ensure buffer writes visible before advancing head
     std::atomic_thread_fence(std::memory_order_release);
-    h->head->store(head + need, std::memory_order_release);
+    h->head->store(h->pending_head, std::memory_order_release);
+  }
+
+  bool commit(RingHandle *h, uint8_t msg_type, size_t len) {
+    if (!commit_deferred(h, msg_type, len)) return false;
+    flush(h);
+    return true;
+  }
+
+  void abort(RingHandle *h) {
+    if (h) h->reserved = false;
+  }
+
+  bool publish_message(RingHandle *h, uint8_t msg_type, const void *payload, size_t payload_len) {
+    void *p = reserve(h, payload_len);
+    if (!p) return false;
+    if (payload_len) std::memcpy(p, payload, payload_len);
+    return commit(h, msg_type, payload_len);
+  }
+
+  // next frame at the slot's cursor. On a lap the cursor is left where it was (so the
+  // lap is seen again) and lap_at is the offset where it was detected.
+  static int read_frame(RingHandle *h, ReaderSlot *r, FrameView &out, uint64_t &lap_at) {
+    uint64_t cur = slot_cursor(r)->load(std::memory_order_relaxed);
+    const uint8_t *buf = reinterpret_cast<const uint8_t*>(h->buf_base);
+
+    while (true) {
+      uint64_t head = h->head->load(std::memory_order_acquire);
+      if (cur >= head) {
+        slot_cursor(r)->store(cur, std::memory_order_release);
+        return RING_READ_EMPTY;
+      }
+      uint64_t tail = h->tail->load(std::memory_order_acquire);
+      if (cur < tail) break; // lapped
+
+      uint64_t pos = cur % h->buf_size;
+      FrameHeader fh;
+      std::memcpy(&fh, buf + pos, sizeof(uint32_t));
+      if (fh.len == WRAP_MARKER) {
+        cur += h->buf_size - pos;
+        continue;
+      }
+      std::memcpy(&fh, buf + pos, sizeof(fh));
+      // header bytes are only trustworthy if tail did not pass cur while we copied them
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (h->tail->load(std::memory_order_relaxed) > cur) break;
+      if (fh.seq != cur || pos + frame_total(fh.len) > h->buf_size) break; // stale lap
+
+      out.offset = cur;
+      out.next = cur + frame_total(fh.len);
+      out.data = buf + pos + sizeof(fh);
+      out.len = fh.len;
+      out.type = fh.type;
+      out.flags = fh.flags;
+      slot_cursor(r)->store(out.next, std::memory_order_release);
+      return RING_READ_OK;
+    }
+    lap_at = cur;
+    return RING_READ_LAPPED;
+  }
+
+  // resume a lapped reader at the oldest intact frame (or at head if the stamp was bad
+  // without tail moving, which only a foreign writer could cause)
+  static void skip_lap(RingHandle *h, ReaderSlot *r, uint64_t lap_at) {
+    uint64_t tail = h->tail->load(std::memory_order_acquire);
+    slot_cursor(r)->store(tail > lap_at ? tail : h->head->load(std::memory_order_acquire), std::memory_order_release);
+    ++r->lapped;
+  }
+
+  int read_next(RingHandle *h, int slot, FrameView &out) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return RING_READ_EMPTY;
+    ReaderSlot *r = &h->readers[slot];
+    uint64_t lap_at = 0;
+    int rc = read_frame(h, r, out, lap_at);
+    if (rc == RING_READ_LAPPED) skip_lap(h, r, lap_at);
+    return rc;
+  }
+
+  int read_batch(RingHandle *h, int slot, FrameView *out, int max) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return RING_READ_EMPTY;
+    ReaderSlot *r = &h->readers[slot];
+    int n = 0;
+    while (n < max) {
+      uint64_t lap_at = 0;
+      int rc = read_frame(h, r, out[n], lap_at);
+      if (rc == RING_READ_OK) { ++n; continue; }
+      if (rc == RING_READ_LAPPED && n == 0) {
+        skip_lap(h, r, lap_at);
+        return RING_READ_LAPPED;
+      }
+      // a lap after some frames: report those; the cursor stays before the lap, so
+      // the next call detects it again and returns LAPPED
+      break;
+    }
+    return n;
+  }
+
+  bool frame_valid(const RingHandle *h, const FrameView &v) {
+    if (!h) return false;
+    // seqlock reader side: every load of the frame happens before this tail load
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return h->tail->load(std::memory_order_relaxed) <= v.offset;
+  }
+
+  // One pass over [tail, head) reading frame headers and, for SNAPSHOT frames, the
+  // payload's symbol id. A pass that the producer lapped is retried from the new tail.
+  bool seek_snapshot(RingHandle *h, int slot, const uint32_t *symbol_ids, size_t n) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return false;
+    const uint8_t *buf = reinterpret_cast<const uint8_t*>(h->buf_base);
+    std::vector<uint64_t> latest(n ? n : 1);
+    for (int attempt = 0; attempt < 4; ++attempt) {
+      std::fill(latest.begin(), latest.end(), UINT64_MAX);
+      uint64_t head = h->head->load(std::memory_order_acquire);
+      uint64_t cur = h->tail->load(std::memory_order_acquire);
+      bool lapped = false;
+      while (cur < head) {
+        uint64_t pos = cur % h->buf_size;
+        FrameHeader fh;
+        std::memcpy(&fh, buf + pos, sizeof(uint32_t));
+        if (fh.len == WRAP_MARKER) {
+          cur += h->buf_size - pos;
+          continue;
+        }
+        std::memcpy(&fh, buf + pos, sizeof(fh));
+        // a torn header may carry any length: only trust one that fits this lap
+        aether_frame_header ah;
+        bool snap = fh.type == AETHER_MSG_SNAPSHOT && pos + frame_total(fh.len) <= h->buf_size
+          && aether_frame_read_header(buf + pos + sizeof(fh), fh.len, &ah);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h->tail->load(std::memory_order_relaxed) > cur || fh.seq != cur
+            || pos + frame_total(fh.len) > h->buf_size) {
+          lapped = true;
+          break;
+        }
+        if (snap) {
+          if (!n) latest[0] = cur;
+          for (size_t i = 0; i < n; ++i)
+            if (symbol_ids[i] == ah.symbol_id) latest[i] = cur;
+        }
+        cur += frame_total(fh.len);
+      }
+      if (lapped) continue;
+      uint64_t at = *std::max_element(latest.begin(), latest.end());
+      if (at == UINT64_MAX) return false;
+      at = *std::min_element(latest.begin(), latest.end());
+      // the oldest of them may have been overwritten since: rescan then
+      if (h->tail->load(std::memory_order_acquire) > at) continue;
+      slot_cursor(&h->readers[slot])->store(at, std::memory_order_release);
+      return true;
+    }
+    return false;
+  }
+
+  int register_reader(RingHandle *h) {
+    if (!h) return -1;
+    uint32_t me = (uint32_t)getpid();
+    for (int pass = 0; pass < 2; ++pass) {
+      for (uint32_t i = 0; i < h->max_readers; ++i) {
+        ReaderSlot *r = &h->readers[i];
+        uint32_t st = slot_state(r)->load(std::memory_order_acquire);
+        if (st != 0) {
+          // second pass: reclaim slots whose owner process is gone
+          if (pass == 0 || r->pid == 0 || r->pid == me) continue;
+          if (kill((pid_t)r->pid, 0) == 0 || errno != ESRCH) continue;
+          if (!slot_state(r)->compare_exchange_strong(st, 0)) continue;
+          std::cerr << "[ring] reclaimed reader slot " << i << " from dead pid " << r->pid << "\n";
+        }
+        uint32_t expected = 0;
+        if (!slot_state(r)->compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) continue;
+        r->pid = me;
+        r->lapped = 0;
+        slot_cursor(r)->store(h->head->load(std::memory_order_acquire), std::memory_order_release);
+        return (int)i;
+      }
+    }
+    return -1;
+  }
+
+  void deregister_reader(RingHandle *h, int slot) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return;
+    ReaderSlot *r = &h->readers[slot];
+    r->pid = 0;
+    slot_state(r)->store(0, std::memory_order_release);
+  }
+
+  uint64_t reader_cursor(const RingHandle *h, int slot) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return 0;
+    return slot_cursor(const_cast<ReaderSlot*>(&h->readers[slot]))->load(std::memory_order_acquire);
+  }
+
+  void set_reader_cursor(RingHandle *h, int slot, uint64_t cursor) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return;
+    slot_cursor(&h->readers[slot])->store(cursor, std::memory_order_release);
+  }
+
+  bool reader_check_lapped(RingHandle *h, int slot) {
+    if (!h || slot < 0 || (uint32_t)slot >= h->max_readers) return false;
+    ReaderSlot *r = &h->readers[slot];
+    uint64_t cur = slot_cursor(r)->load(std::memory_order_relaxed);
+    uint64_t tail = h->tail->load(std::memory_order_acquire);
+    if (cur >= tail) return false;
+    slot_cursor(r)->store(tail, std::memory_order_release);
+    ++r->lapped;
     return true;
   }
 
   bool publish_snapshot_json(RingHandle *h, const char *json_cstr) {
     if (!h || !json_cstr) return false;
     size_t len = strlen(json_cstr);
-    return publish_message(h, 2 /*SNAPSHOT*/, json_cstr, len);
+    return publish_message(h, AETHER_MSG_SNAPSHOT_JSON, json_cstr, len);
   }
 
   // C bindings
@@ -199,6 +514,12 @@ namespace aether { namespace ring {
       RingHandleC *c = (RingHandleC*)malloc(sizeof(RingHandleC));
       c->h = h; return c;
     }
+    RingHandleC* ring_create_ex(const char *path, size_t buf_size, uint32_t max_readers) {
+      RingHandle *h = create_ring(path, buf_size, max_readers);
+      if (!h) return nullptr;
+      RingHandleC *c = (RingHandleC*)malloc(sizeof(RingHandleC));
+      c->h = h; return c;
+    }
     RingHandleC* ring_open(const char *path) {
       RingHandle *h = open_ring(path);
       if (!h) return nullptr;
@@ -231,13 +552,56 @@ namespace aether { namespace ring {
       return impl->buf_base;
     }
 
-    // Atomically set the tail for the consumer. Use release ordering so producer sees progress.
+    // Legacy: record consumer progress in this handle's own reader slot.
     void ring_set_tail(struct RingHandleC* ch, uint64_t new_tail) {
       if (!ch || !ch->h) return;
       aether::ring::RingHandle *impl = ch->h;
-      if (impl->tail) {
-        impl->tail->store(new_tail, std::memory_order_release);
-      }
+      if (impl->legacy_slot < 0) impl->legacy_slot = register_reader(impl);
+      set_reader_cursor(impl, impl->legacy_slot, new_tail);
+    }
+
+    int ring_reader_register(RingHandleC* ch) { return ch ? register_reader(ch->h) : -1; }
+    void ring_reader_deregister(RingHandleC* ch, int slot) { if (ch) deregister_reader(ch->h, slot); }
+    uint64_t ring_reader_get_cursor(RingHandleC* ch, int slot) { return ch ? reader_cursor(ch->h, slot) : 0; }
+    void ring_reader_set_cursor(RingHandleC* ch, int slot, uint64_t cursor) { if (ch) set_reader_cursor(ch->h, slot, cursor); }
+    int ring_reader_check_lapped(RingHandleC* ch, int slot) { return ch && reader_check_lapped(ch->h, slot) ? 1 : 0; }
+
+    void* ring_reserve(RingHandleC* ch, size_t max_len) { return ch ? reserve(ch->h, max_len) : nullptr; }
+    int ring_commit(RingHandleC* ch, unsigned int msg_type, size_t len) {
+      return ch && commit(ch->h, (uint8_t)msg_type, len) ? 1 : 0;
+    }
+    int ring_commit_deferred(RingHandleC* ch, unsigned int msg_type, size_t len) {
+      return ch && commit_deferred(ch->h, (uint8_t)msg_type, len) ? 1 : 0;
+    }
+    void ring_flush(RingHandleC* ch) { if (ch) flush(ch->h); }
+    void ring_abort(RingHandleC* ch) { if (ch) abort(ch->h); }
+
+    int ring_read_next(RingHandleC* ch, int slot, ring_frame_view* out) {
+      if (!ch || !out) return RING_READ_EMPTY;
+      return read_next(ch->h, slot, *out);
+    }
+    int ring_read_batch(RingHandleC* ch, int slot, ring_frame_view* out, int max) {
+      if (!ch || !out || max <= 0) return 0;
+      return read_batch(ch->h, slot, out, max);
+    }
+    int ring_frame_valid(RingHandleC* ch, const ring_frame_view* v) {
+      if (!ch || !v) return 0;
+      return frame_valid(ch->h, *v) ? 1 : 0;
+    }
+
+    int ring_reader_seek_snapshot(RingHandleC* ch, int slot, const uint32_t* symbol_ids, size_t n) {
+      if (!ch || (n && !symbol_ids)) return 0;
+      return seek_snapshot(ch->h, slot, symbol_ids, n) ? 1 : 0;
+    }
+
+    int ring_frame_read_header(const void* payload, size_t len, aether_frame_header* out) {
+      if (!out) return 0;
+      return aether_frame_read_header(payload, len, out);
+    }
+
+    void ring_frame_read_level(const void* payload, uint32_t idx, aether_level* out) {
+      if (!payload || !out) return;
+      aether_frame_read_level(payload, idx, out);
     }
 
   } // extern C
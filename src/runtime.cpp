@@ -0,0 +1,104 @@
+// runtime.cpp
+#include "runtime.h"
+#include "log.h"
+
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace aether { namespace rt {
+
+  bool parse_cpu_list(const std::string &s, std::vector<int> &out) {
+    out.clear();
+    size_t i = 0;
+    while (i < s.size()) {
+      size_t end = s.find(',', i);
+      if (end == std::string::npos) end = s.size();
+      std::string item = s.substr(i, end - i);
+      size_t dash = item.find('-');
+      char *e1 = nullptr, *e2 = nullptr;
+      long lo = std::strtol(item.c_str(), &e1, 10);
+      long hi = lo;
+      if (dash != std::string::npos) hi = std::strtol(item.c_str() + dash + 1, &e2, 10);
+      bool ok = !item.empty() && e1 != item.c_str() && lo >= 0 && hi >= lo && hi < CPU_SETSIZE
+        && (dash == std::string::npos ? *e1 == '\0' : (e1 == item.c_str() + dash && e2 && *e2 == '\0'));
+      if (!ok) return false;
+      for (long c = lo; c <= hi; ++c) out.push_back(int(c));
+      i = end + 1;
+    }
+    return !out.empty();
+  }
+
+  bool apply_thread_policy(const ThreadPolicy &p, const char *name) {
+    char short_name[16];
+    std::strncpy(short_name, name, sizeof(short_name) - 1);
+    short_name[sizeof(short_name) - 1] = '\0';
+    pthread_setname_np(pthread_self(), short_name);
+
+    bool ok = true;
+    if (p.cpu >= 0) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(p.cpu, &set);
+      int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      if (rc != 0) {
+        AETHER_LOG_WARN("[rt] {}: cannot pin to cpu {}: {}", name, p.cpu, strerror(rc));
+        ok = false;
+      }
+    }
+    if (p.rt_priority > 0) {
+      sched_param sp{};
+      sp.sched_priority = p.rt_priority;
+      int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+      if (rc != 0) {
+        AETHER_LOG_WARN("[rt] {}: SCHED_FIFO {} refused: {}", name, p.rt_priority, strerror(rc));
+        ok = false;
+      }
+    }
+    if (ok && (p.cpu >= 0 || p.rt_priority > 0))
+      AETHER_LOG_INFO("[rt] {} on cpu {} priority {}", name, p.cpu, p.rt_priority);
+    return ok;
+  }
+
+  bool lock_memory() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+      AETHER_LOG_WARN("[rt] mlockall failed: {} (needs CAP_IPC_LOCK or ulimit -l)", strerror(errno));
+      return false;
+    }
+    AETHER_LOG_INFO("[rt] memory locked");
+    return true;
+  }
+
+  void retain_heap() {
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+  }
+
+  // a separate frame so the alloca'd block is below the caller's stack
+  __attribute__((noinline)) static void touch_stack(size_t n) {
+    auto *p = static_cast<volatile char*>(alloca(n));
+    for (size_t i = 0; i < n; i += 4096) p[i] = 0;
+  }
+
+  void prefault_thread(size_t stack_bytes, size_t heap_bytes) {
+    if (stack_bytes) touch_stack(stack_bytes);
+    // in chunks: a single huge block would be served by mmap (or not at all with
+    // M_MMAP_MAX = 0) instead of growing this thread's arena
+    const size_t chunk = 1 << 20;
+    std::vector<void*> blocks;
+    for (size_t done = 0; done < heap_bytes; done += chunk) {
+      void *b = std::malloc(chunk);
+      if (!b) break;
+      std::memset(b, 0, chunk);
+      blocks.push_back(b);
+    }
+    for (void *b : blocks) std::free(b);
+  }
+
+}} // namespace aether::rt
@@ -0,0 +1,247 @@
+// shard_engine.cpp
+#include "shard_engine.h"
+#include "log.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace aether {
+
+  template <class Book>
+  BasicShardEngine<Book>::BasicShardEngine(const ShardConfig &cfg, const std::vector<SymbolSpec> &symbols)
+    : cfg_(cfg) {
+    if (cfg_.shards == 0) cfg_.shards = 1;
+    if (cfg_.shards > symbols.size() && !symbols.empty()) cfg_.shards = symbols.size();
+
+    for (size_t i = 0; i < cfg_.shards; ++i) {
+      auto sh = std::make_unique<Shard>(cfg_.queue_capacity);
+      if (cfg_.queue_prewarm_levels) sh->queue.prewarm(cfg_.queue_prewarm_levels);
+      if (!cfg_.ring_path.empty()) {
+        std::string path = cfg_.shards == 1 ? cfg_.ring_path : cfg_.ring_path + "." + std::to_string(i);
+        sh->ring = ring::create_ring(path.c_str(), cfg_.ring_bytes, ring::DEFAULT_MAX_READERS, cfg_.ring_pages);
+        if (!sh->ring) sh->ring = ring::open_ring(path.c_str());
+        if (!sh->ring) AETHER_LOG_WARN("[engine] ring {} unavailable, shard {} publishes without it", path, i);
+        else AETHER_LOG_INFO("[engine] shard {} ring {}", i, path);
+      }
+      if (cfg_.stats) {
+        sh->stats = cfg_.stats->add_block("shard-" + std::to_string(i));
+        if (!sh->stats) AETHER_LOG_WARN("[engine] stats segment full, shard {} not reported", i);
+      }
+      if (!cfg_.wal.dir.empty()) {
+        wal::WalConfig wc = cfg_.wal;
+        if (cfg_.shards > 1) wc.dir += "/shard-" + std::to_string(i);
+        sh->wal = std::make_unique<wal::WalWriter>(wc);
+        if (!sh->wal->start()) sh->wal.reset();
+      }
+      shards_.push_back(std::move(sh));
+    }
+
+    auto shard_of = [&](const SymbolSpec &spec) {
+      return spec.shard >= 0 ? size_t(spec.shard) % cfg_.shards
+        : size_t(aether_symbol_id(spec.symbol.c_str())) % cfg_.shards;
+    };
+    // the checkpoint byte budget is per shard ring, shared by the shard's symbols
+    std::vector<size_t> per_shard(cfg_.shards, 0);
+    for (const auto &spec : symbols) ++per_shard[shard_of(spec)];
+
+    for (const auto &spec : symbols) {
+      if (router_.find(spec.symbol)) {
+        AETHER_LOG_WARN("[engine] {} listed twice, booked once", spec.symbol);
+        continue;
+      }
+      size_t s = shard_of(spec);
+      Shard &sh = *shards_[s];
+      PipelineConfig pc;
+      pc.symbol = spec.symbol;
+      pc.ring = sh.ring;
+      pc.wal = sh.wal.get();
+      pc.verbose = cfg_.verbose;
+      pc.measure = cfg_.measure;
+      pc.stats = sh.stats;
+      pc.checkpoint_ms = cfg_.checkpoint_ms;
+      pc.checkpoint_events = cfg_.checkpoint_events;
+      if (sh.ring && cfg_.checkpoint_ring_pct)
+        pc.checkpoint_bytes_per_s = cfg_.ring_bytes * cfg_.checkpoint_ring_pct / 100 / per_shard[s];
+      pc.conflate = cfg_.conflate;
+      pc.conflate_ms = cfg_.conflate_ms;
+      pc.conflate_events = cfg_.conflate_events;
+      pc.conflate_lag_pct = cfg_.conflate_lag_pct;
+      pc.analytics_depth = cfg_.analytics_depth;
+      pc.book_reserve_levels = cfg_.book_reserve_levels;
+      pc.prewarm_levels = cfg_.queue_prewarm_levels;
+      if (!cfg_.view_dir.empty()) {
+        auto v = std::make_unique<view::BookViewWriter>();
+        if (v->create(view::view_path(cfg_.view_dir, spec.symbol), spec.symbol, spec.scale, cfg_.view_depth))
+          pc.view = v.get();
+        sh.views.push_back(std::move(v));
+      }
+
+      SymbolRoute r;
+      r.symbol = spec.symbol;
+      r.queue = &sh.queue;
+      r.index = uint32_t(sh.pipelines.size());
+      r.scale = spec.scale;
+      router_.add(r);
+      sh.pipelines.push_back(std::make_unique<Pipeline>(pc, spec.scale));
+      sh.dead.push_back(0);
+      AETHER_LOG_INFO("[engine] {} -> shard {}", spec.symbol, s);
+    }
+  }
+
+  template <class Book>
+  BasicShardEngine<Book>::~BasicShardEngine() { join(); }
+
+  template <class Book>
+  void BasicShardEngine<Book>::start(SnapshotSource &snaps, std::atomic<bool> &stop,
+      std::function<void()> on_all_stopped) {
+    on_all_stopped_ = std::move(on_all_stopped);
+    size_t n = 0;
+    for (const auto &sh : shards_) n += sh->pipelines.size();
+    running_.store(n, std::memory_order_relaxed);
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      Shard *p = shards_[i].get();
+      // nothing would ever end a shard without symbols: no route feeds its queue
+      if (p->pipelines.empty()) {
+        AETHER_LOG_INFO("[engine] shard {} has no symbols, not started", i);
+        continue;
+      }
+      rt::ThreadPolicy pol;
+      if (!cfg_.book_cpus.empty()) pol.cpu = cfg_.book_cpus[i % cfg_.book_cpus.size()];
+      pol.rt_priority = cfg_.book_rt_priority;
+      std::string name = "aether-book-" + std::to_string(i);
+      p->thread = std::thread([this, p, pol, name, &snaps, &stop] {
+          rt::apply_thread_policy(pol, name.c_str());
+          if (cfg_.prefault_heap_bytes) rt::prefault_thread(256 << 10, cfg_.prefault_heap_bytes);
+          run_shard(*p, snaps, stop);
+      });
+    }
+  }
+
+  template <class Book>
+  void BasicShardEngine<Book>::join() {
+    for (auto &sh : shards_) {
+      if (sh->thread.joinable()) sh->thread.join();
+      if (sh->ring) {
+        ring::close_ring(sh->ring);
+        sh->ring = nullptr;
+      }
+      if (sh->wal) sh->wal->stop();
+      for (auto &v : sh->views) v->close();
+    }
+  }
+
+  template <class Book>
+  PipelineStats BasicShardEngine<Book>::totals() const {
+    PipelineStats t;
+    for (const auto &sh : shards_) {
+      for (const auto &p : sh->pipelines) {
+        const PipelineStats &s = p->stats();
+        t.applied += s.applied;
+        t.stale += s.stale;
+        t.published += s.published;
+        t.publish_failures += s.publish_failures;
+        t.resyncs += s.resyncs;
+        t.resync_retries += s.resync_retries;
+        t.queue_us.merge(s.queue_us);
+        t.apply_ns.merge(s.apply_ns);
+        t.publish_ns.merge(s.publish_ns);
+        t.resync_us.merge(s.resync_us);
+        t.checkpoints += s.checkpoints;
+        t.checkpoint_ns.merge(s.checkpoint_ns);
+        t.conflated_frames += s.conflated_frames;
+        t.conflated_deltas += s.conflated_deltas;
+        t.allocs += s.allocs;
+        t.alloc_events += s.alloc_events;
+        t.last_alloc_event = std::max(t.last_alloc_event, s.last_alloc_event);
+      }
+      for (uint8_t d : sh->dead) t.stopped += d;
+    }
+    return t;
+  }
+
+  template <class Book>
+  void BasicShardEngine<Book>::park(Shard &sh, size_t i) {
+    sh.dead[i] = 1;
+    AETHER_LOG_WARN("[engine] {} stopped", sh.pipelines[i]->symbol());
+    if (running_.fetch_sub(1, std::memory_order_acq_rel) == 1 && on_all_stopped_) on_all_stopped_();
+  }
+
+  template <class Book>
+  void BasicShardEngine<Book>::run_shard(Shard &sh, SnapshotSource &snaps, std::atomic<bool> &stop) {
+    for (auto &p : sh.pipelines) p->start_sync(snaps);
+    size_t syncing = sh.pipelines.size();
+
+    // pipelines that saw events in the current batch get one end_batch() each
+    std::vector<uint8_t> touched(sh.pipelines.size(), 0);
+    std::vector<uint32_t> touched_list;
+    touched_list.reserve(sh.pipelines.size());
+    // a pipeline that cannot continue is parked (sh.dead); the other symbols keep running
+    std::vector<uint8_t> &dead = sh.dead;
+    // pipelines with an open conflation window get end_batch() even without events
+    std::vector<uint32_t> held_list;
+    bool running = true;
+
+    auto on_event = [&](DepthEvent &ev) {
+      if (ev.end_of_stream) return running = false;
+      if (ev.symbol >= sh.pipelines.size() || dead[ev.symbol]) return true;
+      Pipeline &p = *sh.pipelines[ev.symbol];
+      bool was_syncing = p.syncing();
+      if (!p.on_event(snaps, ev)) {
+        park(sh, ev.symbol);
+        if (was_syncing && syncing) --syncing;
+        return true;
+      }
+      if (!was_syncing && p.syncing()) ++syncing;
+      if (!touched[ev.symbol]) {
+        touched[ev.symbol] = 1;
+        touched_list.push_back(ev.symbol);
+      }
+      return true;
+    };
+
+    while (running && !stop.load(std::memory_order_relaxed)) {
+      bool poll = syncing || !held_list.empty();
+      size_t n = poll ? sh.queue.try_pop_n(on_event, 256) : sh.queue.pop_n_blocking(on_event, 256);
+      size_t depth = sh.queue.size();
+      for (uint32_t i : held_list) {
+        if (touched[i]) continue;
+        touched[i] = 1;
+        touched_list.push_back(i);
+      }
+      held_list.clear();
+      for (uint32_t i : touched_list) {
+        Pipeline &p = *sh.pipelines[i];
+        p.end_batch(depth);
+        touched[i] = 0;
+        if (p.holding()) held_list.push_back(i);
+      }
+      touched_list.clear();
+      if (sh.stats) {
+        sh.stats->set(stats::QueueDepth, depth);
+        sh.stats->set_max(stats::QueueDepthMax, depth);
+        if (sh.ring) sh.stats->set(stats::Overwrites, ring::ring_evicted(sh.ring));
+      }
+      if (!syncing) {
+        if (n == 0 && !held_list.empty()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        continue;
+      }
+
+      syncing = 0;
+      for (size_t i = 0; i < sh.pipelines.size(); ++i) {
+        Pipeline &p = *sh.pipelines[i];
+        if (dead[i] || !p.syncing()) continue;
+        if (!p.poll(snaps)) {
+          park(sh, i);
+          continue;
+        }
+        if (p.syncing()) ++syncing;
+      }
+      if (syncing && n == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    for (uint32_t i : held_list) sh.pipelines[i]->drain();
+  }
+
+  template class BasicShardEngine<OrderBook>;
+  template class BasicShardEngine<LadderOrderBook>;
+
+} // namespace aether
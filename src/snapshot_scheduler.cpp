@@ -0,0 +1,112 @@
+// snapshot_scheduler.cpp
+#include "snapshot_scheduler.h"
+#include "log.h"
+
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/system/system_error.hpp>
+#include <algorithm>
+#include <exception>
+
+namespace net = boost::asio;
+
+namespace aether {
+
+  SnapshotScheduler::SnapshotScheduler(NetLoop &loop, RestClient &rest, const SnapshotSchedulerConfig &cfg)
+    : loop_(loop), rest_(rest), cfg_(cfg), tokens_(cfg.weight_per_minute), refilled_at_(clock_type::now()) {
+    if (cfg_.weight_per_minute == 0) cfg_.weight_per_minute = 1;
+    if (cfg_.max_in_flight == 0) cfg_.max_in_flight = 1;
+  }
+
+  void SnapshotScheduler::refill(clock_type::time_point now) {
+    double secs = std::chrono::duration<double>(now - refilled_at_).count();
+    refilled_at_ = now;
+    tokens_ = std::min<double>(cfg_.weight_per_minute, tokens_ + secs * cfg_.weight_per_minute / 60.0);
+  }
+
+  void SnapshotScheduler::wake_all() {
+    for (net::steady_timer *w : waiters_) w->cancel();
+  }
+
+  net::awaitable<void> SnapshotScheduler::acquire(uint32_t weight) {
+    auto ex = co_await net::this_coro::executor;
+    auto t0 = clock_type::now();
+    // a request heavier than the whole budget would never go out
+    double need = std::min<double>(weight, cfg_.weight_per_minute);
+    // first come, first served: only the front waiter may take budget and a slot
+    net::steady_timer wake(ex);
+    waiters_.push_back(&wake);
+    struct Leave {
+      SnapshotScheduler &s;
+      net::steady_timer *t;
+      ~Leave() {
+        auto it = std::find(s.waiters_.begin(), s.waiters_.end(), t);
+        if (it == s.waiters_.end()) return;
+        s.waiters_.erase(it);
+        s.wake_all();
+      }
+    } leave{*this, &wake};
+
+    while (true) {
+      if (loop_.cancelled()) throw boost::system::system_error(net::error::operation_aborted);
+      auto now = clock_type::now();
+      refill(now);
+      auto until = clock_type::time_point::max();
+      if (waiters_.front() == &wake && in_flight_ < cfg_.max_in_flight) {
+        if (now < paused_until_) until = paused_until_;
+        else if (tokens_ < need)
+          until = now + std::chrono::duration_cast<clock_type::duration>(
+              std::chrono::duration<double>((need - tokens_) * 60.0 / cfg_.weight_per_minute));
+        else break;
+      }
+      wake.expires_at(until);
+      NetLoop::CancelScope scope(loop_, [&wake] { wake.cancel(); });
+      boost::system::error_code ec;
+      co_await wake.async_wait(net::redirect_error(net::use_awaitable, ec));
+    }
+    tokens_ -= need;
+    ++in_flight_;
+    ++stats_.requests;
+    stats_.weight += weight;
+    stats_.waited_ms += uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - t0).count());
+  }
+
+  net::awaitable<HttpResponse> SnapshotScheduler::send(const std::string &target, uint32_t weight) {
+    HttpResponse res;
+    std::exception_ptr err;
+    try {
+      res = co_await rest_.get(target);
+    } catch (...) {
+      err = std::current_exception();
+    }
+    --in_flight_;
+    wake_all();
+    if (err) std::rethrow_exception(err);
+
+    auto now = clock_type::now();
+    if (res.status == 429 || res.status == 418) {
+      // over the limit (429), or banned for ignoring it (418): everyone waits
+      if (res.status == 429) ++stats_.rate_limited;
+      else ++stats_.banned;
+      backoff_ = backoff_.count() ? std::min(backoff_ * 2, cfg_.max_backoff) : std::chrono::seconds(1);
+      std::chrono::seconds pause = res.retry_after_s ? std::chrono::seconds(res.retry_after_s) : backoff_;
+      paused_until_ = std::max(paused_until_, now + pause);
+      tokens_ = 0;
+      AETHER_LOG_WARN("[snapshots] HTTP {}, pausing snapshot requests for {}s", res.status, pause.count());
+      co_return res;
+    }
+    backoff_ = std::chrono::seconds(0);
+    if (res.used_weight && res.used_weight + weight > cfg_.ip_weight_limit) {
+      // the IP's weight (ours and any other client's) is spent: wait for the next
+      // minute, which is when the exchange resets it
+      auto wall = std::chrono::system_clock::now().time_since_epoch();
+      auto left = std::chrono::minutes(1) - wall % std::chrono::minutes(1);
+      paused_until_ = std::max(paused_until_, now + std::chrono::duration_cast<clock_type::duration>(left));
+      AETHER_LOG_WARN("[snapshots] used weight {} of {}, holding snapshot requests until the next minute",
+          res.used_weight, cfg_.ip_weight_limit);
+    }
+    co_return res;
+  }
+
+} // namespace aether
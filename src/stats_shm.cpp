@@ -0,0 +1,157 @@
+// stats_shm.cpp
+#include "stats_shm.h"
+#include "tsc_clock.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace aether { namespace stats {
+
+  static constexpr size_t HEADER_BYTES = 4096;
+
+  const char *stage_name(Stage s) {
+    switch (s) {
+      case StageDecode: return "decode";
+      case StageQueue: return "queue";
+      case StageApply: return "apply";
+      case StagePublish: return "publish";
+      case StageTotal: return "total";
+      default: return "?";
+    }
+  }
+
+  const char *counter_name(Counter c) {
+    switch (c) {
+      case Frames: return "frames";
+      case Malformed: return "malformed";
+      case Events: return "events";
+      case Stale: return "stale";
+      case Gaps: return "gaps";
+      case Resyncs: return "resyncs";
+      case Drops: return "drops";
+      case Overwrites: return "overwrites";
+      case QueueDepth: return "queue_depth";
+      case QueueDepthMax: return "queue_depth_max";
+      case Checkpoints: return "checkpoints";
+      case Conflated: return "conflated";
+      case Allocs: return "allocs";
+      case QueueWaits: return "queue_waits";
+      default: return "?";
+    }
+  }
+
+  void StatsBlock::snapshot(Stage s, LatencyHistogram &out) const {
+    const SharedHistogram &h = stages[s];
+    std::vector<uint64_t> b(LatencyHistogram::BUCKETS);
+    for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) b[i] = get(h.buckets[i]);
+    out.assign(b.data(), get(h.sum), get(h.min), get(h.max));
+  }
+
+  StatsSegment::~StatsSegment() { close(); }
+
+  bool StatsSegment::create(const std::string &path, size_t max_blocks) {
+    close();
+    static_assert(sizeof(StatsHeader) <= HEADER_BYTES, "StatsHeader must fit its page");
+    size_t size = HEADER_BYTES + max_blocks * sizeof(StatsBlock);
+    // replace rather than reuse: a reader still mapping the old file keeps its copy
+    ::unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+      std::cerr << "[stats] create " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+      std::cerr << "[stats] ftruncate " << path << ": " << strerror(errno) << "\n";
+      ::close(fd);
+      return false;
+    }
+    void *m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+      std::cerr << "[stats] mmap " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    map_ = m;
+    map_size_ = size;
+    writer_ = true;
+    hdr_ = static_cast<StatsHeader*>(m);
+    blocks_ = reinterpret_cast<StatsBlock*>(static_cast<uint8_t*>(m) + HEADER_BYTES);
+    hdr_->pid = uint32_t(getpid());
+    hdr_->max_blocks = uint32_t(max_blocks);
+    hdr_->blocks = 0;
+    hdr_->block_size = uint32_t(sizeof(StatsBlock));
+    hdr_->ticks_per_ns = tsc_ticks_per_ns();
+    hdr_->start_unix_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    hdr_->version = STATS_VERSION;
+    // magic last, as for rings: a reader never sees a half-built header
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr_->magic = STATS_MAGIC;
+    std::cerr << "[stats] " << path << " (" << max_blocks << " blocks, "
+      << hdr_->ticks_per_ns << " ticks/ns)\n";
+    return true;
+  }
+
+  bool StatsSegment::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cerr << "[stats] open " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < HEADER_BYTES) {
+      std::cerr << "[stats] " << path << " is not a stats segment\n";
+      ::close(fd);
+      return false;
+    }
+    void *m = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+      std::cerr << "[stats] mmap " << path << ": " << strerror(errno) << "\n";
+      return false;
+    }
+    map_ = m;
+    map_size_ = size_t(st.st_size);
+    hdr_ = static_cast<StatsHeader*>(m);
+    blocks_ = reinterpret_cast<StatsBlock*>(static_cast<uint8_t*>(m) + HEADER_BYTES);
+    if (hdr_->magic != STATS_MAGIC || hdr_->version != STATS_VERSION || hdr_->block_size != sizeof(StatsBlock)
+        || HEADER_BYTES + size_t(hdr_->max_blocks) * sizeof(StatsBlock) > map_size_) {
+      std::cerr << "[stats] " << path << ": magic, version or layout mismatch\n";
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void StatsSegment::close() {
+    if (map_) munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+    hdr_ = nullptr;
+    blocks_ = nullptr;
+    writer_ = false;
+  }
+
+  StatsBlock *StatsSegment::add_block(const std::string &name) {
+    if (!writer_ || hdr_->blocks >= hdr_->max_blocks) return nullptr;
+    StatsBlock *b = &blocks_[hdr_->blocks];
+    std::strncpy(b->name, name.c_str(), sizeof(b->name) - 1);
+    std::atomic_ref<uint32_t>(hdr_->blocks).fetch_add(1, std::memory_order_release);
+    return b;
+  }
+
+  size_t StatsSegment::blocks() const noexcept {
+    if (!hdr_) return 0;
+    uint32_t n = std::atomic_ref<uint32_t>(hdr_->blocks).load(std::memory_order_acquire);
+    return n < hdr_->max_blocks ? n : hdr_->max_blocks;
+  }
+
+}} // namespace aether::stats
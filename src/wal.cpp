@@ -0,0 +1,395 @@
+// wal.cpp
+#include "wal.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace aether { namespace wal {
+
+  static constexpr uint32_t WAL_MAGIC =
+    (uint32_t('A') << 24) | (uint32_t('W') << 16) |
+    (uint32_t('A') << 8)  | uint32_t('L'); // "AWAL"
+  static constexpr uint16_t WAL_VERSION = 2; // 2: symbol ids in records and index
+  static constexpr size_t WRITE_BUF_BYTES = 1 << 20;
+  static constexpr uint32_t MAX_RECORD_BYTES = 1u << 30;
+
+  static uint32_t fnv1a(const uint8_t *p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 16777619u; }
+    return h;
+  }
+
+  static std::string segment_path(const std::string &dir, uint64_t n, const char *ext) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "wal-%020" PRIu64 ".%s", n, ext);
+    return dir + "/" + name;
+  }
+
+  // sorted segment numbers present in dir
+  static std::vector<uint64_t> list_segments(const std::string &dir) {
+    std::vector<uint64_t> out;
+    DIR *d = opendir(dir.c_str());
+    if (!d) return out;
+    while (struct dirent *e = readdir(d)) {
+      uint64_t n;
+      char tail[8];
+      if (std::sscanf(e->d_name, "wal-%20" SCNu64 ".%7s", &n, tail) == 2 && std::strcmp(tail, "seg") == 0)
+        out.push_back(n);
+    }
+    closedir(d);
+    std::sort(out.begin(), out.end());
+    return out;
+  }
+
+  // bytes written, n unless a write failed
+  static size_t write_all(int fd, const void *p, size_t n) {
+    const uint8_t *b = static_cast<const uint8_t*>(p);
+    size_t done = 0;
+    while (done < n) {
+      ssize_t w = ::write(fd, b + done, n - done);
+      if (w < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      done += size_t(w);
+    }
+    return done;
+  }
+
+  // mkdir -p
+  static bool make_dirs(const std::string &dir) {
+    for (size_t pos = 1; pos <= dir.size(); ++pos) {
+      if (pos != dir.size() && dir[pos] != '/') continue;
+      std::string part = dir.substr(0, pos);
+      if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    }
+    return true;
+  }
+
+  bool parse_durability(const std::string &s, Durability &out) {
+    if (s == "none") { out = Durability::None; return true; }
+    if (s == "periodic") { out = Durability::Periodic; return true; }
+    if (s == "batch") { out = Durability::PerBatch; return true; }
+    return false;
+  }
+
+  // -- writer -------------------------------------------------------------------
+
+  WalWriter::WalWriter(const WalConfig &cfg) : cfg_(cfg), q_(cfg.queue_records) {}
+
+  WalWriter::~WalWriter() { stop(); }
+
+  bool WalWriter::start() {
+    if (started_ || cfg_.dir.empty()) return false;
+    if (!make_dirs(cfg_.dir)) {
+      std::cerr << "[wal] mkdir " << cfg_.dir << " failed: " << strerror(errno) << "\n";
+      return false;
+    }
+    std::vector<uint64_t> segs = list_segments(cfg_.dir);
+    uint64_t first = segs.empty() ? 0 : segs.back() + 1;
+    if (!open_segment(first)) return false;
+    wbuf_.reserve(WRITE_BUF_BYTES + 4096);
+    started_ = true;
+    thread_ = std::thread([this] { run(); });
+    std::cerr << "[wal] writing to " << cfg_.dir << " from segment " << first << "\n";
+    return true;
+  }
+
+  void WalWriter::stop() {
+    if (!started_) return;
+    stop_.store(true, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+    started_ = false;
+    std::cerr << "[wal] stopped: appended=" << appended() << " dropped=" << dropped()
+      << " bytes=" << bytes_written() << "\n";
+  }
+
+  bool WalWriter::append(uint8_t type, uint32_t symbol_id, uint64_t update_id, const void *payload, size_t len) {
+    Slot *s = q_.try_claim();
+    if (!s || len > MAX_RECORD_BYTES) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    s->type = type;
+    s->batch_end = false;
+    s->symbol_id = symbol_id;
+    s->update_id = update_id;
+    const uint8_t *p = static_cast<const uint8_t*>(payload);
+    s->data.assign(p, p + len); // slot keeps its capacity between laps
+    q_.publish();
+    appended_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void WalWriter::end_batch() {
+    if (cfg_.durability != Durability::PerBatch) return;
+    Slot *s = q_.try_claim();
+    if (!s) return; // the writer is behind anyway; the next batch syncs
+    s->batch_end = true;
+    q_.publish();
+  }
+
+  bool WalWriter::open_segment(uint64_t segment_no) {
+    std::string seg = segment_path(cfg_.dir, segment_no, "seg");
+    std::string idx = segment_path(cfg_.dir, segment_no, "idx");
+    seg_fd_ = ::open(seg.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (seg_fd_ < 0) {
+      std::cerr << "[wal] open " << seg << " failed: " << strerror(errno) << "\n";
+      return false;
+    }
+    idx_fd_ = ::open(idx.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (idx_fd_ < 0) {
+      std::cerr << "[wal] open " << idx << " failed: " << strerror(errno) << "\n";
+      ::close(seg_fd_); seg_fd_ = -1;
+      return false;
+    }
+    SegmentHeader h{};
+    h.magic = WAL_MAGIC;
+    h.version = WAL_VERSION;
+    h.segment_no = segment_no;
+    wbuf_.insert(wbuf_.end(), reinterpret_cast<uint8_t*>(&h), reinterpret_cast<uint8_t*>(&h) + sizeof(h));
+    segment_no_ = segment_no;
+    seg_size_ = sizeof(h);
+    roll_ = false;
+    last_index_at_.clear();
+    return true;
+  }
+
+  void WalWriter::close_segment() {
+    if (seg_fd_ < 0) return;
+    if (cfg_.durability == Durability::None) flush_buffer();
+    else sync_now();
+    ::close(seg_fd_);
+    ::close(idx_fd_);
+    seg_fd_ = idx_fd_ = -1;
+  }
+
+  void WalWriter::write_record(const Slot &s) {
+    uint64_t rec = sizeof(RecordHeader) + s.data.size();
+    if ((roll_ || seg_size_ + rec > cfg_.segment_bytes) && seg_size_ > sizeof(SegmentHeader)) {
+      close_segment();
+      if (!open_segment(segment_no_ + 1)) return;
+    }
+    if (seg_fd_ < 0) return;
+    auto at = std::find_if(last_index_at_.begin(), last_index_at_.end(),
+        [&](const auto &e) { return e.first == s.symbol_id; });
+    if (at == last_index_at_.end() || seg_size_ - at->second >= cfg_.index_every_bytes) {
+      ibuf_.push_back(IndexEntry{s.update_id, seg_size_, s.symbol_id, 0});
+      if (at == last_index_at_.end()) last_index_at_.emplace_back(s.symbol_id, seg_size_);
+      else at->second = seg_size_;
+    }
+    RecordHeader h{};
+    h.len = uint32_t(s.data.size());
+    h.checksum = fnv1a(s.data.data(), s.data.size());
+    h.update_id = s.update_id;
+    h.symbol_id = s.symbol_id;
+    h.type = s.type;
+    wbuf_.insert(wbuf_.end(), reinterpret_cast<uint8_t*>(&h), reinterpret_cast<uint8_t*>(&h) + sizeof(h));
+    wbuf_.insert(wbuf_.end(), s.data.begin(), s.data.end());
+    seg_size_ += rec;
+    if (wbuf_.size() >= WRITE_BUF_BYTES) flush_buffer();
+  }
+
+  void WalWriter::flush_buffer() {
+    if (seg_fd_ < 0) return;
+    if (!wbuf_.empty()) {
+      size_t w = write_all(seg_fd_, wbuf_.data(), wbuf_.size());
+      bytes_written_.fetch_add(w, std::memory_order_relaxed);
+      if (w != wbuf_.size()) {
+        // what did land may end in half a record: continue in a new segment, so that
+        // becomes a torn tail readers step over rather than corruption mid-segment
+        std::cerr << "[wal] segment write failed: " << strerror(errno) << "\n";
+        roll_ = true;
+      }
+      wbuf_.clear();
+      dirty_ = true;
+    }
+    if (!ibuf_.empty()) {
+      if (write_all(idx_fd_, ibuf_.data(), ibuf_.size() * sizeof(IndexEntry)) != ibuf_.size() * sizeof(IndexEntry))
+        std::cerr << "[wal] index write failed: " << strerror(errno) << "\n";
+      ibuf_.clear();
+      dirty_ = true;
+    }
+  }
+
+  void WalWriter::sync_now() {
+    flush_buffer();
+    if (!dirty_ || seg_fd_ < 0) return;
+    ::fdatasync(seg_fd_);
+    ::fdatasync(idx_fd_);
+    dirty_ = false;
+  }
+
+  void WalWriter::run() {
+    rt::apply_thread_policy(cfg_.thread, "aether-wal");
+    using clock = std::chrono::steady_clock;
+    auto last_sync = clock::now();
+    const auto interval = std::chrono::milliseconds(cfg_.sync_interval_ms);
+    while (true) {
+      bool batch_end = false;
+      size_t n = q_.try_pop_n([&](Slot &s) {
+          if (s.batch_end) batch_end = true;
+          else write_record(s);
+          return true;
+      }, 256);
+      if (batch_end) sync_now();
+      if (n == 0) {
+        flush_buffer();
+        if (stop_.load(std::memory_order_acquire) && q_.size() == 0) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (cfg_.durability == Durability::Periodic && clock::now() - last_sync >= interval) {
+        sync_now();
+        last_sync = clock::now();
+      }
+    }
+    close_segment();
+  }
+
+  // -- reader -------------------------------------------------------------------
+
+  WalReader::WalReader(const std::string &dir, uint32_t symbol_id)
+    : dir_(dir), symbol_id_(symbol_id), segments_(list_segments(dir)) {}
+
+  WalReader::~WalReader() {
+    if (fp_) std::fclose(fp_);
+  }
+
+  bool WalReader::open_segment(size_t i, uint64_t offset) {
+    if (fp_) { std::fclose(fp_); fp_ = nullptr; }
+    if (i >= segments_.size()) return false;
+    fp_ = std::fopen(segment_path(dir_, segments_[i], "seg").c_str(), "rb");
+    if (!fp_) return false;
+    SegmentHeader h;
+    if (std::fread(&h, sizeof(h), 1, fp_) != 1 || h.magic != WAL_MAGIC || h.version != WAL_VERSION) {
+      std::fclose(fp_); fp_ = nullptr;
+      return false;
+    }
+    cur_ = i;
+    seg_bytes_ = segment_size();
+    if (offset > sizeof(h) && fseeko(fp_, off_t(offset), SEEK_SET) != 0) return false;
+    return true;
+  }
+
+  uint64_t WalReader::segment_size() const {
+    struct stat st;
+    return ::fstat(::fileno(fp_), &st) == 0 ? uint64_t(st.st_size) : 0;
+  }
+
+  // index entries of one symbol (all of them for ANY_SYMBOL); false if ANY_SYMBOL and the
+  // segment indexes several symbols
+  static bool load_index(const std::string &path, uint32_t symbol_id, std::vector<IndexEntry> &out) {
+    out.clear();
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) return true;
+    IndexEntry e;
+    bool ok = true;
+    while (std::fread(&e, sizeof(e), 1, f) == 1) {
+      if (symbol_id == ANY_SYMBOL && !out.empty() && e.symbol_id != out.front().symbol_id) ok = false;
+      if (symbol_id == ANY_SYMBOL || e.symbol_id == symbol_id) out.push_back(e);
+    }
+    std::fclose(f);
+    return ok;
+  }
+
+  bool WalReader::seek(uint64_t u) {
+    has_pending_ = false;
+    eof_ = false;
+    if (segments_.empty()) return false;
+    // last segment whose first indexed record of the symbol is <= u
+    size_t seg = 0;
+    std::vector<IndexEntry> idx, e;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      if (!load_index(segment_path(dir_, segments_[i], "idx"), symbol_id_, e)) {
+        std::cerr << "[wal] " << dir_ << " holds several symbols: seek needs one\n";
+        return false;
+      }
+      if (e.empty()) continue;
+      if (e.front().update_id > u) break;
+      seg = i;
+      idx.swap(e);
+    }
+    uint64_t offset = 0;
+    auto it = std::upper_bound(idx.begin(), idx.end(), u,
+        [](uint64_t v, const IndexEntry &e) { return v < e.update_id; });
+    if (it != idx.begin()) offset = std::prev(it)->offset;
+    if (!open_segment(seg, offset)) return false;
+
+    WalRecord r;
+    while (next(r)) {
+      if (r.update_id >= u) {
+        pending_ = std::move(r);
+        has_pending_ = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool WalReader::next(WalRecord &out) {
+    if (has_pending_) {
+      out = std::move(pending_);
+      has_pending_ = false;
+      return true;
+    }
+    if (eof_) return false;
+    if (!fp_ && !open_segment(0, 0)) { eof_ = true; return false; }
+    // A record cut short or garbled at the very end of a segment is a torn tail: the
+    // writer died (or a write failed) mid-record, and whatever came after went to a new
+    // segment. Step over it; only a bad record with more log behind it in the same
+    // segment ends the read.
+    auto torn_tail = [&] {
+      std::cerr << "[wal] torn record at the end of segment " << segments_[cur_] << ", skipped\n";
+      return open_segment(cur_ + 1, 0);
+    };
+    while (true) {
+      RecordHeader h;
+      uint64_t at = uint64_t(ftello(fp_));
+      if (std::fread(&h, sizeof(h), 1, fp_) != 1) {
+        // end of the segment (or half a header: a torn tail too)
+        bool more = at < seg_bytes_ ? torn_tail() : open_segment(cur_ + 1, 0);
+        if (!more) { eof_ = true; return false; } // end of log
+        continue;
+      }
+      uint64_t end = at + sizeof(h) + h.len;
+      if (end > seg_bytes_) seg_bytes_ = segment_size();   // a live writer's segment grows
+      if (h.len > MAX_RECORD_BYTES || end > seg_bytes_) {
+        if (end < seg_bytes_) {
+          std::cerr << "[wal] bad record length in segment " << segments_[cur_] << "\n";
+          return false;
+        }
+        if (!torn_tail()) { eof_ = true; return false; }
+        continue;
+      }
+      if (symbol_id_ != ANY_SYMBOL && h.symbol_id != symbol_id_) {
+        if (fseeko(fp_, off_t(h.len), SEEK_CUR) != 0) return false;
+        continue;
+      }
+      out.type = h.type;
+      out.symbol_id = h.symbol_id;
+      out.update_id = h.update_id;
+      out.payload.resize(h.len);
+      if (h.len && std::fread(out.payload.data(), h.len, 1, fp_) != 1) return false;
+      if (fnv1a(out.payload.data(), h.len) != h.checksum) {
+        if (end < seg_bytes_) {
+          std::cerr << "[wal] checksum mismatch in segment " << segments_[cur_] << "\n";
+          return false;
+        }
+        if (!torn_tail()) { eof_ = true; return false; }
+        continue;
+      }
+      return true;
+    }
+  }
+
+}} // namespace aether::wal
@@ -1,80 +1,207 @@
 // ws_client.cpp
 #include "ws_client.h"
+#include "alloc_count.h"
+#include "feed_source.h"
+#include "log.h"
+#include "tsc_clock.h"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
 #include <boost/beast/ssl.hpp>
-#include <boost/asio/ssl.hpp>
 #include <boost/asio/ip/tcp.hpp>
-#include <nlohmann/json.hpp>
-#include <iostream>
+#include <openssl/ssl.h>
 
 namespace beast = boost::beast;
 namespace websocket = boost::beast::websocket;
-namespace ssl = boost::asio::ssl;
 namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
-using json = nlohmann::json;
 
-static uint64_t mono_now_us() {
-  using namespace std::chrono;
-  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
-      std::chrono::steady_clock::now().time_since_epoch()).count();
-}
+namespace aether {
 
-std::thread start_ws_reader(const std::string &symbol,
-    const std::string &updateSpeed,
-    EventQueue &queue,
-    std::atomic<bool> &stopFlag) {
-  return std::thread([symbol, updateSpeed, &queue, &stopFlag] {
-      try {
-      net::io_context ioc;
-      ssl::context ctx{ssl::context::tlsv12_client};
-      ctx.set_verify_mode(ssl::verify_none); // production: enable verify
+  static uint64_t mono_now_us() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
 
-      tcp::resolver resolver{ioc};
-      websocket::stream<beast::ssl_stream<tcp::socket>> ws{ioc, ctx};
+  // how long a session sleeps before it looks at a full shard queue again
+  static constexpr auto QUEUE_FULL_WAIT = std::chrono::microseconds(500);
 
-      std::string host = "stream.binance.com";
-      std::string port = "9443";
-      std::string path = "/ws/" + symbol + "@depth";
-      if (!updateSpeed.empty() && updateSpeed == "100ms")
-      path = "/ws/" + symbol + "@depth@100ms";
+  // Waits for a free slot in queue. Only the calling session is suspended: the loop keeps
+  // serving every other stream, REST request and timer meanwhile. false if stopped or
+  // cancelled first.
+  static net::awaitable<bool> wait_for_slot(NetLoop &loop, EventQueue &queue, const std::atomic<bool> &stopFlag,
+      stats::StatsBlock *stats) {
+    if (stats) stats->add(stats::QueueWaits);
+    net::steady_timer wait(co_await net::this_coro::executor);
+    while (!queue.try_claim()) {
+      if (stopFlag.load() || loop.cancelled()) co_return false;
+      wait.expires_after(QUEUE_FULL_WAIT);
+      boost::system::error_code ec;
+      co_await wait.async_wait(net::redirect_error(net::use_awaitable, ec));
+    }
+    co_return true;
+  }
 
-      auto const results = resolver.resolve(host, port);
-      boost::asio::connect(ws.next_layer().next_layer(), results);
-      ws.next_layer().handshake(ssl::stream_base::client);
-      ws.handshake(host, path);
+  // hands every frame to on_frame(data, len, recv_us, recv_tsc) until the connection
+  // ends or it is stopped. on_frame returns the queue it found full (before doing
+  // anything with the frame), and gets the same frame again once that queue has room.
+  template <class WsStream, class OnFrame>
+  static net::awaitable<void> read_frames(NetLoop &loop, WsStream &ws, const Endpoint &ep, const std::string &path,
+      const std::atomic<bool> &stopFlag, stats::StatsBlock *stats, OnFrame &on_frame) {
+    // the tcp timeout covered connect and TLS; from here the websocket's own timeouts apply
+    beast::get_lowest_layer(ws).expires_never();
+    websocket::stream_base::timeout opt = websocket::stream_base::timeout::suggested(beast::role_type::client);
+    opt.idle_timeout = std::chrono::seconds(30);
+    opt.keep_alive_pings = true;
+    ws.set_option(opt);
+    co_await ws.async_handshake(ep.host, path, net::use_awaitable);
 
-      beast::flat_buffer buffer;
-      size_t counter = 0;
-
-      while (!stopFlag.load()) {
-        buffer.clear();
-        beast::error_code ec;
-        ws.read(buffer, ec);
-        if (ec) {
-          std::cerr << "[ws_reader] read error: " << ec.message() << "\n";
+    beast::flat_buffer buffer;
+    bool stopped = false;
+    while (!stopped) {
+      buffer.clear();
+      co_await ws.async_read(buffer, net::use_awaitable);
+      uint64_t recv_tsc = tsc_now();
+      uint64_t now_us = mono_now_us();
+      auto cb = buffer.cdata();
+      while (EventQueue *full = on_frame(static_cast<const char*>(cb.data()), cb.size(), now_us, recv_tsc)) {
+        if (!co_await wait_for_slot(loop, *full, stopFlag, stats)) {
+          stopped = true;
           break;
         }
-        std::string msg = beast::buffers_to_string(buffer.data());
-        uint64_t now_us = mono_now_us();
-        // std::cerr << "[ws_reader] raw: " << msg << "\n";
-        try {
-          json j = json::parse(msg);
-          if (j.contains("e") && j["e"] == "depthUpdate") {
-            queue.push(JsonEvent{std::move(j), now_us});
-            if (++counter % 10000 == 0) {
-              std::cerr << "[ws_reader] received " << counter << " depth events\n";
-            }
-          }
-        } catch (const std::exception &ex) {
-          std::cerr << "[ws_reader] JSON parse error: " << ex.what() << "\n";
-        }
       }
-      beast::error_code ec2;
-      ws.close(websocket::close_code::normal, ec2);
-      } catch (const std::exception &ex) {
-        std::cerr << "[ws_reader] exception: " << ex.what() << "\n";
+    }
+    beast::get_lowest_layer(ws).close();
+  }
+
+  template <class OnFrame>
+  static net::awaitable<void> ws_session(NetLoop &loop, Endpoint ep, std::string path,
+      const std::atomic<bool> &stopFlag, stats::StatsBlock *stats, OnFrame on_frame) {
+    auto ex = co_await net::this_coro::executor;
+    tcp::resolver resolver{ex};
+    try {
+      if (!ep.tls) {
+        websocket::stream<beast::tcp_stream> ws{ex};
+        NetLoop::CancelScope scope(loop, [&] { resolver.cancel(); beast::get_lowest_layer(ws).close(); });
+        auto const results = co_await resolver.async_resolve(ep.host, ep.port, net::use_awaitable);
+        beast::get_lowest_layer(ws).expires_after(std::chrono::seconds(10));
+        co_await beast::get_lowest_layer(ws).async_connect(results, net::use_awaitable);
+        co_await read_frames(loop, ws, ep, path, stopFlag, stats, on_frame);
+      } else {
+        websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws{ex, loop.tls()};
+        NetLoop::CancelScope scope(loop, [&] { resolver.cancel(); beast::get_lowest_layer(ws).close(); });
+        auto const results = co_await resolver.async_resolve(ep.host, ep.port, net::use_awaitable);
+        beast::get_lowest_layer(ws).expires_after(std::chrono::seconds(10));
+        co_await beast::get_lowest_layer(ws).async_connect(results, net::use_awaitable);
+        SSL_set_tlsext_host_name(ws.next_layer().native_handle(), ep.host.c_str());
+        co_await ws.next_layer().async_handshake(net::ssl::stream_base::client, net::use_awaitable);
+        co_await read_frames(loop, ws, ep, path, stopFlag, stats, on_frame);
+      }
+    } catch (const boost::system::system_error &e) {
+      if (e.code() == net::error::operation_aborted) AETHER_LOG_INFO("[ws_reader] cancelled");
+      else AETHER_LOG_WARN("[ws_reader] {}{}: {}", ep.host, path, e.code().message());
+    } catch (const std::exception &e) {
+      AETHER_LOG_ERROR("[ws_reader] exception: {}", e.what());
+    }
+  }
+
+  // decode straight from the (contiguous) frame buffer into the claimed queue slot ev
+  static DecodeStatus decode_into(EventQueue &queue, DepthEvent *ev, const char *data, size_t len,
+      uint64_t now_us, uint64_t recv_tsc, const DecimalScale &scale, uint32_t symbol, stats::StatsBlock *stats) {
+    uint64_t a0 = mem::thread_allocs();
+    DecodeStatus st = decode_depth_update(data, len, ev->delta, scale);
+    if (mem::counting && stats && mem::thread_allocs() != a0) stats->add(stats::Allocs, mem::thread_allocs() - a0);
+    if (st == DecodeStatus::Ok) {
+      ev->decoded_tsc = tsc_now();
+      ev->recv_tsc = recv_tsc;
+      ev->local_recv_ts_us = now_us;
+      ev->symbol = symbol;
+      ev->end_of_stream = false;
+      queue.publish();
+    }
+    return st;
+  }
+
+  std::future<void> spawn_ws_reader(NetLoop &loop, const Endpoint &ep,
+      const std::string &symbol,
+      const std::string &updateSpeed,
+      const DecimalScale &scale,
+      EventQueue &queue,
+      std::atomic<bool> &stopFlag,
+      CaptureChannel *capture,
+      stats::StatsBlock *stats) {
+    std::string path = "/ws/" + symbol + "@depth";
+    if (updateSpeed == "100ms") path += "@100ms";
+    auto session = [&loop, ep, path, scale, &queue, &stopFlag, capture, stats]() -> net::awaitable<void> {
+      size_t counter = 0;
+      co_await ws_session(loop, ep, path, stopFlag, stats,
+          [&](const char *data, size_t len, uint64_t now_us, uint64_t recv_tsc) -> EventQueue* {
+          DepthEvent *ev = queue.try_claim();
+          if (!ev) return &queue;
+          if (capture) capture->record(FeedRecord::WsFrame, now_us, data, len);
+          if (stats) stats->add(stats::Frames);
+          DecodeStatus st = decode_into(queue, ev, data, len, now_us, recv_tsc, scale, 0, stats);
+          if (st == DecodeStatus::Ok) {
+            if (++counter % 10000 == 0)
+              AETHER_LOG_INFO("[ws_reader] received {} depth events", counter);
+          } else if (st == DecodeStatus::Malformed) {
+            if (stats) stats->add(stats::Malformed);
+            AETHER_LOG_EVERY(log::Warn, 10, "[ws_reader] malformed depthUpdate frame ({} bytes)", len);
+          }
+          return nullptr;
+      });
+      // wake the book thread if it is blocked on the queue
+      if (!queue.try_claim()) co_await wait_for_slot(loop, queue, stopFlag, nullptr);
+      push_end_of_stream(queue, stopFlag);
+    };
+    return net::co_spawn(loop.context(), session, net::use_future);
+  }
+
+  std::future<void> spawn_combined_ws_reader(NetLoop &loop, const Endpoint &ep,
+      const std::vector<std::string> &symbols,
+      const std::string &updateSpeed,
+      const SymbolRouter &router,
+      std::atomic<bool> &stopFlag,
+      CaptureChannel *capture,
+      stats::StatsBlock *stats) {
+    std::string path = "/stream?streams=";
+    for (size_t i = 0; i < symbols.size(); ++i) {
+      if (i) path += "/";
+      path += symbols[i] + "@depth";
+      if (updateSpeed == "100ms") path += "@100ms";
+    }
+    auto session = [&loop, ep, path, &router, &stopFlag, capture, stats]() -> net::awaitable<void> {
+      size_t counter = 0;
+      co_await ws_session(loop, ep, path, stopFlag, stats,
+          [&](const char *data, size_t len, uint64_t now_us, uint64_t recv_tsc) -> EventQueue* {
+          const SymbolRoute *route = router.find(depth_frame_symbol(data, len));
+          DepthEvent *ev = nullptr;
+          if (route && !(ev = route->queue->try_claim())) return route->queue;
+          if (capture) capture->record(FeedRecord::WsFrame, now_us, data, len);
+          if (stats) stats->add(stats::Frames);
+          if (!route) return nullptr; // not a depth frame, or a symbol we do not book
+          DecodeStatus st = decode_into(*route->queue, ev, data, len, now_us, recv_tsc, route->scale, route->index, stats);
+          if (st == DecodeStatus::Ok) {
+            if (++counter % 10000 == 0)
+              AETHER_LOG_INFO("[ws_reader] received {} depth events", counter);
+          } else if (st == DecodeStatus::Malformed) {
+            if (stats) stats->add(stats::Malformed);
+            AETHER_LOG_EVERY(log::Warn, 10, "[ws_reader] malformed {} depthUpdate frame ({} bytes)", route->symbol, len);
+          }
+          return nullptr;
+      });
+      // wake every shard thread blocked on its queue
+      for (EventQueue *q : router.queues()) {
+        if (!q->try_claim()) co_await wait_for_slot(loop, *q, stopFlag, nullptr);
+        push_end_of_stream(*q, stopFlag);
       }
-  });
-}
+    };
+    return net::co_spawn(loop.context(), session, net::use_future);
+  }
+
+} // namespace aether
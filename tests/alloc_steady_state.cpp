@@ -0,0 +1,103 @@
+// alloc_steady_state.cpp
+// Zero-allocation check of the hot path (ctest alloc_steady_state). A synthetic feed
+// with one injected gap goes through ReplayFeed and the pipeline on a small queue, so
+// every slot comes round many times, also after the bootstrap and the resync buffer
+// have handled it. After the warm-up neither decoding nor the book's live apply may
+// call operator new. Built against a core with AETHER_COUNT_ALLOCS.
+#include "alloc_count.h"
+#include "log.h"
+#include "pipeline.h"
+#include "replay_feed.h"
+#include "synthetic_market.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace aether;
+
+static_assert(mem::counting, "alloc_steady_state needs AETHER_COUNT_ALLOCS");
+
+static constexpr size_t QUEUE_SLOTS = 1024;
+static constexpr size_t PREWARM_LEVELS = 64;   // levels_per_msg + what a mid move removes
+static constexpr size_t BOOK_RESERVE = 8192;
+static constexpr uint64_t FRAMES = 40000;
+static constexpr uint64_t GAP_AT = 20000;
+static constexpr uint64_t WARMUP = 4 * QUEUE_SLOTS;
+
+// exchangeInfo, a snapshot after the first frames, and a second one right after the
+// frame that follows the gap (the resync's)
+static std::vector<FeedRecord> make_feed() {
+  SyntheticConfig cfg;
+  cfg.book_levels = 500;
+  SyntheticMarket market(cfg, {"BTCUSDT"});
+  int reader = market.attach();
+  std::vector<FeedRecord> out;
+  auto add = [&](FeedRecord::Kind kind, std::string body) {
+    FeedRecord r;
+    r.kind = kind;
+    r.body = std::move(body);
+    out.push_back(std::move(r));
+  };
+  add(FeedRecord::ExchangeInfo, market.exchange_info());
+  for (uint64_t i = 1; i <= FRAMES; ++i) {
+    if (i == GAP_AT) market.inject(Fault::Gap);
+    size_t n = market.next(reader, 0, 1700000000000 + i, false);
+    for (size_t k = 0; k < n; ++k) add(FeedRecord::WsFrame, market.frame(k));
+    if (i == 20 || i == GAP_AT + 1) add(FeedRecord::Snapshot, market.snapshot(0, 5000));
+  }
+  return out;
+}
+
+template <class Book>
+static bool run(const char *name) {
+  ReplayFeed feed(make_feed(), ReplayPace::Fast);
+  DecimalScale scale;
+  if (!scale_from_exchange_info(feed.exchange_info(), scale)) {
+    std::fprintf(stderr, "%s: exchangeInfo unusable\n", name);
+    return false;
+  }
+  EventQueue queue(QUEUE_SLOTS);
+  queue.prewarm(PREWARM_LEVELS);
+  PipelineConfig pcfg;
+  pcfg.symbol = "BTCUSDT";
+  pcfg.verbose = false;
+  pcfg.prewarm_levels = PREWARM_LEVELS;
+  pcfg.book_reserve_levels = BOOK_RESERVE;
+  BasicPipeline<Book> pipeline(pcfg, scale);
+
+  std::atomic<bool> stop{false};
+  feed.start(scale, queue, stop);
+  BootstrapStatus bs = pipeline.bootstrap(feed, queue);
+  RunStatus rs = bs == BootstrapStatus::Ok ? pipeline.run(feed, queue, stop) : RunStatus::Gap;
+  stop.store(true);
+  feed.join();
+
+  const PipelineStats &st = pipeline.stats();
+  std::printf("%s: frames=%llu applied=%llu resyncs=%llu decode allocs=%llu (last at frame %llu)"
+      " book allocs=%llu (last at event %llu)\n", name,
+      (unsigned long long)feed.frames(), (unsigned long long)st.applied, (unsigned long long)st.resyncs,
+      (unsigned long long)feed.decode_allocs(), (unsigned long long)feed.last_decode_alloc(),
+      (unsigned long long)st.allocs, (unsigned long long)st.last_alloc_event);
+  bool ok = true;
+  if (bs != BootstrapStatus::Ok || rs != RunStatus::EndOfStream || st.resyncs != 1) {
+    std::fprintf(stderr, "%s: feed did not replay as built (bootstrap, one resync, end of stream)\n", name);
+    ok = false;
+  }
+  if (feed.last_decode_alloc() > WARMUP || st.last_alloc_event > WARMUP) {
+    std::fprintf(stderr, "%s: FAILED, allocations after the first %llu events\n", name,
+        (unsigned long long)WARMUP);
+    ok = false;
+  }
+  return ok;
+}
+
+int main() {
+  log::Config log_cfg;
+  log_cfg.level = log::Warn;
+  if (!log::start(log_cfg)) return 1;
+  bool ok = run<OrderBook>("map");
+  ok = run<LadderOrderBook>("ladder") && ok;
+  log::stop();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,365 @@
+// aether_standin.cpp
+// Local stand-in for the exchange endpoints over plain WS/HTTP on one port. Point
+// aether at it with --ws-url=ws://127.0.0.1:PORT --rest-url=http://127.0.0.1:PORT.
+//
+// With a recording, WS upgrades on any path stream the recorded frames, GET
+// /api/v3/depth returns the recorded snapshots in turn and GET /api/v3/exchangeInfo the
+// recorded exchangeInfo.
+//
+// With --synthetic=SYMBOLS, the books come from a seeded random walk (synthetic_market.h).
+// A WS upgrade on /ws/SYM@depth or /stream?streams=a@depth/b@depth streams updates of
+// those symbols round-robin at --rate per second (0 = as fast as the client reads), and
+// GET /api/v3/depth?symbol=SYM[&limit=N] returns the current book. Clients on the same
+// symbol all get the same stream, each at its own pace. Faults are injected every N-th
+// frame (--gap-every, --dup-every, --reorder-every) or on demand with
+// GET /standin/inject?fault=gap|dup|reorder[&symbol=SYM]. --weight-limit=N answers depth
+// requests past N request weight per minute with 429 and Retry-After, like the exchange.
+// Usage: aether_standin RECORDING [--port=8765] [--pace=fast|recorded] [--speed=X]
+//        aether_standin --synthetic=BTCUSDT,ETHUSDT [--port=8765] [--seed=N] [--rate=N]
+//          [--levels=N] [--book-levels=N] [--messages=N] [--gap-every=N] [--dup-every=N]
+//          [--reorder-every=N] [--weight-limit=N]
+#include "feed_source.h"
+#include "replay_feed.h"
+#include "synthetic_market.h"
+
+#include <utility> // Boost 1.74's awaitable.hpp needs std::exchange
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace websocket = boost::beast::websocket;
+namespace net = boost::asio;
+using tcp = boost::asio::ip::tcp;
+using aether::FeedRecord;
+
+struct Recording {
+  std::vector<const FeedRecord*> frames;
+  std::vector<const FeedRecord*> snapshots;
+  const FeedRecord *exchange_info = nullptr;
+  size_t next_snapshot = 0;
+  bool paced = false;
+  double speed = 1.0;
+};
+
+struct Synthetic {
+  std::unique_ptr<aether::SyntheticMarket> market;
+  double rate = 0;          // updates per second per connection (0 = unpaced)
+  uint64_t messages = 0;    // close a stream after this many updates (0 = never)
+  uint32_t weight_limit = 0; // depth request weight per minute before 429 (0 = unlimited)
+  uint32_t weight_used = 0;
+  int64_t weight_minute = -1;
+};
+
+struct Standin {
+  Recording rec;
+  Synthetic syn;
+};
+
+// value of key in the target's query string, "" if absent
+static std::string query_param(std::string_view target, std::string_view key) {
+  size_t q = target.find('?');
+  if (q == std::string_view::npos) return std::string();
+  std::string_view qs = target.substr(q + 1);
+  while (!qs.empty()) {
+    size_t amp = qs.find('&');
+    std::string_view kv = qs.substr(0, amp);
+    if (kv.size() > key.size() && kv.substr(0, key.size()) == key && kv[key.size()] == '=')
+      return std::string(kv.substr(key.size() + 1));
+    if (amp == std::string_view::npos) break;
+    qs.remove_prefix(amp + 1);
+  }
+  return std::string();
+}
+
+// "/ws/btcusdt@depth@100ms" -> one raw stream, "/stream?streams=a@depth/b@depth" ->
+// combined; false if a stream names a symbol the market does not simulate
+static bool parse_streams(std::string_view target, const aether::SyntheticMarket &market,
+    std::vector<size_t> &symbols, bool &combined) {
+  std::string_view list;
+  std::string streams = query_param(target, "streams");
+  combined = target.rfind("/stream", 0) == 0;
+  if (combined) list = streams;
+  else if (target.rfind("/ws/", 0) == 0) list = target.substr(4);
+  while (!list.empty()) {
+    size_t slash = list.find('/');
+    std::string_view stream = list.substr(0, slash);
+    int i = market.find(stream.substr(0, stream.find('@')));
+    if (i < 0) return false;
+    symbols.push_back(size_t(i));
+    if (slash == std::string_view::npos) break;
+    list.remove_prefix(slash + 1);
+  }
+  return !symbols.empty();
+}
+
+static net::awaitable<void> stream_frames(websocket::stream<beast::tcp_stream> ws, Recording &rec) {
+  net::steady_timer timer(ws.get_executor());
+  auto start = std::chrono::steady_clock::now();
+  uint64_t base_us = rec.frames.empty() ? 0 : rec.frames.front()->recv_us;
+  size_t sent = 0;
+  for (const FeedRecord *r : rec.frames) {
+    if (rec.paced && r->recv_us > base_us) {
+      auto due = start + std::chrono::microseconds(uint64_t(double(r->recv_us - base_us) / rec.speed));
+      if (due > std::chrono::steady_clock::now()) {
+        timer.expires_at(due);
+        co_await timer.async_wait(net::use_awaitable);
+      }
+    }
+    ws.text(true);
+    co_await ws.async_write(net::buffer(r->body), net::use_awaitable);
+    ++sent;
+  }
+  std::cerr << "[standin] ws client done, " << sent << " frames\n";
+  co_await ws.async_close(websocket::close_code::normal, net::use_awaitable);
+}
+
+static net::awaitable<void> stream_synthetic(websocket::stream<beast::tcp_stream> ws, Synthetic &syn,
+    std::vector<size_t> symbols, bool combined) {
+  net::steady_timer timer(ws.get_executor());
+  auto start = std::chrono::steady_clock::now();
+  // this connection's position in the symbols' streams, released however the loop ends
+  struct Reader {
+    aether::SyntheticMarket &market;
+    int id;
+    ~Reader() { market.detach(id); }
+  } reader{*syn.market, syn.market->attach()};
+  // the market's frames are overwritten by other connections while a write is pending
+  std::string frames[2];
+  uint64_t updates = 0, sent = 0;
+  ws.text(true);
+  while (!syn.messages || updates < syn.messages) {
+    if (syn.rate > 0) {
+      // sleep only when a millisecond or more ahead; higher rates go out in bursts
+      auto due = start + std::chrono::nanoseconds(uint64_t(double(updates) * 1e9 / syn.rate));
+      if (due - std::chrono::steady_clock::now() >= std::chrono::milliseconds(1)) {
+        timer.expires_at(due);
+        co_await timer.async_wait(net::use_awaitable);
+      }
+    }
+    uint64_t now_ms = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count());
+    size_t n = syn.market->next(reader.id, symbols[updates % symbols.size()], now_ms, combined);
+    ++updates;
+    for (size_t k = 0; k < n; ++k) frames[k] = syn.market->frame(k);
+    for (size_t k = 0; k < n; ++k) {
+      co_await ws.async_write(net::buffer(frames[k]), net::use_awaitable);
+      ++sent;
+    }
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cerr << "[standin] ws client done, " << updates << " updates, " << sent << " frames in " << secs
+    << "s\n";
+  co_await ws.async_close(websocket::close_code::normal, net::use_awaitable);
+}
+
+// per-minute request weight as the exchange counts it; false (with Retry-After) if over
+static bool charge_weight(Synthetic &syn, uint32_t weight, http::response<http::string_body> &res) {
+  if (!syn.weight_limit) return true;
+  auto wall = std::chrono::system_clock::now().time_since_epoch();
+  int64_t minute = std::chrono::duration_cast<std::chrono::minutes>(wall).count();
+  if (minute != syn.weight_minute) {
+    syn.weight_minute = minute;
+    syn.weight_used = 0;
+  }
+  syn.weight_used += weight;
+  res.set("X-MBX-USED-WEIGHT-1M", std::to_string(syn.weight_used));
+  if (syn.weight_used <= syn.weight_limit) return true;
+  auto left = std::chrono::minutes(1) - wall % std::chrono::minutes(1);
+  res.set(http::field::retry_after, std::to_string(std::chrono::duration_cast<std::chrono::seconds>(left).count() + 1));
+  return false;
+}
+
+static void synthetic_response(const std::string &target, Synthetic &syn, http::response<http::string_body> &res) {
+  aether::SyntheticMarket &m = *syn.market;
+  std::string symbol = query_param(target, "symbol");
+  int i = symbol.empty() ? -1 : m.find(symbol);
+  if (!symbol.empty() && i < 0) {
+    res.result(http::status::bad_request);
+    res.body() = "{\"code\":-1121,\"msg\":\"Invalid symbol.\"}";
+  } else if (target.rfind("/api/v3/depth", 0) == 0 && i >= 0) {
+    std::string limit = query_param(target, "limit");
+    size_t n = 100;
+    auto r = std::from_chars(limit.data(), limit.data() + limit.size(), n);
+    if (!limit.empty() && (r.ec != std::errc() || r.ptr != limit.data() + limit.size() || n == 0 || n > 5000)) {
+      res.result(http::status::bad_request);
+      res.body() = "{\"code\":-1100,\"msg\":\"Illegal characters found in parameter 'limit'; legal range is 1-5000.\"}";
+    } else if (!charge_weight(syn, aether::depth_request_weight(uint32_t(n)), res)) {
+      res.result(http::status::too_many_requests);
+      res.body() = "{\"code\":-1003,\"msg\":\"Too much request weight used.\"}";
+    } else {
+      res.body() = m.snapshot(size_t(i), n);
+    }
+  } else if (target.rfind("/api/v3/exchangeInfo", 0) == 0) {
+    res.body() = m.exchange_info(i);
+  } else if (target.rfind("/standin/inject", 0) == 0) {
+    aether::Fault f;
+    if (!aether::parse_fault(query_param(target, "fault"), f)) {
+      res.result(http::status::bad_request);
+      res.body() = "{\"msg\":\"fault=gap|dup|reorder\"}";
+    } else {
+      m.inject(f, i);
+      res.body() = "{\"ok\":true}";
+    }
+  } else {
+    res.result(http::status::not_found);
+    res.body() = "{\"code\":-1,\"msg\":\"not simulated\"}";
+  }
+}
+
+static net::awaitable<void> serve(tcp::socket socket, Standin &st) {
+  Recording &rec = st.rec;
+  beast::tcp_stream stream(std::move(socket));
+  beast::flat_buffer buffer;
+  try {
+    while (true) {
+      http::request<http::string_body> req;
+      co_await http::async_read(stream, buffer, req, net::use_awaitable);
+      if (websocket::is_upgrade(req)) {
+        websocket::stream<beast::tcp_stream> ws(std::move(stream));
+        co_await ws.async_accept(req, net::use_awaitable);
+        std::cerr << "[standin] ws client on " << req.target() << "\n";
+        if (!st.syn.market) {
+          co_await stream_frames(std::move(ws), rec);
+          co_return;
+        }
+        std::vector<size_t> symbols;
+        bool combined = false;
+        if (!parse_streams(std::string(req.target()), *st.syn.market, symbols, combined)) {
+          std::cerr << "[standin] no simulated symbol in " << req.target() << "\n";
+          co_await ws.async_close(websocket::close_code::policy_error, net::use_awaitable);
+          co_return;
+        }
+        co_await stream_synthetic(std::move(ws), st.syn, std::move(symbols), combined);
+        co_return;
+      }
+
+      http::response<http::string_body> res{http::status::ok, req.version()};
+      res.set(http::field::content_type, "application/json");
+      res.keep_alive(req.keep_alive());
+      std::string target(req.target());
+      if (st.syn.market) {
+        synthetic_response(target, st.syn, res);
+      } else if (target.rfind("/api/v3/depth", 0) == 0 && !rec.snapshots.empty()) {
+        size_t i = std::min(rec.next_snapshot++, rec.snapshots.size() - 1);
+        res.body() = rec.snapshots[i]->body;
+      } else if (target.rfind("/api/v3/exchangeInfo", 0) == 0 && rec.exchange_info) {
+        res.body() = rec.exchange_info->body;
+      } else {
+        res.result(http::status::not_found);
+        res.body() = "{\"code\":-1,\"msg\":\"not recorded\"}";
+      }
+      std::cerr << "[standin] GET " << target << " -> " << res.result_int() << "\n";
+      res.prepare_payload();
+      co_await http::async_write(stream, res, net::use_awaitable);
+      if (!res.keep_alive()) break;
+    }
+  } catch (const boost::system::system_error &e) {
+    if (e.code() != http::error::end_of_stream && e.code() != net::error::eof)
+      std::cerr << "[standin] connection: " << e.code().message() << "\n";
+  }
+  beast::error_code ec;
+  stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+}
+
+static net::awaitable<void> listen(tcp::acceptor &acceptor, Standin &st) {
+  while (true) {
+    tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+    net::co_spawn(acceptor.get_executor(), serve(std::move(socket), st), net::detached);
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned short port = 8765;
+  Standin st;
+  Recording &rec = st.rec;
+  std::string path, symbols;
+  aether::SyntheticConfig scfg;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a.rfind("--port=", 0) == 0) port = (unsigned short)std::stoul(a.substr(7));
+    else if (a == "--pace=recorded") rec.paced = true;
+    else if (a == "--pace=fast") rec.paced = false;
+    else if (a.rfind("--speed=", 0) == 0) rec.speed = std::stod(a.substr(8));
+    else if (a.rfind("--synthetic=", 0) == 0) symbols = a.substr(12);
+    else if (a.rfind("--seed=", 0) == 0) scfg.seed = std::stoull(a.substr(7));
+    else if (a.rfind("--rate=", 0) == 0) st.syn.rate = std::stod(a.substr(7));
+    else if (a.rfind("--levels=", 0) == 0) scfg.levels_per_msg = uint32_t(std::stoul(a.substr(9)));
+    else if (a.rfind("--book-levels=", 0) == 0) scfg.book_levels = uint32_t(std::stoul(a.substr(14)));
+    else if (a.rfind("--messages=", 0) == 0) st.syn.messages = std::stoull(a.substr(11));
+    else if (a.rfind("--gap-every=", 0) == 0) scfg.gap_every = std::stoull(a.substr(12));
+    else if (a.rfind("--dup-every=", 0) == 0) scfg.dup_every = std::stoull(a.substr(12));
+    else if (a.rfind("--reorder-every=", 0) == 0) scfg.reorder_every = std::stoull(a.substr(16));
+    else if (a.rfind("--weight-limit=", 0) == 0) st.syn.weight_limit = uint32_t(std::stoul(a.substr(15)));
+    else if (a.rfind("--", 0) != 0 && path.empty()) path = a;
+    else {
+      std::cerr << "unknown option " << a << "\n";
+      return 1;
+    }
+  }
+  if (path.empty() == symbols.empty()) {
+    std::cerr << "usage: " << argv[0] << " RECORDING [--port=8765] [--pace=fast|recorded] [--speed=X]\n"
+      << "       " << argv[0] << " --synthetic=BTCUSDT,ETHUSDT [--port=8765] [--seed=N] [--rate=N]"
+      << " [--levels=N] [--book-levels=N] [--messages=N] [--gap-every=N] [--dup-every=N] [--reorder-every=N]"
+      << " [--weight-limit=N]\n";
+    return 1;
+  }
+  if (rec.speed <= 0) rec.speed = 1.0;
+
+  std::vector<FeedRecord> records;
+  if (!symbols.empty()) {
+    std::vector<std::string> list;
+    for (size_t b = 0; b <= symbols.size();) {
+      size_t e = symbols.find(',', b);
+      if (e == std::string::npos) e = symbols.size();
+      if (e > b) list.push_back(symbols.substr(b, e - b));
+      b = e + 1;
+    }
+    st.syn.market = std::make_unique<aether::SyntheticMarket>(scfg, list);
+  } else {
+    if (!aether::load_feed(path, records)) {
+      std::cerr << "cannot read " << path << "\n";
+      return 1;
+    }
+    for (const FeedRecord &r : records) {
+      if (r.kind == FeedRecord::WsFrame) rec.frames.push_back(&r);
+      else if (r.kind == FeedRecord::Snapshot) rec.snapshots.push_back(&r);
+      else if (r.kind == FeedRecord::ExchangeInfo && !rec.exchange_info) rec.exchange_info = &r;
+    }
+  }
+
+  net::io_context ioc(1);
+  tcp::acceptor acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), port));
+  if (st.syn.market)
+    std::cerr << "[standin] " << st.syn.market->size() << " synthetic symbols, seed " << scfg.seed;
+  else
+    std::cerr << "[standin] " << rec.frames.size() << " frames, " << rec.snapshots.size() << " snapshots";
+  std::cerr << " on ws://127.0.0.1:" << port << " and http://127.0.0.1:" << port << "\n";
+  net::co_spawn(ioc, listen(acceptor, st), net::detached);
+
+  net::signal_set signals(ioc, SIGINT, SIGTERM);
+  signals.async_wait([&](const boost::system::error_code &, int) { ioc.stop(); });
+  ioc.run();
+  if (st.syn.market)
+    std::cerr << "[standin] generated " << st.syn.market->generated() << " updates, injected "
+      << st.syn.market->faults() << " faults\n";
+  return 0;
+}
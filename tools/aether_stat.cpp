@@ -0,0 +1,133 @@
+// aether_stat.cpp
+// Reads the stats segment of a running aether process (stats_shm.h) and prints its
+// counters and stage latency percentiles. The segment is mapped read-only; the
+// process being watched does no work for the reader.
+// Usage: aether_stat [PATH] [--watch=SEC] [--json]
+//   --watch=SEC  print every SEC seconds with per-second counter rates, until Ctrl+C
+//   --json       one snapshot as JSON (for scripts and dashboards)
+#include "stats_shm.h"
+
+#include <signal.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using namespace aether;
+using json = nlohmann::json;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static bool process_alive(uint32_t pid) {
+  return pid && (kill(pid_t(pid), 0) == 0 || errno == EPERM);
+}
+
+static void print_table(const stats::StatsSegment &seg, const std::vector<std::vector<uint64_t>> *prev, double secs) {
+  const stats::StatsHeader *h = seg.header();
+  std::printf("pid %u%s, %zu blocks, %.3f ticks/ns\n", h->pid, process_alive(h->pid) ? "" : " (exited)",
+      seg.blocks(), h->ticks_per_ns);
+  for (size_t b = 0; b < seg.blocks(); ++b) {
+    const stats::StatsBlock &blk = seg.block(b);
+    std::printf("[%s]\n ", blk.name);
+    for (uint32_t c = 0; c < stats::COUNTER_COUNT; ++c) {
+      uint64_t v = blk.counter(stats::Counter(c));
+      bool gauge = c == stats::QueueDepth || c == stats::QueueDepthMax;
+      if (!v) continue;
+      std::printf(" %s=%llu", stats::counter_name(stats::Counter(c)), (unsigned long long)v);
+      if (prev && !gauge && secs > 0 && b < prev->size())
+        std::printf(" (%.0f/s)", double(v - (*prev)[b][c]) / secs);
+    }
+    std::printf("\n");
+    for (uint32_t s = 0; s < stats::STAGE_COUNT; ++s) {
+      LatencyHistogram hist;
+      blk.snapshot(stats::Stage(s), hist);
+      if (!hist.count()) continue;
+      std::printf("  %-8s n=%-10llu p50=%-9.0f p99=%-9.0f p99.9=%-9.0f max=%.0f ns\n",
+          stats::stage_name(stats::Stage(s)), (unsigned long long)hist.count(),
+          seg.to_ns(hist.percentile(50)), seg.to_ns(hist.percentile(99)),
+          seg.to_ns(hist.percentile(99.9)), seg.to_ns(hist.max()));
+    }
+  }
+  std::fflush(stdout);
+}
+
+static json to_json(const stats::StatsSegment &seg) {
+  const stats::StatsHeader *h = seg.header();
+  json out;
+  out["pid"] = h->pid;
+  out["alive"] = process_alive(h->pid);
+  out["start_unix_ns"] = h->start_unix_ns;
+  out["blocks"] = json::array();
+  for (size_t b = 0; b < seg.blocks(); ++b) {
+    const stats::StatsBlock &blk = seg.block(b);
+    json jb;
+    jb["name"] = std::string(blk.name);
+    for (uint32_t c = 0; c < stats::COUNTER_COUNT; ++c)
+      jb["counters"][stats::counter_name(stats::Counter(c))] = blk.counter(stats::Counter(c));
+    jb["stages_ns"] = json::object();
+    for (uint32_t s = 0; s < stats::STAGE_COUNT; ++s) {
+      LatencyHistogram hist;
+      blk.snapshot(stats::Stage(s), hist);
+      if (!hist.count()) continue;
+      jb["stages_ns"][stats::stage_name(stats::Stage(s))] = {
+        {"count", hist.count()},
+        {"mean", seg.to_ns(uint64_t(hist.mean()))},
+        {"p50", seg.to_ns(hist.percentile(50))},
+        {"p99", seg.to_ns(hist.percentile(99))},
+        {"p99_9", seg.to_ns(hist.percentile(99.9))},
+        {"max", seg.to_ns(hist.max())},
+      };
+    }
+    out["blocks"].push_back(jb);
+  }
+  return out;
+}
+
+int main(int argc, char **argv) {
+  std::string path = "/dev/shm/aether.stats";
+  double watch = 0;
+  bool as_json = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a.rfind("--watch=", 0) == 0) watch = std::stod(a.substr(8));
+    else if (a == "--json") as_json = true;
+    else if (a.rfind("--", 0) != 0) path = a;
+    else {
+      std::cerr << "usage: " << argv[0] << " [PATH] [--watch=SEC] [--json]\n";
+      return 1;
+    }
+  }
+
+  stats::StatsSegment seg;
+  if (!seg.open(path)) return 1;
+  if (as_json) {
+    std::cout << to_json(seg).dump(2) << "\n";
+    return 0;
+  }
+  if (watch <= 0) {
+    print_table(seg, nullptr, 0);
+    return 0;
+  }
+
+  signal(SIGINT, [](int) { g_stop = 1; });
+  std::vector<std::vector<uint64_t>> prev;
+  auto last = std::chrono::steady_clock::now();
+  while (!g_stop) {
+    auto now = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(now - last).count();
+    print_table(seg, prev.empty() ? nullptr : &prev, secs);
+    std::printf("\n");
+    prev.assign(seg.blocks(), std::vector<uint64_t>(stats::COUNTER_COUNT));
+    for (size_t b = 0; b < seg.blocks(); ++b)
+      for (uint32_t c = 0; c < stats::COUNTER_COUNT; ++c) prev[b][c] = seg.block(b).counter(stats::Counter(c));
+    last = now;
+    std::this_thread::sleep_for(std::chrono::duration<double>(watch));
+  }
+  return 0;
+}
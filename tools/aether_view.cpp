@@ -0,0 +1,83 @@
+// aether_view.cpp
+// Prints the top of book from a book view segment (book_view.h). Reads are seqlock
+// copies from the mapping; the writing process does no work for the reader.
+// Usage: aether_view PATH [--levels=N] [--watch=MS]
+//   --levels=N  levels per side to print (default 5, 0 = BBO only)
+//   --watch=MS  print again whenever the view changed, polling every MS, until Ctrl+C
+#include "book_view.h"
+#include "decimal.h"
+
+#include <signal.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace aether;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void print_view(const view::BookViewHeader &h, const view::DepthSnapshot &s, bool bbo_only) {
+  const view::TopOfBook &t = s.top;
+  std::printf("%s u=%llu E=%llu seq=%llu%s\n", h.symbol, (unsigned long long)t.last_update_id,
+      (unsigned long long)t.event_time_ms, (unsigned long long)t.seq,
+      (t.flags & view::VIEW_SYNCED) ? "" : " (not synced)");
+  if (bbo_only) {
+    std::printf("  bid %.*f : %.*f   ask %.*f : %.*f\n",
+        h.price_decimals, t.has_bid ? ticks_to_double(t.bid.price, h.price_decimals) : 0.0,
+        h.qty_decimals, t.has_bid ? ticks_to_double(t.bid.qty, h.qty_decimals) : 0.0,
+        h.price_decimals, t.has_ask ? ticks_to_double(t.ask.price, h.price_decimals) : 0.0,
+        h.qty_decimals, t.has_ask ? ticks_to_double(t.ask.qty, h.qty_decimals) : 0.0);
+  } else {
+    for (size_t i = s.ask_levels; i-- > 0;)
+      std::printf("  ask %.*f : %.*f\n", h.price_decimals, ticks_to_double(s.asks[i].price, h.price_decimals),
+          h.qty_decimals, ticks_to_double(s.asks[i].qty, h.qty_decimals));
+    for (size_t i = 0; i < s.bid_levels; ++i)
+      std::printf("  bid %.*f : %.*f\n", h.price_decimals, ticks_to_double(s.bids[i].price, h.price_decimals),
+          h.qty_decimals, ticks_to_double(s.bids[i].qty, h.qty_decimals));
+  }
+  std::fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+  std::string path;
+  size_t levels = 5;
+  int watch_ms = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a.rfind("--levels=", 0) == 0) levels = std::stoul(a.substr(9));
+    else if (a.rfind("--watch=", 0) == 0) watch_ms = std::stoi(a.substr(8));
+    else if (a.rfind("--", 0) != 0 && path.empty()) path = a;
+    else {
+      path.clear();
+      break;
+    }
+  }
+  if (path.empty()) {
+    std::cerr << "usage: " << argv[0] << " PATH [--levels=N] [--watch=MS]\n";
+    return 1;
+  }
+
+  view::BookViewReader reader;
+  if (!reader.open(path)) return 1;
+  // a DepthSnapshot holds MAX_DEPTH levels per side: keep it off the stack
+  auto snap = std::make_unique<view::DepthSnapshot>();
+  signal(SIGINT, [](int) { g_stop = 1; });
+  uint64_t last_seq = ~uint64_t(0);
+  do {
+    if (reader.sequence() != last_seq) {
+      bool ok = levels ? reader.read(*snap, levels) : reader.read_top(snap->top);
+      if (!ok) {
+        std::cerr << "[view] writer did not settle (process gone mid-update?)\n";
+        return 1;
+      }
+      last_seq = snap->top.seq;
+      print_view(*reader.header(), *snap, levels == 0);
+    }
+    if (watch_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+  } while (watch_ms > 0 && !g_stop);
+  return 0;
+}
@@ -0,0 +1,122 @@
+// ring_stress.cpp
+// Multi-process torn-read stress for the ring reader API.
+// The parent publishes variable-size frames at full speed into a deliberately small
+// ring while N forked readers consume zero-copy views, verify every payload byte and
+// then validate the view. The producer alternates between publish_message and
+// reserve/commit_deferred/flush batches. A frame that validates but has corrupt bytes is a torn read
+// the API failed to detect; any such frame fails the run.
+// usage: ring_stress [readers=3] [seconds=5] [buf_size=65536]
+
+#include "ring_mmap.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace aether::ring;
+
+static uint8_t pattern(uint64_t seq, size_t i) { return uint8_t(seq * 31 + i * 7); }
+
+static double secs_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static int run_reader(const std::string &path, double seconds, int id) {
+  RingHandle *h = open_ring(path.c_str());
+  if (!h) return 10;
+  int slot = register_reader(h);
+  if (slot < 0) { close_ring(h); return 11; }
+
+  uint64_t good = 0, discarded = 0, torn = 0, laps = 0, reorder = 0, last_seq = 0;
+  bool have_last = false;
+  FrameView views[64];
+  auto t0 = std::chrono::steady_clock::now();
+  while (secs_since(t0) < seconds) {
+    int n = read_batch(h, slot, views, 64);
+    if (n == RING_READ_LAPPED) { ++laps; continue; }
+    if (n == 0) { std::this_thread::yield(); continue; }
+    for (int k = 0; k < n; ++k) {
+      const FrameView &v = views[k];
+      bool ok = v.len >= 8;
+      uint64_t seq = 0;
+      if (ok) {
+        std::memcpy(&seq, v.data, 8);
+        for (size_t i = 8; i < v.len; ++i) {
+          if (v.data[i] != pattern(seq, i)) { ok = false; break; }
+        }
+      }
+      if (!frame_valid(h, v)) { ++discarded; continue; }
+      if (!ok) { ++torn; continue; }
+      if (have_last && seq <= last_seq) ++reorder;
+      last_seq = seq;
+      have_last = true;
+      ++good;
+    }
+  }
+  std::printf("[reader %d] good=%lu discarded=%lu laps=%lu torn_undetected=%lu reordered=%lu\n",
+      id, (unsigned long)good, (unsigned long)discarded, (unsigned long)laps,
+      (unsigned long)torn, (unsigned long)reorder);
+  std::fflush(stdout); // forked child leaves through _exit
+  deregister_reader(h, slot);
+  close_ring(h);
+  return (torn || reorder) ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  int readers = argc >= 2 ? std::atoi(argv[1]) : 3;
+  double seconds = argc >= 3 ? std::atof(argv[2]) : 5.0;
+  size_t buf_size = argc >= 4 ? size_t(std::atoll(argv[3])) : 65536;
+  std::string path = "/dev/shm/aether.ring_stress." + std::to_string(getpid());
+
+  RingHandle *prod = create_ring(path.c_str(), buf_size);
+  if (!prod) return 2;
+
+  std::vector<pid_t> kids;
+  for (int i = 0; i < readers; ++i) {
+    pid_t pid = fork();
+    if (pid == 0) _exit(run_reader(path, seconds, i));
+    if (pid > 0) kids.push_back(pid);
+  }
+
+  // produce flat out for the same window
+  std::vector<uint8_t> payload(4096);
+  uint64_t seq = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  while (secs_since(t0) < seconds) {
+    size_t len = 8 + size_t((seq * 2654435761u) % 2040);
+    if ((seq / 1024) % 2 == 0) {
+      std::memcpy(payload.data(), &seq, 8);
+      for (size_t i = 8; i < len; ++i) payload[i] = pattern(seq, i);
+      publish_message(prod, AETHER_MSG_DEPTH_UPDATE, payload.data(), len);
+    } else {
+      // alternate with in-place encoding and batched (every 8 frames) publishing
+      uint8_t *p = static_cast<uint8_t*>(reserve(prod, len));
+      std::memcpy(p, &seq, 8);
+      for (size_t i = 8; i < len; ++i) p[i] = pattern(seq, i);
+      commit_deferred(prod, AETHER_MSG_DEPTH_UPDATE, len);
+      if (seq % 8 == 7) flush(prod);
+    }
+    ++seq;
+  }
+  double el = secs_since(t0);
+  std::printf("[producer] %lu frames in %.2fs (%.0f frames/s)\n", (unsigned long)seq, el, double(seq) / el);
+
+  int failed = 0;
+  for (pid_t pid : kids) {
+    int st = 0;
+    waitpid(pid, &st, 0);
+    if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) ++failed;
+  }
+  close_ring(prod);
+  unlink(path.c_str());
+  std::printf("%s (%d/%zu readers failed)\n", failed ? "FAIL" : "PASS", failed, kids.size());
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,300 @@
+// synthetic_market.cpp
+#include "synthetic_market.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <iterator>
+
+namespace aether {
+
+  bool parse_fault(std::string_view s, Fault &out) {
+    if (s == "gap") out = Fault::Gap;
+    else if (s == "dup") out = Fault::Duplicate;
+    else if (s == "reorder") out = Fault::Reorder;
+    else return false;
+    return true;
+  }
+
+  static int64_t pow10(int n) {
+    int64_t v = 1;
+    while (n-- > 0) v *= 10;
+    return v;
+  }
+
+  // v scaled by 10^decimals, printed with 8 decimals like the exchange does
+  static void append_decimal(std::string &out, int64_t v, int decimals) {
+    char buf[24];
+    int64_t unit = pow10(decimals);
+    auto r = std::to_chars(buf, buf + sizeof(buf), v / unit);
+    out.append(buf, r.ptr);
+    out += '.';
+    if (decimals) {
+      r = std::to_chars(buf, buf + sizeof(buf), v % unit);
+      out.append(size_t(decimals - (r.ptr - buf)), '0');
+      out.append(buf, r.ptr);
+    }
+    out.append(size_t(8 - decimals), '0');
+  }
+
+  static void append_uint(std::string &out, uint64_t v) {
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+  }
+
+  template <class It>
+  static void append_levels(std::string &out, It first, It last, int price_decimals, int qty_decimals) {
+    out += '[';
+    for (It it = first; it != last; ++it) {
+      if (it != first) out += ',';
+      out += "[\"";
+      append_decimal(out, it->first, price_decimals);
+      out += "\",\"";
+      append_decimal(out, it->second, qty_decimals);
+      out += "\"]";
+    }
+    out += ']';
+  }
+
+  static void append_levels(std::string &out, const std::vector<Level> &levels, int price_decimals,
+      int qty_decimals) {
+    out += '[';
+    for (size_t i = 0; i < levels.size(); ++i) {
+      if (i) out += ',';
+      out += "[\"";
+      append_decimal(out, levels[i].price, price_decimals);
+      out += "\",\"";
+      append_decimal(out, levels[i].qty, qty_decimals);
+      out += "\"]";
+    }
+    out += ']';
+  }
+
+  SyntheticMarket::SyntheticMarket(const SyntheticConfig &cfg, const std::vector<std::string> &symbols)
+    : cfg_(cfg) {
+    cfg_.price_decimals = std::clamp(cfg_.price_decimals, 0, 8);
+    cfg_.qty_decimals = std::clamp(cfg_.qty_decimals, 0, 8);
+    if (cfg_.book_levels == 0) cfg_.book_levels = 1;
+    cfg_.start_price = std::max<int64_t>(cfg_.start_price, 4 * int64_t(cfg_.book_levels));
+    syms_.resize(symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+      Symbol &s = syms_[i];
+      for (char c : symbols[i]) {
+        s.name += char(std::toupper((unsigned char)c));
+        s.stream += char(std::tolower((unsigned char)c));
+      }
+      s.stream += "@depth";
+      s.rng.seed(cfg_.seed * 0x9e3779b97f4a7c15ull + i);
+      s.mid = cfg_.start_price;
+      s.last_id = 1000000;
+      std::uniform_int_distribution<SizeT> qty(1, 5 * pow10(cfg_.qty_decimals));
+      for (int64_t k = 1; k <= int64_t(cfg_.book_levels); ++k) {
+        s.bids[s.mid - k] = qty(s.rng);
+        s.asks[s.mid + k] = qty(s.rng);
+      }
+    }
+    bids_.reserve(cfg_.levels_per_msg + 4);
+    asks_.reserve(cfg_.levels_per_msg + 4);
+  }
+
+  int SyntheticMarket::find(std::string_view symbol) const {
+    for (size_t i = 0; i < syms_.size(); ++i) {
+      const std::string &n = syms_[i].name;
+      if (n.size() == symbol.size() && std::equal(n.begin(), n.end(), symbol.begin(),
+            [](char a, char b) { return a == std::toupper((unsigned char)b); }))
+        return int(i);
+    }
+    return -1;
+  }
+
+  // dir -1: bids below the mid, +1: asks above it
+  template <class Book>
+  void SyntheticMarket::change(Symbol &s, Book &book, std::vector<Level> &out, int dir) {
+    out.clear();
+    // levels the mid moved onto
+    while (!book.empty() && (dir < 0 ? book.begin()->first >= s.mid : book.begin()->first <= s.mid)) {
+      out.push_back(Level{book.begin()->first, 0});
+      book.erase(book.begin());
+    }
+    // levels the mid moved away from
+    const int64_t range = 2 * int64_t(cfg_.book_levels);
+    while (!book.empty() && std::abs(std::prev(book.end())->first - s.mid) > range) {
+      out.push_back(Level{std::prev(book.end())->first, 0});
+      book.erase(std::prev(book.end()));
+    }
+    std::geometric_distribution<int64_t> offset(1.0 / (1.0 + cfg_.book_levels / 20.0));
+    std::uniform_int_distribution<SizeT> qty(1, 5 * pow10(cfg_.qty_decimals));
+    for (uint32_t n = 0; n < cfg_.levels_per_msg; ++n) {
+      PriceT p = s.mid + dir * (1 + std::min<int64_t>(offset(s.rng), cfg_.book_levels - 1));
+      if (std::any_of(out.begin(), out.end(), [p](const Level &l) { return l.price == p; })) continue;
+      // a quarter of the changes remove a level, never the last one of the side
+      if (s.rng() % 4 == 0 && book.size() > 1) {
+        if (!book.erase(p)) continue;
+        out.push_back(Level{p, 0});
+      } else {
+        SizeT q = qty(s.rng);
+        book[p] = q;
+        out.push_back(Level{p, q});
+      }
+    }
+  }
+
+  void SyntheticMarket::encode(const Symbol &s, uint64_t first, uint64_t last, uint64_t event_ms,
+      std::string &out) const {
+    out.clear();
+    out += "{\"e\":\"depthUpdate\",\"E\":";
+    append_uint(out, event_ms);
+    out += ",\"s\":\"";
+    out += s.name;
+    out += "\",\"U\":";
+    append_uint(out, first);
+    out += ",\"u\":";
+    append_uint(out, last);
+    out += ",\"b\":";
+    append_levels(out, bids_, cfg_.price_decimals, cfg_.qty_decimals);
+    out += ",\"a\":";
+    append_levels(out, asks_, cfg_.price_decimals, cfg_.qty_decimals);
+    out += '}';
+  }
+
+  bool SyntheticMarket::due(Symbol &s, Fault f, uint64_t every) {
+    uint32_t &pending = s.pending[int(f)];
+    bool hit = pending > 0 || (every && s.frames % every == 0);
+    if (pending) --pending;
+    if (hit) ++faults_;
+    return hit;
+  }
+
+  void SyntheticMarket::generate(Symbol &s, uint64_t event_ms, Update &u) {
+    u.n = 0;
+    uint64_t r = s.rng() % 8;
+    if (r == 0 && s.mid > 4 * int64_t(cfg_.book_levels)) --s.mid;
+    else if (r == 1) ++s.mid;
+    change(s, s.bids, bids_, -1);
+    change(s, s.asks, asks_, +1);
+    uint64_t first = s.last_id + 1;
+    s.last_id += 1 + s.rng() % 3;
+    ++s.frames;
+    ++generated_;
+
+    if (s.holding) {
+      // the frame after a held one goes first
+      encode(s, first, s.last_id, event_ms, u.frames[0]);
+      u.frames[1].swap(s.held);
+      s.holding = false;
+      u.n = 2;
+      return;
+    }
+    if (due(s, Fault::Gap, cfg_.gap_every)) return;
+    encode(s, first, s.last_id, event_ms, u.frames[0]);
+    if (due(s, Fault::Reorder, cfg_.reorder_every)) {
+      s.held.swap(u.frames[0]);
+      s.holding = true;
+      return;
+    }
+    if (due(s, Fault::Duplicate, cfg_.dup_every)) {
+      u.frames[1] = u.frames[0];
+      u.n = 2;
+      return;
+    }
+    u.n = 1;
+  }
+
+  int SyntheticMarket::attach() {
+    size_t r = 0;
+    while (r < attached_.size() && attached_[r]) ++r;
+    if (r == attached_.size()) {
+      attached_.push_back(false);
+      readers_.emplace_back();
+    }
+    attached_[r] = true;
+    readers_[r].resize(syms_.size());
+    for (size_t i = 0; i < syms_.size(); ++i) readers_[r][i] = syms_[i].first + syms_[i].backlog.size();
+    return int(r);
+  }
+
+  void SyntheticMarket::detach(int reader) {
+    attached_[size_t(reader)] = false;
+    for (size_t i = 0; i < syms_.size(); ++i) trim(i);
+  }
+
+  void SyntheticMarket::trim(size_t i) {
+    Symbol &s = syms_[i];
+    uint64_t end = s.first + s.backlog.size();
+    uint64_t keep = end;
+    for (size_t r = 0; r < readers_.size(); ++r)
+      if (attached_[r]) keep = std::min(keep, readers_[r][i]);
+    keep = std::max(keep, end - std::min<uint64_t>(end, MAX_BACKLOG));
+    while (s.first < keep) {
+      s.backlog.pop_front();
+      ++s.first;
+    }
+    // readers behind what is left have lost updates: they carry on with the oldest kept
+    for (size_t r = 0; r < readers_.size(); ++r)
+      if (attached_[r] && readers_[r][i] < s.first) readers_[r][i] = s.first;
+  }
+
+  size_t SyntheticMarket::next(int reader, size_t i, uint64_t event_ms, bool combined) {
+    Symbol &s = syms_[i];
+    uint64_t &pos = readers_[size_t(reader)][i];
+    if (pos == s.first + s.backlog.size()) {
+      s.backlog.emplace_back();
+      generate(s, event_ms, s.backlog.back());
+    }
+    const Update &u = s.backlog[pos - s.first];
+    ++pos;
+    for (size_t k = 0; k < u.n; ++k) {
+      out_[k].clear();
+      if (combined) {
+        out_[k] += "{\"stream\":\"";
+        out_[k] += s.stream;
+        out_[k] += "\",\"data\":";
+      }
+      out_[k] += u.frames[k];
+      if (combined) out_[k] += '}';
+    }
+    size_t n = u.n;
+    trim(i);
+    return n;
+  }
+
+  void SyntheticMarket::inject(Fault f, int i) {
+    for (size_t k = 0; k < syms_.size(); ++k)
+      if (i < 0 || size_t(i) == k) ++syms_[k].pending[int(f)];
+  }
+
+  std::string SyntheticMarket::snapshot(size_t i, size_t limit) const {
+    const Symbol &s = syms_[i];
+    std::string out = "{\"lastUpdateId\":";
+    append_uint(out, s.last_id);
+    out += ",\"bids\":";
+    append_levels(out, s.bids.begin(), std::next(s.bids.begin(), std::min(limit, s.bids.size())),
+        cfg_.price_decimals, cfg_.qty_decimals);
+    out += ",\"asks\":";
+    append_levels(out, s.asks.begin(), std::next(s.asks.begin(), std::min(limit, s.asks.size())),
+        cfg_.price_decimals, cfg_.qty_decimals);
+    out += '}';
+    return out;
+  }
+
+  std::string SyntheticMarket::exchange_info(int i) const {
+    std::string out = "{\"symbols\":[";
+    bool first = true;
+    for (size_t k = 0; k < syms_.size(); ++k) {
+      if (i >= 0 && size_t(i) != k) continue;
+      if (!first) out += ',';
+      first = false;
+      out += "{\"symbol\":\"" + syms_[k].name + "\",\"status\":\"TRADING\",\"filters\":["
+        "{\"filterType\":\"PRICE_FILTER\",\"tickSize\":\"";
+      append_decimal(out, 1, cfg_.price_decimals);
+      out += "\"},{\"filterType\":\"LOT_SIZE\",\"stepSize\":\"";
+      append_decimal(out, 1, cfg_.qty_decimals);
+      out += "\"}]}";
+    }
+    out += "]}";
+    return out;
+  }
+
+} // namespace aether
@@ -0,0 +1,128 @@
+#pragma once
+// synthetic_market.h
+// Seeded random-walk order books speaking Binance's depth protocol, for offline load
+// and resync testing (aether_standin --synthetic). Every symbol keeps a true book. An
+// update moves the mid by at most one tick, removes the levels the move crossed and
+// changes levels_per_msg random levels per side, weighted toward the touch. Snapshots
+// are the true book at the last generated update id, so a client that resyncs after an
+// injected fault converges on it again.
+//
+// Faults act on the stream only, never on the true book: a gap generates an update and
+// drops it, a duplicate sends a frame twice, a reorder holds a frame back and sends it
+// after the next one (which the client sees as a gap, then a stale frame).
+//
+// Every client reads a symbol's updates through its own reader position, so clients on
+// the same symbol all get the same stream, faults included. An update is generated when
+// the first reader asks for it and kept until the last one has read it. A reader more
+// than MAX_BACKLOG updates behind loses the oldest ones and sees a gap.
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "book_types.h"
+
+namespace aether {
+
+  enum class Fault { Gap, Duplicate, Reorder };
+
+  // "gap", "dup", "reorder" (false for anything else)
+  bool parse_fault(std::string_view s, Fault &out);
+
+  struct SyntheticConfig {
+    uint64_t seed = 1;
+    int64_t start_price = 5000000;     // in ticks (50000.00 at 2 price decimals)
+    int price_decimals = 2;            // tickSize 10^-price_decimals
+    int qty_decimals = 5;              // stepSize 10^-qty_decimals
+    uint32_t levels_per_msg = 10;      // level changes per side per update
+    uint32_t book_levels = 1000;       // levels per side around the mid
+    // every N-th generated frame of a symbol (0 = never)
+    uint64_t gap_every = 0;
+    uint64_t dup_every = 0;
+    uint64_t reorder_every = 0;
+  };
+
+  class SyntheticMarket {
+    public:
+      // symbols are upper-cased; each gets its own generator seeded from cfg.seed
+      SyntheticMarket(const SyntheticConfig &cfg, const std::vector<std::string> &symbols);
+
+      static constexpr size_t MAX_BACKLOG = 1 << 16;
+
+      size_t size() const noexcept { return syms_.size(); }
+      const std::string &symbol(size_t i) const { return syms_[i].name; }
+      // case-insensitive; -1 if not simulated
+      int find(std::string_view symbol) const;
+
+      // new reader, at the current end of every symbol's stream; detach() releases it
+      int attach();
+      void detach(int reader);
+
+      // Reader's next update of symbol i, generated if no reader got this far yet.
+      // Returns how many frames to send now (0-2, see frame()): none for a gap or a
+      // held-back frame, two for a duplicate or when a held frame is released. combined
+      // wraps each frame as a combined-stream message.
+      size_t next(int reader, size_t i, uint64_t event_ms, bool combined);
+      // k-th frame of the last next(); valid until the next call
+      const std::string &frame(size_t k) const { return out_[k]; }
+
+      // apply f to the next frame of symbol i (i < 0: of every symbol)
+      void inject(Fault f, int i = -1);
+
+      // REST depth body: the best `limit` levels per side at the last generated id
+      std::string snapshot(size_t i, size_t limit) const;
+      // exchangeInfo body with the price and lot filters of symbol i (i < 0: all)
+      std::string exchange_info(int i = -1) const;
+
+      uint64_t generated() const noexcept { return generated_; }
+      uint64_t faults() const noexcept { return faults_; }
+
+    private:
+      // frames of one generated update, unwrapped
+      struct Update {
+        std::string frames[2];
+        size_t n = 0;
+      };
+
+      struct Symbol {
+        std::string name;              // BTCUSDT
+        std::string stream;            // btcusdt@depth
+        std::mt19937_64 rng;
+        int64_t mid = 0;               // bids < mid < asks
+        std::map<PriceT, SizeT, std::greater<PriceT>> bids;
+        std::map<PriceT, SizeT> asks;
+        uint64_t last_id = 0;
+        uint64_t frames = 0;
+        uint32_t pending[3] = {0, 0, 0}; // injected faults by Fault
+        std::string held;              // frame held back by a reorder
+        bool holding = false;
+        // generated updates not yet read by every reader; update n is backlog[n - first]
+        std::deque<Update> backlog;
+        uint64_t first = 0;
+      };
+
+      template <class Book>
+      void change(Symbol &s, Book &book, std::vector<Level> &out, int dir);
+      void encode(const Symbol &s, uint64_t first, uint64_t last, uint64_t event_ms, std::string &out) const;
+      bool due(Symbol &s, Fault f, uint64_t every);
+      // generate the next update of s into u
+      void generate(Symbol &s, uint64_t event_ms, Update &u);
+      // drop updates every reader has read, and the oldest past MAX_BACKLOG
+      void trim(size_t i);
+
+      SyntheticConfig cfg_;
+      std::vector<Symbol> syms_;
+      std::vector<Level> bids_, asks_;  // levels of the update being built
+      std::vector<std::vector<uint64_t>> readers_; // per reader: next update of each symbol
+      std::vector<bool> attached_;
+      std::string out_[2];
+      uint64_t generated_ = 0;
+      uint64_t faults_ = 0;
+  };
+
+} // namespace aether